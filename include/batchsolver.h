@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include "board.h"
+#include "solvestats.h"
+
+class SolutionCache;
+class SolutionStore;
+class UnitTable;
+
+// Search used for boards the cache and store cannot answer
+enum class SolverEngine : std::uint8_t {
+    Backtracking,  // SudokuSolver, allocation-free
+    Cdcl,          // SatSudokuSolver, clause learning for adversarial boards
+    Portfolio      // PortfolioSolver: the engines above and MRV raced per board
+};
+
+struct BatchOptions {
+    // Boards whose givens are loaded together, in structure-of-arrays
+    // layout so the per-cell checks run across the chunk in one loop
+    std::size_t chunkSize = 16;
+
+    // Optional shared cache consulted before searching; results of the
+    // searches are added to it. Not owned.
+    SolutionCache* cache = nullptr;
+
+    // Optional persistent store consulted after the cache; new results are
+    // appended to it. Not owned.
+    SolutionStore* store = nullptr;
+
+    // Applied to each board's search on its own; timed-out or cancelled
+    // boards get SolveStatus::TimedOut or Cancelled and are not cached or
+    // stored
+    SolveLimits limits;
+
+    // Variant rules; null for classic Sudoku. The cache and the store only
+    // know classic symmetries, so they are skipped for other tables, as is
+    // the structure-of-arrays loading. Not owned.
+    const UnitTable* units = nullptr;
+
+    SolverEngine engine = SolverEngine::Backtracking;
+};
+
+// Largest chunk handled in one pass; bigger chunkSize values are capped
+constexpr std::size_t kMaxBatchChunk = 16;
+
+// Solves puzzles[i] into solutions[i] for every i (both spans must have
+// the same size). Unsolvable boards leave their solution untouched. When
+// given, status[i] and stats[i] receive each board's outcome and counters.
+// Buffers are reused across the batch, so no heap allocation is made
+// (apart from cache insertions when a cache is given, the clauses the
+// Cdcl engine learns, and the Portfolio engine's threads on first use).
+// Returns the number of boards solved.
+std::size_t solveBatch(std::span<const Board> puzzles, std::span<Board> solutions,
+                       const BatchOptions& options = BatchOptions(),
+                       std::span<SolveStatus> status = {},
+                       std::span<SolveStats> stats = {});
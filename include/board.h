@@ -0,0 +1,23 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Flat 9x9 board, row-major, 0 for an empty cell
+using Board = std::array<std::uint8_t, 81>;
+
+// Parse an 81-character puzzle ('0' or '.' for empty cells)
+bool parseBoard(std::string_view text, Board& board);
+std::string formatBoard(const Board& board);
+
+// Two cells per byte, low nibble first: the wire and disk form of a board
+constexpr std::size_t kPackedBoardSize = 41;
+void packBoard(const Board& board, std::uint8_t* out);
+// Cells are copied as stored; nibbles above 9 are left for the solver to reject
+void unpackBoard(const std::uint8_t* in, Board& board);
+
+Board boardFromGrid(const std::vector<std::vector<int>>& grid);
+std::vector<std::vector<int>> gridFromBoard(const Board& board);
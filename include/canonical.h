@@ -0,0 +1,32 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include "board.h"
+
+// One symmetry of the Sudoku grid: an optional transpose, then a row and a
+// column permutation that keep bands and stacks together, then a digit
+// relabelling. Every such transform maps valid puzzles to valid puzzles.
+struct BoardTransform {
+    bool transposed = false;
+    std::array<std::uint8_t, 9> rows{};      // Result row r is source row rows[r]
+    std::array<std::uint8_t, 9> cols{};      // Result column c is source column cols[c]
+    std::array<std::uint8_t, 10> relabel{};  // Source digit -> result digit, 0 stays 0
+
+    Board apply(const Board& board) const;
+    // Maps a board in the transformed frame (e.g. a cached solution) back
+    Board invert(const Board& transformed) const;
+};
+
+struct CanonicalBoard {
+    Board board{};
+    BoardTransform transform;  // board == transform.apply(original)
+};
+
+// Lexicographically smallest board reachable from this one under the
+// 2 * 6^8 row/column symmetries, with digits numbered in order of first
+// appearance. Equivalent puzzles share the same canonical board.
+CanonicalBoard canonicalize(const Board& board);
+
+// 64-bit ID of a canonical board. Equivalent puzzles share an ID, so it
+// can stand in for the 81-cell canonical form when deduplicating.
+std::uint64_t canonicalId(const Board& canonical);
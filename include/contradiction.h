@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+#include "board.h"
+#include "unittable.h"
+
+enum class ContradictionKind : std::uint8_t {
+    None,
+    Clash,           // A digit is forced into a cell whose peer already holds it
+    NoCandidates,    // An empty cell has no digit left
+    NoPlaceForDigit  // A unit has no cell left for one of its digits
+};
+
+struct Contradiction {
+    ContradictionKind kind = ContradictionKind::None;
+    int cell = -1;   // Clash and NoCandidates
+    int unit = -1;   // NoPlaceForDigit: index into the UnitTable
+    int digit = 0;   // Clash and NoPlaceForDigit
+
+    explicit operator bool() const { return kind != ContradictionKind::None; }
+};
+
+// Cheap proof that a board has no solution. Propagates naked and hidden
+// singles from the givens on a copy of the board until nothing changes and
+// reports the first dead end found: a clash, a cell with no candidates or
+// a digit with no place in some row, column or box. Takes a few
+// microseconds and no search, so it catches most unsolvable boards before
+// backtracking starts; a None result does not prove the board solvable.
+Contradiction findContradiction(const Board& board, const UnitTable& units = UnitTable::classic());
+
+// The same propagation, writing the board with every single placed into
+// filled when it finds no dead end. It has the same solutions as board,
+// so a search can start from it instead.
+Contradiction placeSingles(const Board& board, Board& filled, const UnitTable& units = UnitTable::classic());
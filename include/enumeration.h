@@ -0,0 +1,104 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+#include "board.h"
+#include "solvestats.h"
+#include "unittable.h"
+
+class TranspositionTable;
+
+// Solution streams hold every solution of a run of puzzles. After the
+// 8-byte magic each solution is one record: a byte counting the leading
+// cells it shares with the record before it, then its other cells two to
+// a byte, low nibble first. The search fills cells in row-major order and
+// changes the last ones first, so consecutive solutions share long
+// prefixes and most records take a few bytes instead of 41. A
+// kEndOfPuzzle byte closes each puzzle's solutions.
+constexpr char kSolutionStreamMagic[8] = {'S', 'U', 'D', 'K', 'S', 'O', 'L', '1'};
+constexpr std::uint8_t kEndOfPuzzle = 0xFF;
+
+// Appends records for solutions to a byte buffer
+class SolutionEncoder {
+public:
+    void add(const Board& solution);
+
+    // Empties the buffer; the next record shares nothing with the last, so
+    // every buffer taken between clears decodes on its own
+    void clear() {
+        bytes.clear();
+        hasPrevious = false;
+    }
+
+    std::span<const std::uint8_t> data() const {
+        return bytes;
+    }
+
+    std::size_t size() const {
+        return bytes.size();
+    }
+
+private:
+    std::vector<std::uint8_t> bytes;
+    Board previous{};
+    bool hasPrevious = false;
+};
+
+// Solution stream file. write() takes buffers from several threads at
+// once, each landing whole, so records from different encoders never
+// interleave.
+class SolutionWriter {
+public:
+    explicit SolutionWriter(const std::string& path);
+    ~SolutionWriter();
+    SolutionWriter(const SolutionWriter&) = delete;
+    SolutionWriter& operator=(const SolutionWriter&) = delete;
+
+    bool isOpen() const { return file != nullptr; }
+    bool write(std::span<const std::uint8_t> records);
+    // Closes the current puzzle's solutions
+    bool endPuzzle();
+    bool close();
+
+private:
+    std::FILE* file;
+    std::mutex mutex;
+    bool failed = false;
+};
+
+// Streams the solutions in a solution stream file to onSolution with the
+// index of their puzzle; false if the file cannot be read or is malformed
+bool readSolutionFile(const std::string& path,
+                      const std::function<void(std::size_t puzzle, const Board& solution)>& onSolution);
+
+struct EnumerateOptions {
+    // Threads searching subtrees side by side; 0 for one per hardware
+    // thread. With one, solutions come in search order.
+    std::size_t threads = 1;
+    std::uint64_t maxCount = 0;  // Stop after this many solutions; 0 for all
+    SolveLimits limits;          // For the whole enumeration
+    const UnitTable* units = nullptr;                // Null for classic; not owned
+    TranspositionTable* transpositions = nullptr;    // Optional, shared; not owned
+    std::size_t blockSize = std::size_t{1} << 16;    // Bytes each thread encodes per block
+};
+
+// Receives encoded solutions in self-contained blocks, one at a time even
+// when several threads search; returning false stops the enumeration
+using SolutionBlockCallback = std::function<bool(std::span<const std::uint8_t> block)>;
+
+// Finds every solution of board and streams it, encoded, to onBlock, so no
+// more than a block per thread is held at once. The search is split into
+// subtrees by filling the first empty cells every possible way; the
+// threads take subtrees in turn, so a block holds solutions of one thread
+// in its search order. count receives the number of solutions streamed,
+// and stats the searches' counters summed. Solved once every solution or
+// maxCount of them have been streamed, Unsolvable when there are none,
+// TimedOut or Cancelled (including by onBlock) with those streamed so far.
+SolveStatus enumerateSolutions(const Board& board, const EnumerateOptions& options,
+                               const SolutionBlockCallback& onBlock, std::uint64_t& count,
+                               SolveStats* stats = nullptr);
@@ -0,0 +1,84 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "board.h"
+#include "unittable.h"
+
+// Logical techniques, easiest first
+enum class HintTechnique : std::uint8_t {
+    None,
+    NakedSingle,       // A cell has one candidate left
+    HiddenSingle,      // A digit has one place left in a unit
+    LockedCandidates,  // A digit's places in one unit all lie in another
+    NakedSubset,       // N cells of a unit have only N digits between them
+    HiddenSubset,      // N digits of a unit have only N cells between them
+    XWing              // A digit's places in two rows lie in the same two
+                       // columns, or in two columns in the same two rows
+};
+
+struct HintElimination {
+    std::uint8_t cell;
+    std::uint16_t digits;  // Bit d-1 for digit d
+};
+
+// One deduction and why it holds
+struct Hint {
+    HintTechnique technique = HintTechnique::None;
+    int cell = -1;             // Singles: the cell to fill
+    int digit = 0;             // Singles: its digit
+    std::uint16_t digits = 0;  // The digits the pattern is about
+    int unit = -1;             // Unit the pattern was found in
+    int otherUnit = -1;        // LockedCandidates: the unit that loses the digit
+    std::vector<HintElimination> eliminations;
+    std::vector<std::uint8_t> reasons;  // Cells that justify the step
+
+    explicit operator bool() const { return technique != HintTechnique::None; }
+};
+
+// Finds the easiest logical step on a board: naked and hidden singles,
+// then locked candidates, naked and hidden subsets of two to four, then
+// X-Wing. Candidates come from the filled cells through the UnitTable's
+// peer lists, as in the solver's propagation, so a step takes microseconds
+// and no search.
+//
+// Eliminations reported by earlier steps are remembered, so repeated calls
+// walk through a solution path one step at a time; they are forgotten when
+// a filled cell is cleared or changed.
+class HintFinder {
+public:
+    // Rules to reason with, classic unless set; the table must outlive the
+    // finder
+    void setUnits(const UnitTable& table) {
+        units = &table;
+        reset();
+    }
+
+    // Forgets the eliminations of earlier steps
+    void reset() {
+        removed.fill(0);
+        lastBoard.fill(0);
+    }
+
+    // None when the board breaks a rule, has no candidate left somewhere or
+    // needs a technique beyond these
+    Hint next(const Board& board);
+
+private:
+    bool loadCandidates(const Board& board);
+    bool findNakedSingle(Hint& hint) const;
+    bool findHiddenSingle(Hint& hint) const;
+    bool findLockedCandidates(Hint& hint) const;
+    bool findSubset(int size, bool hidden, Hint& hint) const;
+    bool findXWing(Hint& hint) const;
+
+    // Filled peers holding the digit, one per cell that would otherwise
+    // be a place for it
+    void addBlockers(int cell, int digit, Hint& hint) const;
+
+    const UnitTable* units = &UnitTable::classic();  // Not owned
+    Board board{};
+    Board lastBoard{};
+    std::array<std::uint16_t, 81> candidates{};
+    std::array<std::uint16_t, 81> removed{};  // Eliminated by earlier steps
+};
@@ -0,0 +1,80 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "board.h"
+#include "solvestats.h"
+#include "unittable.h"
+
+// A Killer cage: its cells hold different digits adding up to sum
+struct Cage {
+    std::vector<std::uint8_t> cells;  // Row-major cell indices
+    int sum = 0;
+};
+
+struct KillerPuzzle {
+    Board givens{};  // Usually empty in a Killer
+    std::vector<Cage> cages;
+};
+
+// One line per puzzle: "<givens> <cage map> <sums>". The givens are 81
+// characters as in SDM; the map names each cell's cage with one of 0-9,
+// A-Z, a-z ('.' for a cell in no cage); the sums are comma-separated in
+// the order the cages first appear in the map.
+bool parseKiller(std::string_view text, KillerPuzzle& puzzle);
+std::string formatKiller(const KillerPuzzle& puzzle);
+
+// Solver for Sudoku with Killer cages. Cages narrow the candidates of
+// their cells to the digits of the combinations that can still make their
+// sum, looked up in a table built at compile time. The cells of a unit
+// not covered by cages lying wholly inside it are treated as one more cage
+// summing to what the rest of the unit leaves of 45. The search branches
+// on the cell with the fewest candidates left after propagation.
+class KillerSolver {
+public:
+    // Malformed cages (empty, over 9 cells, cells out of range, repeated or
+    // in two cages) and clashing givens make the puzzle Unsolvable
+    SolveStatus solve(const KillerPuzzle& puzzle, Board& solution, const SolveLimits& limits = SolveLimits());
+
+    // Rules under the cages, classic unless set (Killer X, for one, adds
+    // the diagonals); the table must outlive the solver
+    void setUnits(const UnitTable& table) {
+        units = &table;
+    }
+
+    // Counters and timings from the most recent solve()
+    const SolveStats& getStats() const {
+        return stats;
+    }
+
+private:
+    static constexpr int kMaxPeers = UnitTable::kMaxPeers + 8;  // Unit peers and cage mates
+
+    // Candidates and placed digits; the search copies one per level
+    struct State {
+        std::array<std::uint16_t, 81> candidates;
+        Board cells;
+    };
+
+    bool load(const KillerPuzzle& puzzle);
+    bool assign(State& state, int cell, int num);
+    bool propagate(State& state);
+    bool restrictCage(State& state, int cage, bool& changed);
+    bool search(int depth);
+
+    const UnitTable* units = &UnitTable::classic();  // Not owned
+    std::vector<Cage> cages;  // The puzzle's, then those the rule of 45 derives
+    std::array<std::uint8_t, 81> cageOf{};
+    std::array<std::array<std::uint8_t, kMaxPeers>, 81> peers{};
+    std::array<std::uint8_t, 81> peerCount{};
+    std::vector<State> states;  // One per search level, kept across solves
+    Board solved{};
+
+    SolveLimits::Clock::time_point deadline;
+    std::stop_token stop;
+    std::uint64_t nodeLimit = 0;
+    bool timedOut = false;
+    SolveStats stats;
+};
@@ -4,8 +4,10 @@
 #include <QVBoxLayout>
 #include <QLabel>
 #include <QSettings>
+#include <QComboBox>
 #include "sudokugrid.h"
 #include "solver.h"
+#include "contradiction.h"
 #include <QTime>
 
 class MainWindow : public QMainWindow {
@@ -26,6 +28,7 @@ private slots:
     void loadGrid();
     void toggleFullscreen();
     void showStats();
+    void playNextTraceEvent();
 
 private:
     void createMenus();
@@ -38,6 +41,11 @@ private:
     void applyTheme(bool isDark);
     void updateStats();
     void updateButtonStyle(QPushButton* button);
+    void stopPlayback();
+    QString formatDuration(std::int64_t ns) const;
+    QString unitName(int unit) const;
+    QString describeContradiction(const Contradiction& contradiction) const;
+    QString describeHint(const Hint& hint) const;
     
     SudokuGrid *gridWidget;
     QPushButton *solveButton;
@@ -56,8 +64,14 @@ private:
     bool isDarkTheme;
     int puzzlesSolved;
     int bestTime;
-    QTime solveStartTime;
+    bool hasSolveStats;
     int mistakes;
     int score;
     QTimer *gameTimer;
+    QComboBox *replayBox;
+    QTimer *playbackTimer;
+    SolveTrace solveTrace;
+    std::size_t playbackIndex;
+    std::vector<std::vector<int>> playbackPuzzle;
+    std::vector<std::vector<int>> playbackSolution;
 }; 
\ No newline at end of file
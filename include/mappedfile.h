@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Memory mapping of a whole file. view() points straight at the mapped
+// pages, so parsers can read records without copying them. A writable
+// mapping is shared with the file: stores land in the file itself.
+class MappedFile {
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Returns false if the file cannot be opened or mapped
+    bool open(const std::string& path);
+    // Creates the file if needed, resizes it to size bytes (new bytes read
+    // as zero) and maps it for reading and writing
+    bool openWritable(const std::string& path, std::size_t size);
+    void close();
+
+    bool isOpen() const { return opened; }
+    std::string_view view() const { return std::string_view(data, length); }
+    std::size_t size() const { return length; }
+    // Null unless opened with openWritable()
+    char* writableData() const { return writable ? const_cast<char*>(data) : nullptr; }
+    // Writes modified pages of a writable mapping back to the file
+    bool flush(std::size_t offset = 0, std::size_t count = static_cast<std::size_t>(-1));
+
+private:
+    const char* data = nullptr;
+    bool writable = false;
+    std::size_t length = 0;
+    bool opened = false;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+};
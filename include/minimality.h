@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "board.h"
+#include "solvestats.h"
+#include "unittable.h"
+
+class ThreadPool;
+class TranspositionTable;
+
+// A puzzle is minimal when it has one solution and removing any clue gives
+// it more. Each clue is tested by clearing it and looking for a solution
+// with another digit there.
+struct MinimalityOptions {
+    // Runs the clue tests side by side; null runs them on the calling
+    // thread. Not owned.
+    ThreadPool* pool = nullptr;
+    // For the whole call: the time limits span every test, maxNodes bounds
+    // each test on its own
+    SolveLimits limits;
+    const UnitTable* units = nullptr;  // Null for classic; not owned
+    // Dead ends found by one test are skipped by the others, which search
+    // nearly the same boards. A table kept across calls (it must stay with
+    // the same rules) also serves later puzzles; null uses one per call.
+    // Not owned.
+    TranspositionTable* transpositions = nullptr;
+};
+
+struct MinimalityReport {
+    std::uint64_t solutions = 0;  // 0, 1, or 2 for more than one
+    // Clues that can go with the solution staying unique, by cell; only
+    // looked for when there is one solution
+    std::vector<int> redundant;
+
+    bool minimal() const {
+        return solutions == 1 && redundant.empty();
+    }
+};
+
+// Finds every redundant clue of puzzle. Unsolvable when there is no
+// solution; TimedOut or Cancelled when a test was cut short, leaving the
+// report incomplete.
+SolveStatus checkMinimality(const Board& puzzle, const MinimalityOptions& options, MinimalityReport& report,
+                            SolveStats* stats = nullptr);
+
+// Removes clues of a puzzle with one solution, in cell order, until what
+// is left is minimal. A clue that cannot go stays needed whatever else is
+// removed, so the tests run in batches against the current puzzle: those
+// finding a clue needed count even after an earlier clue of the batch
+// was removed, and only the rest are tested again. Unsolvable unless the
+// puzzle has exactly one solution, with solutions telling none (0) from
+// several (2); minimal is only written when Solved.
+SolveStatus reduceToMinimal(const Board& puzzle, const MinimalityOptions& options, Board& minimal,
+                            SolveStats* stats = nullptr, std::uint64_t* solutions = nullptr);
@@ -0,0 +1,131 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "board.h"
+#include "solvestats.h"
+
+// Several 9x9 grids laid on one larger square so that some of their cells
+// coincide, as in Samurai Sudoku. A cell covered by more than one grid is
+// stored once and belongs to the rows, columns and boxes of each, so one
+// constraint graph spans the whole puzzle.
+class MultiGrid {
+public:
+    using Unit = std::array<std::uint16_t, 9>;
+
+    // Samurai: grids in the four corners of a 21x21 square and one in the
+    // centre sharing a corner box with each, 369 cells in all. Grids are
+    // numbered top-left, top-right, centre, bottom-left, bottom-right.
+    static const MultiGrid& samurai();
+
+    // A grid with its top-left corner at (row, col) of the square. Grids
+    // may only overlap in whole boxes (rows and columns multiples of 3
+    // apart); false otherwise or past kMaxCells.
+    bool addGrid(int row, int col);
+
+    static constexpr int kMaxCells = 1024;
+
+    int gridCount() const {
+        return static_cast<int>(origins.size());
+    }
+
+    int cellCount() const {
+        return static_cast<int>(positions.size());
+    }
+
+    // The cell at index (row-major, 0-80) of a grid
+    int cellOf(int grid, int index) const {
+        return gridCells[grid * 81 + index];
+    }
+
+    int unitCount() const {
+        return static_cast<int>(units.size());
+    }
+
+    const Unit& cells(int unit) const {
+        return units[unit];
+    }
+
+    std::span<const std::uint16_t> unitsOf(int cell) const {
+        return {cellUnits.data() + unitStart[cell], cellUnits.data() + unitStart[cell + 1]};
+    }
+
+    std::span<const std::uint16_t> peers(int cell) const {
+        return {peerList.data() + peerStart[cell], peerList.data() + peerStart[cell + 1]};
+    }
+
+private:
+    void rebuild();
+
+    std::vector<std::array<int, 2>> origins;
+    std::vector<std::array<int, 2>> positions;  // (row, col) of each cell
+    std::vector<std::uint16_t> gridCells;       // 81 per grid
+    std::vector<Unit> units;                    // Shared boxes appear once
+
+    // Units and peers of every cell, flattened; cell c's run starts at
+    // start[c] and ends at start[c + 1]
+    std::vector<std::uint32_t> unitStart;
+    std::vector<std::uint16_t> cellUnits;
+    std::vector<std::uint32_t> peerStart;
+    std::vector<std::uint16_t> peerList;
+};
+
+// One puzzle per line: the givens of each grid in layout order as 81
+// characters, separated by spaces. Shared cells must agree where both
+// grids give them.
+bool parseMultiGrid(std::string_view text, const MultiGrid& layout, std::vector<Board>& grids);
+std::string formatMultiGrid(std::span<const Board> grids);
+
+// Solver over a MultiGrid's combined constraint graph. Naked and hidden
+// singles and locked candidates are propagated through every unit of the
+// layout, so a digit placed in or ruled out of a shared box immediately
+// constrains all grids holding it; the search branches on the cell with
+// the fewest candidates.
+class MultiGridSolver {
+public:
+    // The layout must outlive the solver
+    explicit MultiGridSolver(const MultiGrid& layout = MultiGrid::samurai());
+
+    // givens and solution hold one board per grid; clashing givens, shared
+    // cells given differently or a wrong number of boards make the puzzle
+    // Unsolvable
+    SolveStatus solve(std::span<const Board> givens, std::span<Board> solution,
+                      const SolveLimits& limits = SolveLimits());
+
+    // Counters and timings from the most recent solve()
+    const SolveStats& getStats() const {
+        return stats;
+    }
+
+private:
+    // One search level: candidates and placed digits of every cell, kept
+    // in levels (cellCount() apart) that are reused across solves
+    std::uint16_t* candidatesAt(int depth) {
+        return candidates.data() + static_cast<std::size_t>(depth) * cellCount;
+    }
+    std::uint8_t* valuesAt(int depth) {
+        return values.data() + static_cast<std::size_t>(depth) * cellCount;
+    }
+
+    bool load(std::span<const Board> givens);
+    bool assign(int depth, int cell, int num);
+    bool propagate(int depth);
+    bool lockCandidates(int depth, bool& changed);
+    bool search(int depth);
+
+    const MultiGrid* layout;  // Not owned
+    int cellCount = 0;
+    std::vector<std::uint16_t> candidates;
+    std::vector<std::uint8_t> values;
+    std::vector<std::uint16_t> singles;  // Cells left with one candidate
+    int solvedDepth = 0;
+
+    SolveLimits::Clock::time_point deadline;
+    std::stop_token stop;
+    std::uint64_t nodeLimit = 0;
+    bool timedOut = false;
+    SolveStats stats;
+};
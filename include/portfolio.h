@@ -0,0 +1,114 @@
+#pragma once
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stop_token>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "board.h"
+#include "propagator.h"
+#include "satsolver.h"
+#include "solver.h"
+#include "solvestats.h"
+#include "unittable.h"
+
+// Solver configurations a PortfolioSolver can race. Each has inputs that
+// defeat it and that the others take in their stride.
+enum class PortfolioEngine : std::uint8_t {
+    Backtracking,  // SudokuSolver: first empty cell in row-major order
+    Rotated,       // The same on the board turned 180 degrees, so it fills
+                   // the last row first; only for rules that turn with it
+    Mrv,           // ConstraintSolver: fewest candidates first, with singles
+    Cdcl           // SatSudokuSolver: clause learning
+};
+
+constexpr int kPortfolioEngineCount = 4;
+
+constexpr std::array<PortfolioEngine, kPortfolioEngineCount> kAllPortfolioEngines = {
+    PortfolioEngine::Backtracking, PortfolioEngine::Rotated, PortfolioEngine::Mrv, PortfolioEngine::Cdcl};
+
+const char* portfolioEngineName(PortfolioEngine engine);
+bool portfolioEngineFromName(std::string_view name, PortfolioEngine& engine);
+
+// Races several solver configurations on the same board, one thread each.
+// The first to settle the board (Solved or Unsolvable) wins: solve()
+// returns its answer at once and the others are cancelled through a stop
+// token, which they check along with their clocks. The threads are kept
+// between solves; a new solve() first waits for the losers of the last one
+// to stop.
+class PortfolioSolver {
+public:
+    explicit PortfolioSolver(std::span<const PortfolioEngine> engines = kAllPortfolioEngines);
+    ~PortfolioSolver();
+    PortfolioSolver(const PortfolioSolver&) = delete;
+    PortfolioSolver& operator=(const PortfolioSolver&) = delete;
+
+    // Rules for every engine, classic unless set; the table must outlive
+    // the solver
+    void setUnits(const UnitTable& table);
+
+    // TimedOut only when every engine ran out of its limits; Cancelled when
+    // limits.stop is requested first
+    SolveStatus solve(const Board& board, Board& solution, const SolveLimits& limits = SolveLimits());
+
+    // Returns once the engines that lost the last solve() have stopped, so
+    // they no longer use CPU or memory, e.g. before timing something else
+    void wait();
+
+    // The engine that settled the most recent solve(), and its counters
+    PortfolioEngine winner() const {
+        return lastWinner;
+    }
+
+    const SolveStats& getStats() const {
+        return stats;
+    }
+
+    void resetStats() {
+        stats = SolveStats();
+    }
+
+    // Solves won per engine by every portfolio in the process, by
+    // PortfolioEngine value, so a run can report which configuration pays
+    // off on its corpus
+    static std::array<std::uint64_t, kPortfolioEngineCount> totalWins();
+
+private:
+    struct Worker {
+        PortfolioEngine engine;
+        bool enabled = true;  // False when the rules rule the engine out
+        SudokuSolver backtracking;
+        SolverWorkspace workspace;
+        ConstraintSolver mrv;
+        SatSudokuSolver cdcl;
+        std::jthread thread;
+    };
+
+    void run(Worker& worker, std::stop_token shutdown);
+    SolveStatus runEngine(Worker& worker, const Board& board, Board& solution, const SolveLimits& limits);
+
+    std::mutex mutex;
+    std::condition_variable_any started;   // A new round was posted
+    std::condition_variable_any finished;  // A worker settled or stopped
+
+    // The round in progress; guarded by mutex
+    std::uint64_t round = 0;
+    Board board{};
+    SolveLimits limits;
+    std::stop_source roundStop;
+    std::size_t running = 0;
+    bool decided = false;
+    SolveStatus status = SolveStatus::TimedOut;
+    Board result{};
+
+    const UnitTable* units = &UnitTable::classic();  // Not owned
+    PortfolioEngine lastWinner = PortfolioEngine::Backtracking;
+    SolveStats stats;
+
+    // Last, so the threads are joined before anything they use goes away
+    std::vector<std::unique_ptr<Worker>> workers;
+};
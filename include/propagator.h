@@ -0,0 +1,177 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+#include "board.h"
+#include "solvestats.h"
+#include "unittable.h"
+
+// Candidate digits of every cell (bit d-1 for digit d) as propagators see
+// and narrow them. Every change is logged so the solver can wake the
+// propagators watching the cell.
+class CandidateGrid {
+public:
+    std::uint16_t candidates(int cell) const {
+        return masks[cell];
+    }
+
+    // The cell's digit once a single candidate is left, otherwise 0
+    int fixedDigit(int cell) const;
+
+    // Keeps only the digits in mask; false when none is left
+    bool restrict(int cell, std::uint16_t mask);
+
+    bool remove(int cell, std::uint16_t digits) {
+        return restrict(cell, static_cast<std::uint16_t>(~digits));
+    }
+
+private:
+    friend class ConstraintSolver;
+
+    struct ChangeLog {
+        std::vector<std::uint8_t> cells;
+        std::uint64_t eliminations = 0;
+    };
+
+    std::array<std::uint16_t, 81> masks{};
+    ChangeLog* log = nullptr;  // Owned by the solver
+};
+
+// A rule beyond the all-different units. The solver calls propagate()
+// once at the start and again whenever the candidates of a watched cell
+// change, until nothing changes; it must only remove candidates that no
+// solution can use.
+class Propagator {
+public:
+    virtual ~Propagator() = default;
+
+    virtual std::vector<std::uint8_t> watchedCells() const = 0;
+
+    // Narrows the candidates; false when the rule cannot be met
+    virtual bool propagate(CandidateGrid& grid) const = 0;
+};
+
+// The cell's digit appears in none of the other cells (anti-knight and
+// anti-king take the cells a chess move away)
+class DistinctNeighboursPropagator : public Propagator {
+public:
+    DistinctNeighboursPropagator(std::uint8_t cell, std::vector<std::uint8_t> neighbours);
+    std::vector<std::uint8_t> watchedCells() const override;
+    bool propagate(CandidateGrid& grid) const override;
+
+private:
+    std::uint8_t cell;
+    std::vector<std::uint8_t> neighbours;
+};
+
+// No orthogonally adjacent cell holds a digit one above or below the
+// cell's
+class NonConsecutivePropagator : public Propagator {
+public:
+    NonConsecutivePropagator(std::uint8_t cell, std::vector<std::uint8_t> neighbours);
+    std::vector<std::uint8_t> watchedCells() const override;
+    bool propagate(CandidateGrid& grid) const override;
+
+private:
+    std::uint8_t cell;
+    std::vector<std::uint8_t> neighbours;
+};
+
+// Digits strictly increase from the bulb (the first cell) along the tube
+class ThermometerPropagator : public Propagator {
+public:
+    explicit ThermometerPropagator(std::vector<std::uint8_t> cells);
+    std::vector<std::uint8_t> watchedCells() const override;
+    bool propagate(CandidateGrid& grid) const override;
+
+private:
+    std::vector<std::uint8_t> cells;
+};
+
+// The circle's digit is the sum of the digits along the arrow, which may
+// repeat where the rules allow
+class ArrowPropagator : public Propagator {
+public:
+    ArrowPropagator(std::uint8_t circle, std::vector<std::uint8_t> arrow);
+    std::vector<std::uint8_t> watchedCells() const override;
+    bool propagate(CandidateGrid& grid) const override;
+
+private:
+    std::uint8_t circle;
+    std::vector<std::uint8_t> arrow;
+};
+
+// Solver for Sudoku with extra rules plugged in as propagators. Placing a
+// digit clears it from the cell's unit peers; every candidate change
+// queues the propagators watching that cell, so only the rules touching
+// it run again. Hidden singles are looked for once the queue is empty, and
+// the search branches on the cell with the fewest candidates.
+class ConstraintSolver {
+public:
+    void addPropagator(std::unique_ptr<Propagator> propagator);
+    void clearPropagators();
+
+    // All-different units, classic unless set; the table must outlive the
+    // solver
+    void setUnits(const UnitTable& table) {
+        units = &table;
+    }
+
+    SolveStatus solve(const Board& board, Board& solution, const SolveLimits& limits = SolveLimits());
+
+    // Counters and timings from the most recent solve()
+    const SolveStats& getStats() const {
+        return stats;
+    }
+
+private:
+    // The search copies one per level
+    struct State {
+        CandidateGrid grid;
+        Board placed;  // Digits already cleared from their peers
+    };
+
+    void wake(int cell);
+    bool propagate(State& state);
+    bool search(int depth);
+
+    const UnitTable* units = &UnitTable::classic();  // Not owned
+    std::vector<std::unique_ptr<Propagator>> propagators;
+    std::array<std::vector<std::uint16_t>, 81> watchers;  // Propagators by watched cell
+    std::vector<std::uint16_t> queue;
+    std::vector<std::uint8_t> queued;
+    CandidateGrid::ChangeLog log;
+    std::vector<State> states;  // One per search level, kept across solves
+    Board solved{};
+
+    SolveLimits::Clock::time_point deadline;
+    std::stop_token stop;
+    std::uint64_t nodeLimit = 0;
+    bool timedOut = false;
+    SolveStats stats;
+};
+
+// A puzzle with its extra rules, one per line: the 81-character givens,
+// then any of "anti-knight", "anti-king", "non-consecutive",
+// "thermo=C,C,..." (bulb first) and "arrow=C:C,C,..." (circle, then the
+// arrow), separated by spaces. Cells are row-major indices 0-80.
+struct VariantPuzzle {
+    struct Arrow {
+        std::uint8_t circle = 0;
+        std::vector<std::uint8_t> cells;
+    };
+
+    Board givens{};
+    bool antiKnight = false;
+    bool antiKing = false;
+    bool nonConsecutive = false;
+    std::vector<std::vector<std::uint8_t>> thermometers;
+    std::vector<Arrow> arrows;
+};
+
+bool parseVariant(std::string_view text, VariantPuzzle& puzzle);
+
+// Replaces the solver's propagators with the puzzle's rules
+void addPropagators(const VariantPuzzle& puzzle, ConstraintSolver& solver);
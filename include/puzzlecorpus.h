@@ -0,0 +1,20 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// Built-in puzzles offered by New Game, keyed by difficulty
+const std::map<std::string, std::vector<std::string>>& gamePuzzles();
+
+// Well-known puzzles that are hard for humans or for brute-force search
+const std::vector<std::string>& hardestPuzzles();
+
+// The hardest puzzles plus unsolvable variants of them, for comparing how
+// engines cope with search that keeps failing
+const std::vector<std::string>& adversarialPuzzles();
+
+// Deterministic set of puzzles made by shuffling the built-in ones with
+// solution-preserving symmetries (digit relabelling, row/column moves
+// within bands and stacks, band/stack swaps and transposition)
+std::vector<std::string> generatedPuzzles(std::size_t count, std::uint32_t seed);
@@ -0,0 +1,91 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "board.h"
+
+// Multi-puzzle collection formats used by the Sudoku community
+enum class PuzzleFormat {
+    Sdm,  // One 81-character puzzle per line
+    Sdk,  // 9 rows of 9 cells per puzzle, '.' for empty, blank line between puzzles
+    Csv   // puzzle,solution columns as in the Kaggle 1M/9M datasets
+};
+
+struct PuzzleRecord {
+    Board puzzle{};
+    Board solution{};
+    bool hasSolution = false;
+};
+
+using PuzzleCallback = std::function<void(const PuzzleRecord&)>;
+
+// Guess the format from the file extension (.sdk, .csv, anything else is SDM)
+PuzzleFormat formatFromPath(std::string_view path);
+bool formatFromName(std::string_view name, PuzzleFormat& format);
+
+// Incremental parser: feed() takes the input in pieces of any size and
+// calls back once per complete record. Lines are parsed straight from the
+// caller's buffer; only a line split across two pieces is copied into a
+// small fixed carry buffer, so parsing makes no per-line allocation.
+class PuzzleReader {
+public:
+    // atFileStart is false when parsing a block from the middle of a file,
+    // whose first line cannot be a CSV header
+    explicit PuzzleReader(PuzzleFormat format, bool atFileStart = true);
+
+    void feed(std::string_view data, const PuzzleCallback& onRecord);
+    // Flush a trailing line without a newline
+    void finish(const PuzzleCallback& onRecord);
+
+    std::uint64_t recordCount() const { return records; }
+    std::uint64_t rejectedCount() const { return rejected; }
+
+private:
+    void parseLine(std::string_view line, const PuzzleCallback& onRecord);
+    void parseSdkLine(std::string_view line, const PuzzleCallback& onRecord);
+    void parseCsvLine(std::string_view line, const PuzzleCallback& onRecord);
+
+    PuzzleFormat format;
+    std::array<char, 1024> carry;
+    std::size_t carryLength;
+    bool carryOverflow;
+    std::uint64_t lineNumber;
+    std::uint64_t records;
+    std::uint64_t rejected;
+    PuzzleRecord pending;  // .sdk puzzle being assembled
+    int pendingCells;
+};
+
+// Cut a mapped collection into blocks of roughly blockSize bytes that end on
+// a record boundary, so each block can be parsed by its own PuzzleReader
+std::vector<std::string_view> splitRecordBlocks(std::string_view data, PuzzleFormat format,
+                                                std::size_t blockSize);
+
+// Stream every record of a collection file, parsing from memory-mapped
+// pages when possible; returns false if it cannot be read
+bool readPuzzleFile(const std::string& path, PuzzleFormat format, const PuzzleCallback& onRecord,
+                    std::uint64_t* rejected = nullptr);
+
+// Buffered writer for collection files. CSV rows carry the puzzle and,
+// when there is one, its solution; SDM and .sdk have room for one grid, so
+// a record with a solution is written as the solved grid.
+class PuzzleWriter {
+public:
+    PuzzleWriter(const std::string& path, PuzzleFormat format);
+    ~PuzzleWriter();
+    PuzzleWriter(const PuzzleWriter&) = delete;
+    PuzzleWriter& operator=(const PuzzleWriter&) = delete;
+
+    bool isOpen() const { return file != nullptr; }
+    bool write(const PuzzleRecord& record);
+    bool close();
+
+private:
+    std::FILE* file;
+    PuzzleFormat format;
+    std::uint64_t written;
+};
@@ -0,0 +1,169 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+#include "board.h"
+#include "solvestats.h"
+#include "unittable.h"
+
+// Conflict-driven clause learning SAT solver: two watched literals per
+// clause, first-UIP learning with clause minimization, VSIDS branching with
+// saved phases, Luby restarts and periodic removal of learned clauses with
+// a high literal block distance. Variables are numbered from 0; a literal
+// is 2 * variable, plus 1 when negated.
+class SatSolver {
+public:
+    using Literal = std::uint32_t;
+
+    static Literal literal(int var, bool negated = false) {
+        return static_cast<Literal>(var) * 2 + (negated ? 1 : 0);
+    }
+
+    // Empties the problem but keeps the buffers for the next one
+    void clear();
+
+    int addVariable();
+
+    int variableCount() const {
+        return static_cast<int>(assigns.size());
+    }
+
+    // False once the clauses added so far are unsatisfiable without search
+    bool addClause(std::span<const Literal> clause);
+
+    // Solved when the clauses are satisfiable (value() then gives the model),
+    // Unsolvable when they are not, TimedOut past the limits; maxNodes
+    // counts decisions
+    SolveStatus solve(const SolveLimits& limits = SolveLimits());
+
+    bool value(int var) const {
+        return assigns[var] == 1;
+    }
+
+    // From the most recent solve(): nodes are decisions, backtracks are
+    // conflicts, eliminations are propagated literals and maxDepth is the
+    // deepest decision level
+    const SolveStats& getStats() const {
+        return stats;
+    }
+
+    std::uint64_t learnedClauses() const {
+        return learned;
+    }
+
+private:
+    static constexpr std::uint32_t kNoReason = UINT32_MAX;
+
+    struct Clause {
+        std::uint32_t start;  // Literals are literalPool[start, start + size)
+        std::uint32_t size;
+        std::uint32_t lbd;    // Literal block distance; 0 for original clauses
+    };
+
+    struct Watcher {
+        std::uint32_t clause;
+        Literal blocker;  // Some other literal of the clause; true skips it
+    };
+
+    // 1 true, 0 false, -1 unassigned
+    int valueOf(Literal lit) const {
+        int value = assigns[lit >> 1];
+        return value < 0 ? -1 : value ^ static_cast<int>(lit & 1);
+    }
+
+    int decisionLevel() const {
+        return static_cast<int>(trailLimits.size());
+    }
+
+    std::uint32_t attach(std::span<const Literal> literals, std::uint32_t lbd);
+    void enqueue(Literal lit, std::uint32_t reason);
+    std::uint32_t propagate();
+    void analyze(std::uint32_t conflict, int& backtrackLevel, std::uint32_t& lbd);
+    bool redundant(Literal lit) const;
+    void cancelUntil(int level);
+    void reduceLearned();
+    std::optional<SolveStatus> search(std::uint64_t conflictBudget);
+
+    void bumpVariable(int var);
+    void heapInsert(int var);
+    int heapPop();
+    void heapUp(int position);
+    void heapDown(int position);
+
+    std::vector<Literal> literalPool;
+    std::vector<Clause> clauses;
+    std::vector<std::vector<Watcher>> watches;  // By literal, of clauses watching it
+    std::size_t originalClauses = 0;            // Learned ones follow
+    bool unsatisfiable = false;
+
+    std::vector<std::int8_t> assigns;
+    std::vector<std::int8_t> savedPhase;  // 1 to decide the variable negated
+    std::vector<int> levels;
+    std::vector<std::uint32_t> reasons;
+    std::vector<Literal> trail;
+    std::vector<std::size_t> trailLimits;
+    std::size_t propagated = 0;
+
+    std::vector<double> activity;
+    double activityStep = 1;
+    std::vector<int> heap;           // Binary max-heap of variables by activity
+    std::vector<int> heapPosition;   // -1 when not in the heap
+
+    std::vector<std::uint8_t> seen;
+    std::vector<Literal> learntClause;
+    std::vector<Literal> analyzed;
+    std::vector<int> levelStamp;
+    std::uint32_t stamp = 0;
+    std::size_t maxLearned = 0;
+
+    SolveLimits::Clock::time_point deadline;
+    std::stop_token stop;
+    std::uint64_t nodeLimit = 0;
+    std::uint64_t learned = 0;
+    SolveStats stats;
+};
+
+// Sudoku as SAT: one variable per digit an open cell can still take after
+// the givens, true when the cell holds it. Every open cell and every digit
+// missing from a unit gets an exactly-one constraint over its variables:
+// an at-least-one clause, and for groups over four a sequential-counter
+// at-most-one encoding, which takes n - 1 helper variables and 3n - 4
+// binary clauses (23 for a group of 9, where pairwise exclusion needs 36).
+// Learning lets the search avoid repeating the failures that backtracking
+// keeps running into.
+class SatSudokuSolver {
+public:
+    SolveStatus solve(const Board& board, Board& solution, const SolveLimits& limits = SolveLimits());
+
+    // Rules to encode, classic unless set; the table must outlive the solver
+    void setUnits(const UnitTable& table) {
+        units = &table;
+    }
+
+    const SolveStats& getStats() const {
+        return stats;
+    }
+
+    void resetStats() {
+        stats = SolveStats();
+    }
+
+    std::uint64_t learnedClauses() const {
+        return sat.learnedClauses();
+    }
+
+private:
+    // Up to this size pairwise exclusion takes no more clauses than the
+    // sequential counter and no helper variables
+    static constexpr int kPairwiseLimit = 4;
+
+    bool addExactlyOne(std::span<const SatSolver::Literal> group);
+
+    const UnitTable* units = &UnitTable::classic();  // Not owned
+    SatSolver sat;
+    std::array<int, 81 * 9> variables{};  // Of cell * 9 + digit - 1, -1 if none
+    std::vector<SatSolver::Literal> clause;
+    SolveStats stats;
+};
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "board.h"
+#include "canonical.h"
+#include "solvestats.h"
+
+struct CacheCounters {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t evictions = 0;
+};
+
+// Bounded puzzle -> solution cache keyed by canonical form, so relabelled,
+// rotated or transposed copies of a puzzle share one entry. Entries are
+// spread over independently locked shards and evicted with the CLOCK
+// (second chance) policy. Safe to share between threads.
+class SolutionCache {
+public:
+    explicit SolutionCache(std::size_t capacity, std::size_t shardCount = 16);
+
+    // Looks up a canonical board; on a hit fills its status and canonical solution
+    bool lookup(const Board& canonical, SolveStatus& status, Board& solution);
+    void insert(const Board& canonical, SolveStatus status, const Board& solution);
+
+    // Solves through the cache: equivalent puzzles seen before are answered
+    // by mapping the cached solution back, others run SudokuSolver
+    SolveStatus solve(const Board& puzzle, Board& solution);
+
+    CacheCounters counters() const;
+    std::size_t size() const;
+    std::size_t capacity() const { return shardCapacity * shards.size(); }
+
+private:
+    struct BoardHash {
+        std::size_t operator()(const Board& board) const;
+    };
+
+    struct Entry {
+        Board key{};
+        Board solution{};
+        SolveStatus status = SolveStatus::Unsolvable;
+        bool referenced = false;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<Board, std::size_t, BoardHash> index;
+        std::vector<Entry> entries;
+        std::size_t hand = 0;  // CLOCK position for the next eviction
+        CacheCounters counters;
+    };
+
+    Shard& shardFor(const Board& canonical);
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::size_t shardCapacity;
+};
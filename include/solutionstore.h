@@ -0,0 +1,83 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include "board.h"
+#include "mappedfile.h"
+#include "solvestats.h"
+
+// What the store remembers about one canonical puzzle
+struct StoredSolution {
+    SolveStatus status = SolveStatus::Unsolvable;
+    PuzzleGrade grade = PuzzleGrade::Easy;
+    Board solution{};   // In the canonical frame; see canonicalize()
+    SolveStats stats;   // Counters of the solve that produced it
+};
+
+struct StoreOptions {
+    // fsync the log after every append instead of only in flush()
+    bool syncEachAppend = false;
+    // Size the index for this many entries up front to avoid rebuilds
+    std::uint64_t expectedEntries = 0;
+};
+
+// Embedded canonical puzzle -> solution store that survives restarts.
+//
+// <path>.log is an append-only log of fixed-size records, each with a
+// CRC32, and is the only source of truth. <path>.idx is an open-addressing
+// hash index over the log, memory-mapped so that opening a store of any
+// size costs a few page faults. The index records how many log records it
+// covers and whether it was flushed cleanly: on open, a clean index only
+// needs the log records past that count, while an index left behind by a
+// crash is rebuilt from the log. A torn record at the end of the log (a
+// crash mid-append) is cut off.
+//
+// One process may have a store open at a time. Calls are thread-safe.
+class SolutionStore {
+public:
+    SolutionStore() = default;
+    ~SolutionStore();
+    SolutionStore(const SolutionStore&) = delete;
+    SolutionStore& operator=(const SolutionStore&) = delete;
+
+    // Opens or creates the store; returns false if the files cannot be
+    // used (e.g. the log is not a store log)
+    bool open(const std::string& path, const StoreOptions& options = StoreOptions());
+    void close();
+    bool isOpen() const { return log != nullptr; }
+
+    bool lookup(const Board& canonical, StoredSolution& entry);
+    // Appends an entry unless the puzzle is already stored
+    bool append(const Board& canonical, const StoredSolution& entry);
+    // Makes every append so far durable and marks the index clean
+    bool flush();
+
+    std::uint64_t size() const;
+
+    // Solves through the store: known puzzles (up to symmetry) are answered
+    // from it, new ones are solved with SudokuSolver and appended
+    SolveStatus solve(const Board& puzzle, Board& solution, SolveStats* stats = nullptr);
+
+private:
+    struct IndexHeader;
+
+    IndexHeader* header() const;
+    std::uint64_t* slots() const;
+    bool createIndex(std::uint64_t slotCount);
+    bool rebuildIndex(std::uint64_t slotCount);
+    bool scanLog(std::uint64_t firstRecord);
+    bool insertSlot(std::uint64_t id, std::uint64_t record);
+    bool findRecord(const Board& canonical, std::uint64_t& record);
+    bool readRecord(std::uint64_t record, Board& canonical, StoredSolution& entry);
+    void markDirty();
+    bool appendLocked(const Board& canonical, const StoredSolution& entry);
+
+    mutable std::mutex mutex;
+    std::string logPath;
+    std::string indexPath;
+    std::FILE* log = nullptr;
+    MappedFile index;
+    std::uint64_t records = 0;  // Good records in the log
+    StoreOptions options;
+};
@@ -1,199 +1,173 @@
 #pragma once
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <stop_token>
 #include <vector>
-#include <memory>
+#include "board.h"
+#include "solvetask.h"
+#include "solvetrace.h"
+#include "solvestats.h"
+#include "transposition.h"
+#include "unittable.h"
+
+// One level of the backtracking search: the cell it fills and the digits
+// not yet tried there (bit d-1 for digit d). The digit currently placed is
+// the cell's value in the workspace.
+struct SearchFrame {
+    std::uint8_t cell;
+    std::uint16_t candidates;
+};
 
-class Node {
-public:
-    char character;
-    bool isEndOfWord;
-    std::unique_ptr<Node> left;
-    std::unique_ptr<Node> middle;
-    std::unique_ptr<Node> right;
-
-    Node(char ch) : character(ch), isEndOfWord(false) {}
-    Node(const Node& other) : character(other.character), isEndOfWord(other.isEndOfWord) {
-        if (other.left) left = std::make_unique<Node>(*other.left);
-        if (other.middle) middle = std::make_unique<Node>(*other.middle);
-        if (other.right) right = std::make_unique<Node>(*other.right);
-    }
+// Scratch state for one solve. Everything is fixed-size, so reusing a
+// workspace across solves keeps the solve path free of heap allocations.
+struct SolverWorkspace {
+    Board cells{};
+    // Bit d-1 is set once digit d is placed in the unit, indexed like the
+    // solver's UnitTable
+    std::array<std::uint16_t, UnitTable::kMaxUnits> unitUsed{};
+    std::uint64_t hash = 0;  // Zobrist hash of cells, kept by every place and unplace
+
+    // Search stack, one frame per placement plus the level being entered,
+    // so a search can stop between any two nodes and carry on later
+    std::array<SearchFrame, 82> frames{};
+    int depth = 0;
 };
 
-class TernarySearchTree {
+// Receives each solution an enumeration finds; returning false stops it
+using SolutionCallback = std::function<bool(const Board&)>;
+
+class SudokuSolver {
 private:
-    std::unique_ptr<Node> root;
-    
-    std::unique_ptr<Node> insert(std::unique_ptr<Node> node, char character) {
-        if (!node) {
-            return std::make_unique<Node>(character);
-        }
-        if (character < node->character) {
-            node->left = insert(std::move(node->left), character);
-        } else if (character > node->character) {
-            node->right = insert(std::move(node->right), character);
-        } else {
-            node->isEndOfWord = true;
-        }
-        return node;
-    }
+    Board grid{};
+    SolverWorkspace workspace;
+    const UnitTable* units = &UnitTable::classic();  // Not owned
+    SolveTrace* trace = nullptr;  // Not owned; null disables tracing
+    TranspositionTable* transpositions = nullptr;  // Not owned; may be shared
+    SolveStats stats;
+
+    // Classic instantiations work out a cell's row, column and box from its
+    // index instead of loading them from the table, which keeps the search
+    // loop as tight as it was before variants
+    template <bool Classic>
+    std::uint16_t usedMask(const SolverWorkspace& ws, int cell) const;
+    bool isSafe(const SolverWorkspace& ws, int cell, int num) const;
+    template <bool Classic>
+    void place(SolverWorkspace& ws, int cell, int num, SolveTechnique technique);
+    template <bool Classic>
+    void unplace(SolverWorkspace& ws, int cell, int num);
+
+    void beginSearch(SolverWorkspace& ws);
 
-    bool search(const Node* node, char character) const {
-        if (!node) return false;
-        if (character < node->character) return search(node->left.get(), character);
-        if (character > node->character) return search(node->right.get(), character);
-        return node->isEndOfWord;
-    }
+public:
+    enum class SearchState {
+        Solved,     // The solution is in the workspace's cells
+        Exhausted,  // No solution
+        Paused      // Node budget used up; continueSearch() picks up from here
+    };
 
-    std::unique_ptr<Node> deleteNode(std::unique_ptr<Node> node, char character) {
-        if (!node) return nullptr;
-        if (character < node->character) {
-            node->left = deleteNode(std::move(node->left), character);
-        } else if (character > node->character) {
-            node->right = deleteNode(std::move(node->right), character);
-        } else {
-            node->isEndOfWord = false;
-            if (!node->left && !node->middle && !node->right) {
-                return nullptr;
-            }
-        }
-        return node;
-    }
+private:
+    template <bool Classic>
+    SearchState runSearch(SolverWorkspace& ws, std::uint64_t nodeBudget);
+    template <bool Classic>
+    SolveStatus runCount(SolverWorkspace& ws, std::uint64_t maxCount, const SolveLimits& limits,
+                         const SolutionCallback* onSolution, std::uint64_t& count);
 
 public:
-    TernarySearchTree() {
-        for (char c = '1'; c <= '9'; ++c) {
-            insert(c);
-        }
-    }
+    SudokuSolver() = default;
+    SudokuSolver(const std::vector<std::vector<int>>& board) : grid(boardFromGrid(board)) {}
 
-    TernarySearchTree(const TernarySearchTree& other) {
-        if (other.root) {
-            root = std::make_unique<Node>(*other.root);
-        }
-    }
+    bool solve();
+    // Grid solve within limits; on TimedOut the grid is left unchanged
+    SolveStatus solve(const SolveLimits& limits);
 
-    TernarySearchTree& operator=(const TernarySearchTree& other) {
-        if (this != &other) {
-            root.reset();
-            if (other.root) {
-                root = std::make_unique<Node>(*other.root);
-            }
-        }
-        return *this;
-    }
+    // Allocation-free entry point: solves the board in place using the
+    // caller's workspace, which can be reused for the next solve
+    bool solve(Board& board, SolverWorkspace& ws);
+    // Same, giving up with TimedOut once a limit is reached; the board is
+    // only written when solved
+    SolveStatus solve(Board& board, SolverWorkspace& ws, const SolveLimits& limits);
 
-    void insert(char character) {
-        root = insert(std::move(root), character);
-    }
+    // The two halves of solve(): prepare() resets the stats and loads the
+    // givens into the workspace (false if two givens clash), search()
+    // continues from whatever state the workspace holds
+    bool prepare(const Board& board, SolverWorkspace& ws);
+    bool search(Board& board, SolverWorkspace& ws);
+    SolveStatus search(Board& board, SolverWorkspace& ws, const SolveLimits& limits);
 
-    bool search(char character) const {
-        return search(root.get(), character);
-    }
+    // Counts the board's solutions into count, stopping at maxCount (0 for
+    // no cap): Solved once the search has found them all or maxCount,
+    // Unsolvable when there are none, TimedOut with the count so far
+    SolveStatus countSolutions(const Board& board, SolverWorkspace& ws, std::uint64_t& count,
+                               std::uint64_t maxCount = 0, const SolveLimits& limits = SolveLimits());
+    // The same search handing each solution to onSolution as it is found,
+    // in search order, without keeping any. Cancelled when onSolution
+    // returns false.
+    SolveStatus enumerateSolutions(const Board& board, SolverWorkspace& ws, const SolutionCallback& onSolution,
+                                   std::uint64_t& count, std::uint64_t maxCount = 0,
+                                   const SolveLimits& limits = SolveLimits());
 
-    void deleteCharacter(char character) {
-        root = deleteNode(std::move(root), character);
-    }
+    // Time-sliced solving: startSearch() loads the givens (false if two
+    // clash), then each continueSearch() runs at most nodeBudget more nodes
+    bool startSearch(const Board& board, SolverWorkspace& ws);
+    SearchState continueSearch(SolverWorkspace& ws, std::uint64_t nodeBudget);
 
-    bool isEmpty() const {
-        return !root;
-    }
-};
+    // A paused search and this solver's counters as bytes that restore()
+    // loads back, possibly in another process, to continue the search
+    std::vector<std::uint8_t> checkpoint(const SolverWorkspace& ws) const;
+    bool restore(std::span<const std::uint8_t> data, SolverWorkspace& ws);
 
-class SudokuSolver {
-private:
-    std::vector<std::vector<int>> grid;
-    std::vector<std::vector<TernarySearchTree>> possibilities;
+    // Coroutine solve for event-driven callers. The search runs in slices
+    // of options.nodesPerSlice nodes; between slices it checks the stop
+    // token and, given a scheduler, suspends and lets the scheduler resume
+    // it, so one long search cannot hold an executor thread. Stats are
+    // kept in this solver, which must outlive the task.
+    SolveTask solveAsync(Board board, std::stop_token stop = {}, AsyncSolveOptions options = {});
 
-    void initializePossibilities() {
-        possibilities.resize(9, std::vector<TernarySearchTree>(9));
+    void resetStats() {
+        stats = SolveStats();
     }
 
-    bool isSafe(int row, int col, int num) {
-        // Check row
-        for (int x = 0; x < 9; x++)
-            if (grid[row][x] == num)
-                return false;
-
-        // Check column
-        for (int x = 0; x < 9; x++)
-            if (grid[x][col] == num)
-                return false;
-
-        // Check 3x3 box
-        int startRow = row - row % 3, startCol = col - col % 3;
-        for (int i = 0; i < 3; i++)
-            for (int j = 0; j < 3; j++)
-                if (grid[i + startRow][j + startCol] == num)
-                    return false;
-
-        return true;
+    std::vector<std::vector<int>> getGrid() const {
+        return gridFromBoard(grid);
     }
 
-    void propagateConstraints(int row, int col, int num) {
-        char charNum = '0' + num;
-        // Remove possibility from row
-        for (int j = 0; j < 9; j++)
-            possibilities[row][j].deleteCharacter(charNum);
-
-        // Remove possibility from column
-        for (int i = 0; i < 9; i++)
-            possibilities[i][col].deleteCharacter(charNum);
-
-        // Remove possibility from 3x3 box
-        int boxRow = row - row % 3, boxCol = col - col % 3;
-        for (int i = 0; i < 3; i++)
-            for (int j = 0; j < 3; j++)
-                possibilities[boxRow + i][boxCol + j].deleteCharacter(charNum);
+    void setGrid(const std::vector<std::vector<int>>& newGrid) {
+        grid = boardFromGrid(newGrid);
     }
 
-    bool solveSudoku() {
-        int row = -1, col = -1;
-        bool isEmpty = false;
-        
-        // Find empty cell
-        for (int i = 0; i < 9; i++) {
-            for (int j = 0; j < 9; j++) {
-                if (grid[i][j] == 0) {
-                    row = i;
-                    col = j;
-                    isEmpty = true;
-                    break;
-                }
-            }
-            if (isEmpty) break;
-        }
-
-        if (!isEmpty) return true;
-
-        for (int num = 1; num <= 9; num++) {
-            if (isSafe(row, col, num)) {
-                grid[row][col] = num;
-                propagateConstraints(row, col, num);
-
-                if (solveSudoku())
-                    return true;
-
-                grid[row][col] = 0;
-                initializePossibilities();
-            }
-        }
-        return false;
+    // Rules to solve by: the classic table unless set. The table must
+    // outlive the solver, and workspaces carry over only between solves
+    // with the same table.
+    void setUnits(const UnitTable& table) {
+        units = &table;
     }
 
-public:
-    SudokuSolver(const std::vector<std::vector<int>>& board) : grid(board) {
-        initializePossibilities();
+    const UnitTable& getUnits() const {
+        return *units;
     }
 
-    bool solve() {
-        return solveSudoku();
+    // countSolutions() records boards whose subtree held no solution in
+    // the table and skips boards found there. Dead boards stay dead, so
+    // counting runs over related puzzles (one with a given removed, say)
+    // do not search the same partial boards again; a table may be shared
+    // between solvers and threads using the same rules. nullptr, the
+    // default, turns it off.
+    void setTranspositions(TranspositionTable* table) {
+        transpositions = table;
     }
 
-    std::vector<std::vector<int>> getGrid() const { 
-        return grid; 
+    // Record search events into the given buffer; pass nullptr to stop tracing
+    void setTrace(SolveTrace* newTrace) {
+        trace = newTrace;
     }
 
-    void setGrid(const std::vector<std::vector<int>>& newGrid) { 
-        grid = newGrid; 
-        initializePossibilities();
+    // Counters and timings from the most recent solve()
+    const SolveStats& getStats() const {
+        return stats;
     }
-}; 
\ No newline at end of file
+
+    // Workspace owned by the calling thread, for callers without their own
+    static SolverWorkspace& threadWorkspace();
+};
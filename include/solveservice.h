@@ -0,0 +1,97 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+#include "batchsolver.h"
+#include "board.h"
+#include "solvestats.h"
+#include "threadpool.h"
+
+// Local solve service: other processes on the host send batches of boards
+// over a socket and get the solutions back, without linking the solver.
+//
+// Addresses are "PORT" or "HOST:PORT" for TCP (HOST defaults to
+// 127.0.0.1), anything else is a Unix domain socket path.
+//
+// Wire format, all integers little-endian. A request is
+//   u32 count, u32 tag, count packed boards (kPackedBoardSize bytes each)
+// and its response is
+//   u32 count, u32 tag, count x (u8 SolveStatus, packed solution).
+// Clients may pipeline any number of requests; responses carry the tag of
+// their request and are sent as soon as each batch is solved, so they can
+// arrive out of order. A solution is all zeros unless its status is Solved;
+// with solver limits set, a board may come back as TimedOut.
+
+// Largest batch a request may carry; bigger ones drop the connection
+constexpr std::uint32_t kMaxServiceBatch = 1 << 16;
+
+struct ServiceOptions {
+    std::size_t threads = 0;          // Solver threads, 0 for one per core
+    std::size_t maxInFlight = 64;     // Batches per connection being solved or sent
+    BatchOptions solver;
+};
+
+// Not available on Windows, where listen() fails
+class SolveServer {
+public:
+    explicit SolveServer(const ServiceOptions& options = ServiceOptions());
+    ~SolveServer();
+    SolveServer(const SolveServer&) = delete;
+    SolveServer& operator=(const SolveServer&) = delete;
+
+    bool listen(const std::string& address);
+    // Accepts and serves connections until stop(); connections still open
+    // then get the responses to the requests already read
+    void run();
+    // Safe to call from a signal handler
+    void stop() { stopping = true; }
+
+private:
+    struct Connection;
+
+    void serve(const std::shared_ptr<Connection>& connection);
+    void writeResponses(const std::shared_ptr<Connection>& connection);
+    void reapConnections(bool all);
+
+    ServiceOptions options;
+    ThreadPool pool;
+    int listenFd = -1;
+    std::string socketPath;  // Unix socket to remove on shutdown
+    std::atomic<bool> stopping{false};
+    std::mutex connectionsMutex;
+    std::list<std::shared_ptr<Connection>> connections;
+};
+
+// Blocking client for the service. One thread may send while another
+// receives.
+class SolveClient {
+public:
+    SolveClient() = default;
+    ~SolveClient();
+    SolveClient(const SolveClient&) = delete;
+    SolveClient& operator=(const SolveClient&) = delete;
+
+    bool connect(const std::string& address);
+    void close();
+    bool isOpen() const { return fd >= 0; }
+
+    bool sendBatch(std::uint32_t tag, std::span<const Board> puzzles);
+    // Tells the server no more requests follow; responses keep coming
+    bool finishSending();
+    // Shuts the connection down both ways without closing it, so a send or
+    // receive blocked on another thread fails instead of waiting forever
+    void abort();
+    // Waits for the next response; false at end of stream or on error
+    bool receiveBatch(std::uint32_t& tag, std::vector<SolveStatus>& status, std::vector<Board>& solutions);
+
+private:
+    int fd = -1;
+    std::vector<std::uint8_t> sendBuffer;
+    std::vector<std::uint8_t> receiveBuffer;
+};
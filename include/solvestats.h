@@ -0,0 +1,106 @@
+#pragma once
+#include <cstdint>
+#include <chrono>
+#include <ostream>
+#include <stop_token>
+
+// Outcome of solving one board
+enum class SolveStatus : std::uint8_t {
+    Solved,
+    Unsolvable,
+    Cancelled,  // Stopped on request before the search finished
+    TimedOut    // Ran out of its node budget or time before finishing
+};
+
+// Bounds on one solve; whichever is hit first ends it with TimedOut and
+// the counters gathered so far, or Cancelled for a stop request. The
+// default is unbounded.
+struct SolveLimits {
+    using Clock = std::chrono::steady_clock;
+
+    std::uint64_t maxNodes = 0;                       // 0 for no node budget
+    std::chrono::nanoseconds timeBudget{0};           // Per solve, from its start; 0 for none
+    Clock::time_point deadline = Clock::time_point::max();
+    std::stop_token stop;                             // Checked along with the clock
+
+    bool bounded() const {
+        return maxNodes > 0 || timeBudget.count() > 0 || deadline != Clock::time_point::max();
+    }
+
+    // The earlier of the deadline and the time budget counted from start
+    Clock::time_point deadlineFrom(Clock::time_point start) const {
+        if (timeBudget.count() > 0 && start + timeBudget < deadline) return start + timeBudget;
+        return deadline;
+    }
+};
+
+// Counters gathered by one SudokuSolver::solve() call
+struct SolveStats {
+    std::uint64_t nodes = 0;         // Placements tried by the search
+    std::uint64_t backtracks = 0;    // Placements taken back
+    std::uint64_t eliminations = 0;  // Candidates removed by propagation
+    int maxDepth = 0;                // Deepest level reached by the search
+    std::int64_t setupNs = 0;        // Building candidates from the givens
+    std::int64_t searchNs = 0;       // Backtracking search
+
+    std::int64_t totalNs() const { return setupNs + searchNs; }
+
+    SolveStats& operator+=(const SolveStats& other) {
+        nodes += other.nodes;
+        backtracks += other.backtracks;
+        eliminations += other.eliminations;
+        if (other.maxDepth > maxDepth) maxDepth = other.maxDepth;
+        setupNs += other.setupNs;
+        searchNs += other.searchNs;
+        return *this;
+    }
+};
+
+inline std::ostream& operator<<(std::ostream& out, const SolveStats& stats) {
+    return out << "nodes=" << stats.nodes
+               << " backtracks=" << stats.backtracks
+               << " eliminations=" << stats.eliminations
+               << " max_depth=" << stats.maxDepth
+               << " setup_ns=" << stats.setupNs
+               << " search_ns=" << stats.searchNs;
+}
+
+// Difficulty judged by how hard the search had to work, using the same
+// names as the New Game menu
+enum class PuzzleGrade : std::uint8_t {
+    Easy,
+    Medium,
+    Hard,
+    Expert
+};
+
+inline PuzzleGrade gradeFromStats(const SolveStats& stats) {
+    if (stats.nodes < 1000) return PuzzleGrade::Easy;
+    if (stats.nodes < 20000) return PuzzleGrade::Medium;
+    if (stats.nodes < 500000) return PuzzleGrade::Hard;
+    return PuzzleGrade::Expert;
+}
+
+inline const char* gradeName(PuzzleGrade grade) {
+    switch (grade) {
+    case PuzzleGrade::Easy: return "Easy";
+    case PuzzleGrade::Medium: return "Medium";
+    case PuzzleGrade::Hard: return "Hard";
+    case PuzzleGrade::Expert: return "Expert";
+    }
+    return "Unknown";
+}
+
+// Nanosecond timer for the solver phases
+class PhaseTimer {
+public:
+    PhaseTimer() : start(std::chrono::steady_clock::now()) {}
+
+    std::int64_t elapsedNs() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point start;
+};
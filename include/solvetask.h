@@ -0,0 +1,106 @@
+#pragma once
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include "board.h"
+#include "solvestats.h"
+
+struct SolveResult {
+    SolveStatus status = SolveStatus::Unsolvable;
+    Board solution{};
+    SolveStats stats;
+};
+
+// Called with a suspended solve; it must arrange for handle.resume() to run
+// later, typically by queueing it on an executor
+using SolveScheduler = std::function<void(std::coroutine_handle<>)>;
+
+struct AsyncSolveOptions {
+    // Search nodes between stop checks and yields
+    std::uint64_t nodesPerSlice = 1 << 14;
+    // Without a scheduler the search never suspends and only checks for stop
+    SolveScheduler scheduler;
+    // Checked between slices, so a solve may overrun them by one slice
+    SolveLimits limits;
+};
+
+// Lazily started coroutine producing a SolveResult. Either co_await it from
+// another coroutine, which resumes when the solve finishes, or call wait()
+// from ordinary code.
+class SolveTask {
+    // Lets wait() block until the coroutine has finished
+    struct Waiter {
+        std::mutex mutex;
+        std::condition_variable finished;
+        bool done = false;
+    };
+
+public:
+    struct promise_type {
+        SolveResult result;
+        std::coroutine_handle<> continuation;
+        Waiter* waiter = nullptr;
+
+        SolveTask get_return_object() {
+            return SolveTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        auto final_suspend() noexcept { return FinalAwaiter{}; }
+        void return_value(SolveResult value) { result = std::move(value); }
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    SolveTask(SolveTask&& other) noexcept : handle(std::exchange(other.handle, {})) {}
+    SolveTask& operator=(SolveTask&& other) noexcept {
+        if (this != &other) {
+            if (handle) handle.destroy();
+            handle = std::exchange(other.handle, {});
+        }
+        return *this;
+    }
+    ~SolveTask() {
+        if (handle) handle.destroy();
+    }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle.promise().continuation = awaiting;
+        return handle;
+    }
+    SolveResult await_resume() { return std::move(handle.promise().result); }
+
+    // Starts the solve on this thread and blocks until it finishes, wherever
+    // the scheduler resumed it
+    SolveResult wait() {
+        Waiter waiter;
+        handle.promise().waiter = &waiter;
+        handle.resume();
+        std::unique_lock<std::mutex> lock(waiter.mutex);
+        waiter.finished.wait(lock, [&] { return waiter.done; });
+        return std::move(handle.promise().result);
+    }
+
+private:
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> finishing) noexcept {
+            promise_type& promise = finishing.promise();
+            std::coroutine_handle<> next = promise.continuation;
+            if (promise.waiter) {
+                // Notify under the lock: wait() cannot return until it is released
+                std::lock_guard<std::mutex> lock(promise.waiter->mutex);
+                promise.waiter->done = true;
+                promise.waiter->finished.notify_all();
+            }
+            return next ? next : std::noop_coroutine();
+        }
+        void await_resume() const noexcept {}
+    };
+
+    explicit SolveTask(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+    std::coroutine_handle<promise_type> handle;
+};
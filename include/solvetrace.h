@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+enum class TraceEventType : std::uint8_t {
+    Assign,     // A digit was placed in a cell
+    Eliminate,  // A candidate was removed from a cell
+    Backtrack   // A placed digit was taken back
+};
+
+enum class SolveTechnique : std::uint8_t {
+    Given,       // Clue from the puzzle, placed during setup
+    Guess,       // Trial placement made by the backtracking search
+    Propagation  // Consequence of a placement on the cell's peers
+};
+
+// Four bytes per event so long searches fit in a modest buffer
+struct TraceEvent {
+    TraceEventType type;
+    SolveTechnique technique;
+    std::uint8_t cell;   // row * 9 + col
+    std::uint8_t digit;
+
+    int row() const { return cell / 9; }
+    int col() const { return cell % 9; }
+};
+
+// Fixed-capacity ring buffer of solver events. All storage is allocated up
+// front, so recording never allocates; once full, the oldest events are
+// overwritten and wrapped() reports that the start of the solve was lost.
+class SolveTrace {
+public:
+    explicit SolveTrace(std::size_t capacity = 1 << 16)
+        : events(capacity > 0 ? capacity : 1), head(0), count(0), total(0) {}
+
+    void record(TraceEventType type, SolveTechnique technique, int row, int col, int digit) {
+        events[head] = TraceEvent{type, technique,
+                                  static_cast<std::uint8_t>(row * 9 + col),
+                                  static_cast<std::uint8_t>(digit)};
+        if (++head == events.size()) head = 0;
+        if (count < events.size()) ++count;
+        ++total;
+    }
+
+    void clear() {
+        head = 0;
+        count = 0;
+        total = 0;
+    }
+
+    // Events are indexed oldest first
+    const TraceEvent& at(std::size_t index) const {
+        std::size_t start = count < events.size() ? 0 : head;
+        std::size_t pos = start + index;
+        if (pos >= events.size()) pos -= events.size();
+        return events[pos];
+    }
+
+    std::size_t size() const { return count; }
+    std::size_t capacity() const { return events.size(); }
+    std::uint64_t totalRecorded() const { return total; }
+    bool wrapped() const { return total > count; }
+
+private:
+    std::vector<TraceEvent> events;
+    std::size_t head;
+    std::size_t count;
+    std::uint64_t total;
+};
@@ -9,6 +9,7 @@
 #include <QDateTime>
 #include <QDir>
 #include <QEvent>
+#include "hint.h"
 #include "solver.h"
 #include <vector>
 #include <optional>
@@ -30,6 +31,10 @@ public:
     void clear();
     bool isValid() const;
     void highlightConflicts();
+    // Switch the rules (e.g. add the diagonals); validation, hints and the
+    // solver all follow the table
+    void setUnits(const UnitTable& table);
+    const UnitTable& getUnits() const { return units; }
     void loadExample();
     bool isFull() const;
     void applyTheme(bool isDark);
@@ -41,16 +46,25 @@ public:
     bool importFromString(const QString& data);
     GridState getCurrentState() const;
     void newGame(const QString& difficulty);
+    // Takes the easiest logical step: fills the cell or drops the
+    // eliminated digits from the notes, and flashes the cells behind it
     void showHint();
     QLineEdit* getCurrentCell() const { return currentCell; }
     bool isNotesMode() const;
     void setNotesMode(bool enabled);
     void toggleNote(QLineEdit* cell, int number);
+    void showTraceEvent(const TraceEvent& event);
+    void restoreAfterPlayback(const std::vector<std::vector<int>>& values);
     
     // New methods for file operations
     bool savePuzzleToFile(const QString& filename = QString());
     bool loadPuzzleFromFile(const QString& filename);
     QStringList getSavedPuzzleFiles() const;
+    
+    // Community collection formats (.sdm, .sdk, .csv); import takes the first puzzle
+    static bool isCollectionFile(const QString& filename);
+    bool exportToCollectionFile(const QString& filename) const;
+    bool importFromCollectionFile(const QString& filename);
 
 signals:
     void gridChanged();
@@ -64,6 +78,7 @@ signals:
     void mistakesReset(); // Signal to reset mistakes counter
     void scoreIncreased(int points);  // Signal when score should increase
     void scoreReset();    // Signal to reset score
+    void hintShown(const Hint& hint);  // None when a cell was revealed from the solution
 
 protected:
     bool eventFilter(QObject* obj, QEvent* event) override;
@@ -80,14 +95,14 @@ private:
     QLineEdit* currentCell;
     std::map<QLineEdit*, std::vector<int>> notes;
     SudokuSolver solver;
+    HintFinder hintFinder;
+    UnitTable units;  // Rules for validation and the solver
     QString savesDirectory;
 
     void createGrid();
     void styleCell(QLineEdit* cell, int row, int col);
     void validateInput(QLineEdit* cell);
-    bool checkRowValid(int row) const;
-    bool checkColumnValid(int col) const;
-    bool checkBoxValid(int startRow, int startCol) const;
+    bool checkUnitValid(int unit) const;
     void clearHighlighting();
     std::optional<int> getCellValue(int row, int col) const;
     void animateCell(QLineEdit* cell, const QString& color);
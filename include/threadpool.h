@@ -0,0 +1,46 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fixed set of worker threads draining a FIFO task queue
+class ThreadPool {
+public:
+    // 0 picks one worker per hardware thread
+    explicit ThreadPool(std::size_t threadCount = 0);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    std::size_t size() const { return workers.size(); }
+
+    // Queue a task; the future carries its result or exception
+    template <typename F>
+    auto submit(F&& task) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+        using Result = std::invoke_result_t<std::decay_t<F>>;
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+        std::future<Result> result = packaged->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.emplace_back([packaged] { (*packaged)(); });
+        }
+        wakeup.notify_one();
+        return result;
+    }
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    bool stopping = false;
+};
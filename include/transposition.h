@@ -0,0 +1,75 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Zobrist keys: a board's hash is the XOR of kZobrist[cell][digit - 1] over
+// its filled cells, so placing or clearing a digit updates it with one XOR
+struct ZobristKeys {
+    std::array<std::array<std::uint64_t, 9>, 81> keys{};
+
+    // splitmix64 from a fixed seed, so hashes match across runs and builds
+    constexpr ZobristKeys() {
+        std::uint64_t state = 0x5D0C0FFEEULL;
+        for (auto& cell : keys) {
+            for (auto& key : cell) {
+                std::uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+                key = z ^ (z >> 31);
+            }
+        }
+    }
+
+    std::uint64_t operator()(int cell, int num) const {
+        return keys[cell][num - 1];
+    }
+};
+
+inline constexpr ZobristKeys kZobrist;
+
+// Bounded set of board hashes proven to have no solution, shared lock-free
+// between threads. Slots are atomic 64-bit words grouped in buckets of four
+// on one cache line; a full bucket overwrites one of its slots, so the
+// table forgets old entries rather than growing. Since only hashes are
+// kept, two boards with the same 64-bit hash are taken for one; at the
+// sizes used here that is vanishingly rare.
+//
+// Whether a board has a solution depends on the rules, so one table must
+// only serve solves with the same UnitTable.
+class TranspositionTable {
+public:
+    // Room for at least entries hashes, rounded up to a power of two. The
+    // default takes 512 KB, small enough for probes to stay in cache.
+    explicit TranspositionTable(std::size_t entries = std::size_t{1} << 16);
+
+    bool contains(std::uint64_t hash) const {
+        std::uint64_t key = hash | 1;  // 0 marks an empty slot
+        const Bucket& bucket = buckets[(key >> 1) & mask];
+        for (const auto& slot : bucket.slots) {
+            if (slot.load(std::memory_order_relaxed) == key) return true;
+        }
+        return false;
+    }
+
+    void insert(std::uint64_t hash);
+
+    // Forgets every entry; not safe while other threads use the table
+    void clear();
+
+    std::size_t capacity() const {
+        return (mask + 1) * kBucketSize;
+    }
+
+private:
+    static constexpr int kBucketSize = 4;
+
+    struct alignas(kBucketSize * sizeof(std::uint64_t)) Bucket {
+        std::array<std::atomic<std::uint64_t>, kBucketSize> slots;
+    };
+
+    std::unique_ptr<Bucket[]> buckets;
+    std::size_t mask;  // Bucket count - 1
+};
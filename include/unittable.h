@@ -0,0 +1,101 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+// What a unit of a UnitTable is, for messages and drawing
+enum class UnitKind : std::uint8_t {
+    Row,
+    Column,
+    Box,       // 3x3 box, or an irregular Jigsaw region
+    Diagonal,
+    Window     // One of Windoku's four extra boxes
+};
+
+// The "all different" units of a Sudoku variant as data: each unit is 9
+// cells that hold the digits 1-9 once each. The table also lists the units
+// of every cell and its peers (the other cells sharing a unit with it), so
+// the solver, the contradiction check and the grid's validation walk flat
+// arrays and any variant is just another table.
+//
+// Units 0-8 are the rows, 9-17 the columns and 18-26 the boxes (or Jigsaw
+// regions); extra units such as diagonals follow.
+class UnitTable {
+public:
+    static constexpr int kMaxUnits = 40;
+    static constexpr int kMaxUnitsPerCell = 6;
+    static constexpr int kMaxPeers = 40;
+
+    using Unit = std::array<std::uint8_t, 9>;
+
+    // Classic rows, columns and 3x3 boxes
+    UnitTable();
+
+    // Shared classic table, the default everywhere a table is taken
+    static const UnitTable& classic();
+
+    // Sudoku X: the two main diagonals
+    bool addDiagonals();
+    // Windoku: the boxes with top-left corners at R2C2, R2C6, R6C2, R6C6
+    bool addWindows();
+    // Jigsaw: regions[cell] (0-8) replaces the boxes; false unless every
+    // region has exactly 9 cells
+    bool setRegions(const std::array<std::uint8_t, 81>& regions);
+    // Any other unit; false if the table is full, the cells are not 9
+    // distinct cells or a cell would get too many units or peers
+    bool addUnit(const Unit& cells, UnitKind kind);
+
+    // True for the plain rows, columns and 3x3 boxes, which is what the
+    // symmetry-based cache and the batch fast path assume
+    bool isClassic() const {
+        return unitCount == 27 && !irregular;
+    }
+
+    int size() const {
+        return unitCount;
+    }
+
+    const Unit& cells(int unit) const {
+        return units[unit];
+    }
+
+    UnitKind kind(int unit) const {
+        return kinds[unit];
+    }
+
+    std::span<const std::uint8_t> unitsOf(int cell) const {
+        return {cellUnits[cell].units.data(), cellUnits[cell].count};
+    }
+
+    // Bit u set for each unit u holding the cell
+    std::uint64_t unitMask(int cell) const {
+        return cellMasks[cell];
+    }
+
+    std::span<const std::uint8_t> peers(int cell) const {
+        return {cellPeers[cell].data(), peerCount[cell]};
+    }
+
+private:
+    bool rebuild();
+
+    std::array<Unit, kMaxUnits> units{};
+    std::array<UnitKind, kMaxUnits> kinds{};
+    int unitCount = 0;
+    bool irregular = false;  // Boxes replaced by Jigsaw regions
+
+    // Count and units side by side, so the solver's hot loop reads one word
+    struct CellUnits {
+        std::uint8_t count = 0;
+        std::array<std::uint8_t, kMaxUnitsPerCell> units{};
+    };
+
+    std::array<CellUnits, 81> cellUnits{};
+    std::array<std::uint64_t, 81> cellMasks{};
+    std::array<std::array<std::uint8_t, kMaxPeers>, 81> cellPeers{};
+    std::array<std::uint8_t, 81> peerCount{};
+};
+
+// Jigsaw layout as 81 characters '1'-'9' naming each cell's region
+bool parseRegions(std::string_view text, std::array<std::uint8_t, 81>& regions);
@@ -0,0 +1,912 @@
+#include "batchsolver.h"
+#include "canonical.h"
+#include "enumeration.h"
+#include "killer.h"
+#include "mappedfile.h"
+#include "minimality.h"
+#include "multigrid.h"
+#include "portfolio.h"
+#include "propagator.h"
+#include "puzzleio.h"
+#include "solutioncache.h"
+#include "solutionstore.h"
+#include "solveservice.h"
+#include "solver.h"
+#include "threadpool.h"
+#include "unittable.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_set>
+
+// Headless batch solver: reads a puzzle collection (SDM, .sdk or CSV),
+// writes one solution per puzzle and, with --stats, the solver counters
+// for each puzzle plus a summary on stderr.
+
+namespace {
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [options] [puzzle-file]\n"
+              << "Reads puzzles from the file, or stdin when no file is given.\n"
+              << "  --stats           print solver counters per puzzle and in total\n"
+              << "  --format NAME     input format: sdm, sdk or csv (default from extension)\n"
+              << "  --output PATH     write puzzle/solution records to a collection file\n"
+              << "                    (format from extension) instead of stdout; sdm and\n"
+              << "                    sdk files get the solved grid, or the puzzle if unsolved\n"
+              << "  --threads N       worker threads for file input (default: all cores)\n"
+              << "  --max-nodes N     give up on a puzzle after N search nodes\n"
+              << "  --timeout-ms N    give up on a puzzle after N milliseconds\n"
+              << "  --cache N         remember up to N solutions by canonical form, so\n"
+              << "                    repeated or equivalent puzzles skip the search\n"
+              << "  --store PATH      keep solutions in an on-disk store (PATH.log and\n"
+              << "                    PATH.idx) that later runs answer from\n"
+              << "  --engine NAME     backtracking (default); cdcl, a clause-learning SAT\n"
+              << "                    search for adversarial puzzles; or portfolio, which\n"
+              << "                    races both, a rotated search and MRV per puzzle\n"
+              << "  --rules NAME      classic, diagonal, windoku or diagonal-windoku\n"
+              << "  --regions MAP     Jigsaw regions: 81 characters 1-9 naming each cell's\n"
+              << "                    region, in place of the 3x3 boxes\n"
+              << "  --killer          read Killer puzzles, one per line: givens, cage map\n"
+              << "                    and comma-separated cage sums\n"
+              << "  --samurai         read Samurai puzzles, one per line: the five grids'\n"
+              << "                    givens (top-left, top-right, centre, bottom-left,\n"
+              << "                    bottom-right) separated by spaces\n"
+              << "  --variant         read variant puzzles, one per line: givens, then any of\n"
+              << "                    anti-knight, anti-king, non-consecutive,\n"
+              << "                    thermo=C,C,... and arrow=C:C,C,... (cells 0-80)\n"
+              << "  --count N         instead of solving, print each puzzle's number of\n"
+              << "                    solutions, stopping at N (0 counts them all)\n"
+              << "  --enumerate PATH  like --count, also streaming every solution counted\n"
+              << "                    to a delta-compressed solution file; each puzzle's\n"
+              << "                    subtrees are searched on --threads threads\n"
+              << "  --decode PATH     print the solutions in a solution file, a '#' line\n"
+              << "                    opening each puzzle's\n"
+              << "  --minimal         instead of solving, print 'minimal' for each minimal\n"
+              << "                    puzzle, or 'redundant' and the cells (0-80) of clues\n"
+              << "                    that can go, or 'not_unique' or 'unsolvable'\n"
+              << "  --reduce          instead of solving, remove clues from each puzzle until\n"
+              << "                    it is minimal and print the result\n"
+              << "  --canonical       instead of solving, print each puzzle's canonical ID\n"
+              << "                    and canonical form (equal for equivalent puzzles)\n"
+              << "  --serve ADDRESS   run as a solve service on a Unix socket path or a\n"
+              << "                    localhost TCP [HOST:]PORT until interrupted\n"
+              << "  --connect ADDRESS send the puzzles to a running service instead of\n"
+              << "                    solving them here\n";
+}
+
+const char* statusName(SolveStatus status) {
+    switch (status) {
+    case SolveStatus::Solved: return "solved";
+    case SolveStatus::Unsolvable: return "unsolvable";
+    case SolveStatus::Cancelled: return "cancelled";
+    case SolveStatus::TimedOut: return "timeout";
+    }
+    return "unknown";
+}
+
+// Records solved together: a batch read from stdin, or one block of a
+// mapped file handled by a worker thread
+struct SolvedBlock {
+    std::vector<PuzzleRecord> records;
+    std::vector<Board> solutions;
+    std::vector<SolveStatus> status;
+    std::vector<SolveStats> stats;
+    std::vector<std::uint64_t> ids;  // Canonical IDs in --canonical mode
+    std::uint64_t rejected = 0;
+};
+
+struct RunOptions {
+    BatchOptions solver;
+    bool canonicalOnly = false;
+};
+
+void solveBlock(SolvedBlock& block, const RunOptions& options) {
+    std::size_t count = block.records.size();
+    if (options.canonicalOnly) {
+        // solutions[] holds the canonical forms in this mode
+        block.solutions.resize(count);
+        block.ids.resize(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            block.solutions[i] = canonicalize(block.records[i].puzzle).board;
+            block.ids[i] = canonicalId(block.solutions[i]);
+        }
+        return;
+    }
+
+    std::vector<Board> puzzles(count);
+    for (std::size_t i = 0; i < count; ++i) puzzles[i] = block.records[i].puzzle;
+
+    block.solutions.resize(count);
+    block.status.resize(count);
+    block.stats.resize(count);
+    solveBatch(puzzles, block.solutions, options.solver, block.status, block.stats);
+}
+
+// Parse and solve one block straight from the mapped pages
+SolvedBlock solveMappedBlock(std::string_view data, PuzzleFormat format, bool atFileStart,
+                             const RunOptions& options) {
+    SolvedBlock block;
+    block.records.reserve(data.size() / 82 + 1);
+    PuzzleReader reader(format, atFileStart);
+    auto onRecord = [&block](const PuzzleRecord& record) { block.records.push_back(record); };
+    reader.feed(data, onRecord);
+    reader.finish(onRecord);
+    block.rejected = reader.rejectedCount();
+
+    solveBlock(block, options);
+    return block;
+}
+
+// Writes solved blocks in input order and keeps the running totals
+struct BatchOutput {
+    bool printStats = false;
+    bool canonicalOnly = false;
+    std::unique_ptr<PuzzleWriter> writer;
+    std::unordered_set<std::uint64_t> classes;  // Distinct IDs seen in --canonical mode
+
+    SolveStats totals;
+    std::uint64_t solved = 0;
+    std::uint64_t failed = 0;
+    std::uint64_t timedOut = 0;
+    std::uint64_t mismatched = 0;
+    std::uint64_t rejected = 0;
+
+    void emit(SolvedBlock& block) {
+        rejected += block.rejected;
+        if (canonicalOnly) {
+            emitCanonical(block);
+            return;
+        }
+        for (std::size_t i = 0; i < block.records.size(); ++i) {
+            PuzzleRecord& record = block.records[i];
+            const Board& solution = block.solutions[i];
+            bool ok = block.status[i] == SolveStatus::Solved;
+            if (ok) {
+                solved++;
+                // CSV datasets ship their own solutions; flag any disagreement
+                if (record.hasSolution && record.solution != solution) mismatched++;
+            } else if (block.status[i] == SolveStatus::TimedOut) {
+                timedOut++;
+            } else {
+                failed++;
+            }
+
+            if (writer) {
+                record.solution = solution;
+                record.hasSolution = ok;
+                writer->write(record);
+            } else {
+                std::cout << (ok ? formatBoard(solution) : std::string(statusName(block.status[i]))) << "\n";
+            }
+
+            totals += block.stats[i];
+            if (printStats) {
+                std::cout << "# " << block.stats[i] << "\n";
+            }
+        }
+    }
+
+    void emitCanonical(const SolvedBlock& block) {
+        char id[17];
+        for (std::size_t i = 0; i < block.records.size(); ++i) {
+            std::snprintf(id, sizeof(id), "%016llx", static_cast<unsigned long long>(block.ids[i]));
+            std::cout << id << " " << formatBoard(block.solutions[i]) << "\n";
+            if (printStats) classes.insert(block.ids[i]);
+        }
+        solved += block.records.size();
+    }
+};
+
+// Records solved at a time when streaming from stdin
+constexpr std::size_t kStreamBatchSize = 4096;
+// Mapped files are cut into blocks of about this many bytes per task
+constexpr std::size_t kMappedBlockBytes = 256 << 10;
+
+void solveStream(std::FILE* input, PuzzleFormat format, const RunOptions& options, BatchOutput& output) {
+    SolvedBlock block;
+    block.records.reserve(kStreamBatchSize);
+    auto onRecord = [&](const PuzzleRecord& record) {
+        block.records.push_back(record);
+        if (block.records.size() == kStreamBatchSize) {
+            solveBlock(block, options);
+            output.emit(block);
+            block.records.clear();
+        }
+    };
+
+    PuzzleReader reader(format);
+    std::vector<char> buffer(1 << 16);
+    std::size_t length;
+    while ((length = std::fread(buffer.data(), 1, buffer.size(), input)) > 0) {
+        reader.feed(std::string_view(buffer.data(), length), onRecord);
+    }
+    reader.finish(onRecord);
+
+    solveBlock(block, options);
+    output.emit(block);
+    output.rejected += reader.rejectedCount();
+}
+
+void solveMapped(const MappedFile& file, PuzzleFormat format, std::size_t threads,
+                 const RunOptions& options, BatchOutput& output) {
+    std::vector<std::string_view> blocks = splitRecordBlocks(file.view(), format, kMappedBlockBytes);
+    ThreadPool pool(threads);
+
+    // Keep a few blocks per worker in flight so output stays in input
+    // order without holding the results for the whole file
+    std::size_t window = pool.size() * 4;
+    std::deque<std::future<SolvedBlock>> pending;
+    std::size_t next = 0;
+    while (next < blocks.size() || !pending.empty()) {
+        while (next < blocks.size() && pending.size() < window) {
+            std::string_view data = blocks[next];
+            bool atFileStart = next == 0;
+            pending.push_back(pool.submit([data, format, atFileStart, &options] {
+                return solveMappedBlock(data, format, atFileStart, options);
+            }));
+            next++;
+        }
+        SolvedBlock block = pending.front().get();
+        pending.pop_front();
+        output.emit(block);
+    }
+}
+
+// Builds the unit table for --rules and --regions
+bool makeUnits(const char* rules, const char* regions, UnitTable& units) {
+    if (regions) {
+        std::array<std::uint8_t, 81> layout;
+        if (!parseRegions(regions, layout) || !units.setRegions(layout)) return false;
+    }
+    if (!rules || std::strcmp(rules, "classic") == 0) return true;
+    if (std::strcmp(rules, "diagonal") == 0) return units.addDiagonals();
+    if (std::strcmp(rules, "windoku") == 0) return units.addWindows();
+    if (std::strcmp(rules, "diagonal-windoku") == 0) return units.addDiagonals() && units.addWindows();
+    return false;
+}
+
+// --killer: one puzzle per line in the parseKiller() format, solved in
+// input order on the calling thread
+void solveKillers(std::istream& input, const UnitTable& units, const SolveLimits& limits, BatchOutput& output) {
+    KillerSolver solver;
+    solver.setUnits(units);
+    std::string line;
+    while (std::getline(input, line)) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+        KillerPuzzle puzzle;
+        if (!parseKiller(line, puzzle)) {
+            output.rejected++;
+            continue;
+        }
+
+        Board solution;
+        SolveStatus status = solver.solve(puzzle, solution, limits);
+        if (status == SolveStatus::Solved) output.solved++;
+        else if (status == SolveStatus::TimedOut) output.timedOut++;
+        else output.failed++;
+        std::cout << (status == SolveStatus::Solved ? formatBoard(solution) : std::string(statusName(status))) << "\n";
+
+        output.totals += solver.getStats();
+        if (output.printStats) std::cout << "# " << solver.getStats() << "\n";
+    }
+}
+
+// --samurai: one puzzle per line in the parseMultiGrid() format, solved in
+// input order on the calling thread
+void solveSamurais(std::istream& input, const SolveLimits& limits, BatchOutput& output) {
+    const MultiGrid& layout = MultiGrid::samurai();
+    MultiGridSolver solver(layout);
+    std::vector<Board> grids, solution(layout.gridCount());
+    std::string line;
+    while (std::getline(input, line)) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+        if (!parseMultiGrid(line, layout, grids)) {
+            output.rejected++;
+            continue;
+        }
+
+        SolveStatus status = solver.solve(grids, solution, limits);
+        if (status == SolveStatus::Solved) output.solved++;
+        else if (status == SolveStatus::TimedOut) output.timedOut++;
+        else output.failed++;
+        std::cout << (status == SolveStatus::Solved ? formatMultiGrid(solution) : std::string(statusName(status))) << "\n";
+
+        output.totals += solver.getStats();
+        if (output.printStats) std::cout << "# " << solver.getStats() << "\n";
+    }
+}
+
+// --variant: one puzzle per line in the parseVariant() format, solved in
+// input order on the calling thread
+void solveVariants(std::istream& input, const UnitTable& units, const SolveLimits& limits, BatchOutput& output) {
+    ConstraintSolver solver;
+    solver.setUnits(units);
+    std::string line;
+    while (std::getline(input, line)) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+        VariantPuzzle puzzle;
+        if (!parseVariant(line, puzzle)) {
+            output.rejected++;
+            continue;
+        }
+
+        addPropagators(puzzle, solver);
+        Board solution;
+        SolveStatus status = solver.solve(puzzle.givens, solution, limits);
+        if (status == SolveStatus::Solved) output.solved++;
+        else if (status == SolveStatus::TimedOut) output.timedOut++;
+        else output.failed++;
+        std::cout << (status == SolveStatus::Solved ? formatBoard(solution) : std::string(statusName(status))) << "\n";
+
+        output.totals += solver.getStats();
+        if (output.printStats) std::cout << "# " << solver.getStats() << "\n";
+    }
+}
+
+// --count: each puzzle's number of solutions, up to maxCount, in input
+// order on the calling thread. One transposition table serves the whole
+// run, so related puzzles skip the dead ends they share. With a solution
+// writer (--enumerate) the solutions themselves are streamed to it too,
+// the subtrees of each puzzle searched on the given number of threads.
+bool countPuzzles(const char* inputPath, PuzzleFormat format, const UnitTable& units, std::uint64_t maxCount,
+                  const SolveLimits& limits, SolutionWriter* solutions, std::size_t threads, BatchOutput& output) {
+    TranspositionTable table;
+    SudokuSolver solver;
+    solver.setUnits(units);
+    solver.setTranspositions(&table);
+    SolverWorkspace& ws = SudokuSolver::threadWorkspace();
+    EnumerateOptions enumerate;
+    enumerate.threads = threads;
+    enumerate.maxCount = maxCount;
+    enumerate.limits = limits;
+    enumerate.units = &units;
+    enumerate.transpositions = &table;
+    auto onRecord = [&](const PuzzleRecord& record) {
+        std::uint64_t count;
+        SolveStatus status;
+        SolveStats stats;
+        if (solutions) {
+            auto onBlock = [&](std::span<const std::uint8_t> block) { return solutions->write(block); };
+            status = enumerateSolutions(record.puzzle, enumerate, onBlock, count, &stats);
+            solutions->endPuzzle();
+        } else {
+            status = solver.countSolutions(record.puzzle, ws, count, maxCount, limits);
+            stats = solver.getStats();
+        }
+        if (status == SolveStatus::Solved) output.solved++;
+        else if (status == SolveStatus::TimedOut) output.timedOut++;
+        else output.failed++;
+        if (status == SolveStatus::TimedOut) std::cout << statusName(status) << " " << count << "\n";
+        else std::cout << count << "\n";
+
+        output.totals += stats;
+        if (output.printStats) std::cout << "# " << stats << "\n";
+    };
+
+    if (inputPath) return readPuzzleFile(inputPath, format, onRecord, &output.rejected);
+    PuzzleReader reader(format);
+    std::vector<char> buffer(1 << 16);
+    std::size_t length;
+    while ((length = std::fread(buffer.data(), 1, buffer.size(), stdin)) > 0) {
+        reader.feed(std::string_view(buffer.data(), length), onRecord);
+    }
+    reader.finish(onRecord);
+    output.rejected += reader.rejectedCount();
+    return true;
+}
+
+// --minimal and --reduce: each puzzle checked or reduced in input order,
+// the clue tests of one puzzle running on the pool's threads. Like
+// --count, one transposition table serves the whole run.
+bool minimalPuzzles(const char* inputPath, PuzzleFormat format, const UnitTable& units, bool reduce,
+                    const SolveLimits& limits, std::size_t threads, BatchOutput& output) {
+    TranspositionTable table;
+    ThreadPool pool(threads);
+    MinimalityOptions options;
+    options.pool = pool.size() > 1 ? &pool : nullptr;
+    options.limits = limits;
+    options.units = &units;
+    options.transpositions = &table;
+    auto onRecord = [&](const PuzzleRecord& record) {
+        SolveStats stats;
+        SolveStatus status;
+        bool settled;  // Minimal, or reduced to a minimal puzzle
+        if (reduce) {
+            Board minimal;
+            std::uint64_t solutions = 0;
+            status = reduceToMinimal(record.puzzle, options, minimal, &stats, &solutions);
+            settled = status == SolveStatus::Solved;
+            if (settled) std::cout << formatBoard(minimal) << "\n";
+            else if (status != SolveStatus::Unsolvable) std::cout << statusName(status) << "\n";
+            else std::cout << (solutions == 0 ? "unsolvable" : "not_unique") << "\n";
+        } else {
+            MinimalityReport report;
+            status = checkMinimality(record.puzzle, options, report, &stats);
+            settled = status == SolveStatus::Solved && report.minimal();
+            if (status != SolveStatus::Solved && status != SolveStatus::Unsolvable) {
+                std::cout << statusName(status) << "\n";
+            } else if (report.solutions != 1) {
+                std::cout << (report.solutions == 0 ? "unsolvable" : "not_unique") << "\n";
+            } else if (report.redundant.empty()) {
+                std::cout << "minimal\n";
+            } else {
+                std::cout << "redundant";
+                for (int cell : report.redundant) std::cout << " " << cell;
+                std::cout << "\n";
+            }
+        }
+        if (settled) output.solved++;
+        else if (status == SolveStatus::TimedOut) output.timedOut++;
+        else output.failed++;
+
+        output.totals += stats;
+        if (output.printStats) std::cout << "# " << stats << "\n";
+    };
+
+    if (inputPath) return readPuzzleFile(inputPath, format, onRecord, &output.rejected);
+    PuzzleReader reader(format);
+    std::vector<char> buffer(1 << 16);
+    std::size_t length;
+    while ((length = std::fread(buffer.data(), 1, buffer.size(), stdin)) > 0) {
+        reader.feed(std::string_view(buffer.data(), length), onRecord);
+    }
+    reader.finish(onRecord);
+    output.rejected += reader.rejectedCount();
+    return true;
+}
+
+// Boards per request sent to a solve service
+constexpr std::size_t kClientBatchSize = 1024;
+
+// Client side of --connect: the calling thread parses and sends batches
+// while a receiver thread writes the responses back in input order
+bool solveRemote(SolveClient& client, const char* inputPath, PuzzleFormat format, BatchOutput& output) {
+    std::mutex mutex;
+    std::map<std::uint32_t, SolvedBlock> sent;  // Awaiting a response, by tag
+    bool receiveFailed = false;
+
+    std::thread receiver([&] {
+        std::uint32_t nextTag = 0;
+        std::map<std::uint32_t, SolvedBlock> ready;
+        std::uint32_t tag;
+        std::vector<SolveStatus> status;
+        std::vector<Board> solutions;
+        bool unexpected = false;  // A response matching no request
+        while (client.receiveBatch(tag, status, solutions)) {
+            SolvedBlock block;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                auto it = sent.find(tag);
+                if (it == sent.end() || it->second.records.size() != status.size()) {
+                    unexpected = true;
+                    break;
+                }
+                block = std::move(it->second);
+                sent.erase(it);
+            }
+            block.status = status;
+            block.solutions = solutions;
+            block.stats.assign(status.size(), SolveStats());
+            ready.emplace(tag, std::move(block));
+            // Responses can overtake each other; emit them in request order
+            for (auto it = ready.find(nextTag); it != ready.end(); it = ready.find(++nextTag)) {
+                output.emit(it->second);
+                ready.erase(it);
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        receiveFailed = unexpected || !sent.empty();
+        // Nobody reads the responses any more, so the server would stop
+        // reading requests and the sender block for good; make it fail
+        if (receiveFailed) client.abort();
+    });
+
+    std::uint32_t nextTag = 0;
+    bool sendFailed = false;
+    SolvedBlock block;
+    std::vector<Board> puzzles;
+    auto sendBlock = [&] {
+        if (block.records.empty() || sendFailed) return;
+        puzzles.resize(block.records.size());
+        for (std::size_t i = 0; i < puzzles.size(); ++i) puzzles[i] = block.records[i].puzzle;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            sent.emplace(nextTag, std::move(block));
+        }
+        sendFailed = !client.sendBatch(nextTag++, puzzles);
+        block = SolvedBlock();
+    };
+    auto onRecord = [&](const PuzzleRecord& record) {
+        block.records.push_back(record);
+        if (block.records.size() == kClientBatchSize) sendBlock();
+    };
+
+    // The receiver updates output as responses arrive, so rejects are
+    // counted apart until it is done
+    bool readOk = true;
+    std::uint64_t rejected = 0;
+    if (inputPath) {
+        readOk = readPuzzleFile(inputPath, format, onRecord, &rejected);
+    } else {
+        PuzzleReader reader(format);
+        std::vector<char> buffer(1 << 16);
+        std::size_t length;
+        while ((length = std::fread(buffer.data(), 1, buffer.size(), stdin)) > 0) {
+            reader.feed(std::string_view(buffer.data(), length), onRecord);
+        }
+        reader.finish(onRecord);
+        rejected = reader.rejectedCount();
+    }
+    sendBlock();
+    client.finishSending();
+    receiver.join();
+    output.rejected += rejected;
+
+    if (!readOk) std::cerr << "Cannot read " << inputPath << "\n";
+    else if (sendFailed || receiveFailed) std::cerr << "Connection to the solve service was lost\n";
+    return readOk && !sendFailed && !receiveFailed;
+}
+
+SolveServer* activeServer = nullptr;
+
+void stopServer(int) {
+    if (activeServer) activeServer->stop();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::ios::sync_with_stdio(false);
+
+    BatchOutput output;
+    const char* inputPath = nullptr;
+    const char* outputPath = nullptr;
+    const char* formatName = nullptr;
+    std::size_t threads = 0;
+    std::size_t cacheSize = 0;
+    const char* storePath = nullptr;
+    SolveLimits limits;
+    const char* serveAddress = nullptr;
+    const char* connectAddress = nullptr;
+    bool killer = false;
+    bool samurai = false;
+    bool variant = false;
+    bool count = false;
+    bool minimal = false;
+    bool reduce = false;
+    std::uint64_t maxCount = 0;
+    const char* enumeratePath = nullptr;
+    const char* decodePath = nullptr;
+    const char* rulesName = nullptr;
+    const char* engineName = nullptr;
+    const char* regionsText = nullptr;
+
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--stats") == 0) {
+            output.printStats = true;
+        } else if (std::strcmp(argv[i], "--format") == 0 && hasValue) {
+            formatName = argv[++i];
+        } else if (std::strcmp(argv[i], "--output") == 0 && hasValue) {
+            outputPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--threads") == 0 && hasValue) {
+            threads = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--max-nodes") == 0 && hasValue) {
+            limits.maxNodes = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--timeout-ms") == 0 && hasValue) {
+            limits.timeBudget = std::chrono::milliseconds(std::strtoull(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--cache") == 0 && hasValue) {
+            cacheSize = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--store") == 0 && hasValue) {
+            storePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--serve") == 0 && hasValue) {
+            serveAddress = argv[++i];
+        } else if (std::strcmp(argv[i], "--connect") == 0 && hasValue) {
+            connectAddress = argv[++i];
+        } else if (std::strcmp(argv[i], "--engine") == 0 && hasValue) {
+            engineName = argv[++i];
+        } else if (std::strcmp(argv[i], "--rules") == 0 && hasValue) {
+            rulesName = argv[++i];
+        } else if (std::strcmp(argv[i], "--regions") == 0 && hasValue) {
+            regionsText = argv[++i];
+        } else if (std::strcmp(argv[i], "--killer") == 0) {
+            killer = true;
+        } else if (std::strcmp(argv[i], "--samurai") == 0) {
+            samurai = true;
+        } else if (std::strcmp(argv[i], "--count") == 0 && hasValue) {
+            count = true;
+            maxCount = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--enumerate") == 0 && hasValue) {
+            enumeratePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--decode") == 0 && hasValue) {
+            decodePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--variant") == 0) {
+            variant = true;
+        } else if (std::strcmp(argv[i], "--minimal") == 0) {
+            minimal = true;
+        } else if (std::strcmp(argv[i], "--reduce") == 0) {
+            reduce = true;
+        } else if (std::strcmp(argv[i], "--canonical") == 0) {
+            output.canonicalOnly = true;
+        } else if (std::strcmp(argv[i], "--help") == 0) {
+            printUsage(argv[0]);
+            return 0;
+        } else if (!inputPath && argv[i][0] != '-') {
+            inputPath = argv[i];
+        } else {
+            printUsage(argv[0]);
+            return 2;
+        }
+    }
+
+    // --decode stands alone: it prints a solution file and exits
+    if (decodePath) {
+        if (argc != 3) {
+            std::cerr << "--decode takes no other options\n";
+            return 2;
+        }
+        std::size_t current = SIZE_MAX;
+        bool ok = readSolutionFile(decodePath, [&](std::size_t puzzle, const Board& solution) {
+            if (puzzle != current) std::cout << "# puzzle " << puzzle + 1 << "\n";
+            current = puzzle;
+            std::cout << formatBoard(solution) << "\n";
+        });
+        if (!ok) {
+            std::cerr << "Cannot read " << decodePath << " as a solution file\n";
+            return 1;
+        }
+        return 0;
+    }
+    if (enumeratePath) count = true;
+
+    PuzzleFormat format = inputPath ? formatFromPath(inputPath) : PuzzleFormat::Sdm;
+    if (formatName && !formatFromName(formatName, format)) {
+        std::cerr << "Unknown format " << formatName << "\n";
+        return 2;
+    }
+
+    SolverEngine engine = SolverEngine::Backtracking;
+    if (engineName && std::strcmp(engineName, "cdcl") == 0) {
+        engine = SolverEngine::Cdcl;
+    } else if (engineName && std::strcmp(engineName, "portfolio") == 0) {
+        engine = SolverEngine::Portfolio;
+    } else if (engineName && std::strcmp(engineName, "backtracking") != 0) {
+        std::cerr << "Unknown engine " << engineName << "\n";
+        return 2;
+    }
+
+    UnitTable units;
+    if (!makeUnits(rulesName, regionsText, units)) {
+        std::cerr << "Invalid --rules or --regions\n";
+        return 2;
+    }
+    // The canonical form, the cache and the store rely on classic symmetries
+    if (!units.isClassic() && (serveAddress || connectAddress || output.canonicalOnly || cacheSize > 0 || storePath)) {
+        std::cerr << "Variant rules cannot be combined with --serve, --connect, --canonical, --cache or --store\n";
+        return 2;
+    }
+
+    if (serveAddress && (connectAddress || inputPath || outputPath || output.canonicalOnly)) {
+        std::cerr << "--serve takes no input, output or other mode\n";
+        return 2;
+    }
+    if (connectAddress && (output.canonicalOnly || cacheSize > 0 || storePath || limits.bounded())) {
+        std::cerr << "--connect cannot be combined with --canonical, --cache, --store or limits\n";
+        return 2;
+    }
+    if (killer && (serveAddress || connectAddress || outputPath || formatName || output.canonicalOnly ||
+                   cacheSize > 0 || storePath)) {
+        std::cerr << "--killer only combines with --stats and limits\n";
+        return 2;
+    }
+    if (samurai && (killer || serveAddress || connectAddress || outputPath || formatName || output.canonicalOnly ||
+                    cacheSize > 0 || storePath || !units.isClassic())) {
+        std::cerr << "--samurai only combines with --stats and limits\n";
+        return 2;
+    }
+    if (variant && (killer || samurai || serveAddress || connectAddress || outputPath || formatName ||
+                    output.canonicalOnly || cacheSize > 0 || storePath)) {
+        std::cerr << "--variant only combines with --rules, --regions, --stats and limits\n";
+        return 2;
+    }
+    if (count && (killer || samurai || variant || serveAddress || connectAddress || outputPath ||
+                  output.canonicalOnly || cacheSize > 0 || storePath)) {
+        std::cerr << "--count and --enumerate only combine with --format, --rules, --regions, --stats and limits\n";
+        return 2;
+    }
+    if ((minimal || reduce) && (count || killer || samurai || variant || serveAddress || connectAddress ||
+                                outputPath || output.canonicalOnly || cacheSize > 0 || storePath ||
+                                (minimal && reduce))) {
+        std::cerr << "--minimal and --reduce only combine with --format, --rules, --regions, --threads,\n"
+                  << "--stats and limits\n";
+        return 2;
+    }
+    if (engineName && (killer || samurai || variant || count || minimal || reduce || connectAddress)) {
+        std::cerr << "--engine cannot be combined with --killer, --samurai, --variant, --count, --minimal,\n"
+                  << "--reduce or --connect\n";
+        return 2;
+    }
+    if (outputPath && output.canonicalOnly) {
+        std::cerr << "--output cannot be combined with --canonical\n";
+        return 2;
+    }
+    if (outputPath) {
+        output.writer = std::make_unique<PuzzleWriter>(outputPath, formatFromPath(outputPath));
+        if (!output.writer->isOpen()) {
+            std::cerr << "Cannot write " << outputPath << "\n";
+            return 1;
+        }
+    }
+
+    RunOptions options;
+    options.canonicalOnly = output.canonicalOnly;
+    options.solver.limits = limits;
+    if (!units.isClassic()) options.solver.units = &units;
+    options.solver.engine = engine;
+    std::unique_ptr<SolutionCache> cache;
+    if (cacheSize > 0) {
+        cache = std::make_unique<SolutionCache>(cacheSize);
+        options.solver.cache = cache.get();
+    }
+    SolutionStore store;
+    if (storePath && !output.canonicalOnly) {
+        if (!store.open(storePath)) {
+            std::cerr << "Cannot open store " << storePath << "\n";
+            return 1;
+        }
+        options.solver.store = &store;
+    }
+
+    if (serveAddress) {
+        ServiceOptions serviceOptions;
+        serviceOptions.threads = threads;
+        serviceOptions.solver = options.solver;
+        SolveServer server(serviceOptions);
+        if (!server.listen(serveAddress)) {
+            std::cerr << "Cannot listen on " << serveAddress << "\n";
+            return 1;
+        }
+        activeServer = &server;
+        std::signal(SIGINT, stopServer);
+        std::signal(SIGTERM, stopServer);
+        server.run();
+        activeServer = nullptr;
+        return store.isOpen() && !store.flush() ? 1 : 0;
+    }
+
+    if (connectAddress) {
+        auto started = std::chrono::steady_clock::now();
+        // Counters stay on the server; --stats reports the throughput instead
+        bool printRate = output.printStats;
+        output.printStats = false;
+        SolveClient client;
+        if (!client.connect(connectAddress)) {
+            std::cerr << "Cannot connect to " << connectAddress << "\n";
+            return 1;
+        }
+        if (!solveRemote(client, inputPath, format, output)) return 1;
+        if (output.writer && !output.writer->close()) {
+            std::cerr << "Error writing " << outputPath << "\n";
+            return 1;
+        }
+        if (printRate || output.rejected > 0 || output.mismatched > 0 || output.timedOut > 0) {
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+            std::cerr << "solved=" << output.solved << " failed=" << output.failed
+                      << " timed_out=" << output.timedOut << " rejected=" << output.rejected
+                      << " mismatched=" << output.mismatched;
+            if (printRate) {
+                std::cerr << " elapsed_ms=" << static_cast<std::int64_t>(seconds * 1000)
+                          << " puzzles_per_s="
+                          << static_cast<std::int64_t>((output.solved + output.failed + output.timedOut) /
+                                                    std::max(seconds, 1e-9));
+            }
+            std::cerr << "\n";
+        }
+        return output.failed == 0 && output.timedOut == 0 && output.rejected == 0 ? 0 : 1;
+    }
+
+    if (count) {
+        std::unique_ptr<SolutionWriter> solutions;
+        if (enumeratePath) {
+            solutions = std::make_unique<SolutionWriter>(enumeratePath);
+            if (!solutions->isOpen()) {
+                std::cerr << "Cannot write " << enumeratePath << "\n";
+                return 1;
+            }
+        }
+        if (!countPuzzles(inputPath, format, units, maxCount, limits, solutions.get(), threads, output)) {
+            std::cerr << "Cannot read " << inputPath << "\n";
+            return 1;
+        }
+        if (solutions && !solutions->close()) {
+            std::cerr << "Error writing " << enumeratePath << "\n";
+            return 1;
+        }
+    } else if (minimal || reduce) {
+        if (!minimalPuzzles(inputPath, format, units, reduce, limits, threads, output)) {
+            std::cerr << "Cannot read " << inputPath << "\n";
+            return 1;
+        }
+    } else if (killer || samurai || variant) {
+        std::ifstream file;
+        if (inputPath) {
+            file.open(inputPath);
+            if (!file) {
+                std::cerr << "Cannot read " << inputPath << "\n";
+                return 1;
+            }
+        }
+        if (killer) solveKillers(inputPath ? file : std::cin, units, limits, output);
+        else if (samurai) solveSamurais(inputPath ? file : std::cin, limits, output);
+        else solveVariants(inputPath ? file : std::cin, units, limits, output);
+    } else if (inputPath) {
+        // Regular files are mapped and solved in parallel; anything that
+        // cannot be mapped (a pipe, a device) is streamed instead
+        MappedFile file;
+        if (file.open(inputPath)) {
+            solveMapped(file, format, threads, options, output);
+        } else {
+            std::FILE* input = std::fopen(inputPath, "rb");
+            if (!input) {
+                std::cerr << "Cannot read " << inputPath << "\n";
+                return 1;
+            }
+            solveStream(input, format, options, output);
+            std::fclose(input);
+        }
+    } else {
+        solveStream(stdin, format, options, output);
+    }
+
+    if (store.isOpen() && !store.flush()) {
+        std::cerr << "Error writing store " << storePath << "\n";
+        return 1;
+    }
+    if (output.writer && !output.writer->close()) {
+        std::cerr << "Error writing " << outputPath << "\n";
+        return 1;
+    }
+
+    if (output.canonicalOnly) {
+        if (output.printStats || output.rejected > 0) {
+            std::cerr << "puzzles=" << output.solved << " rejected=" << output.rejected;
+            if (output.printStats) std::cerr << " classes=" << output.classes.size();
+            std::cerr << "\n";
+        }
+        return output.rejected == 0 ? 0 : 1;
+    }
+
+    if (output.printStats || output.rejected > 0 || output.mismatched > 0 || output.timedOut > 0) {
+        std::cerr << "solved=" << output.solved << " failed=" << output.failed
+                  << " timed_out=" << output.timedOut << " rejected=" << output.rejected
+                  << " mismatched=" << output.mismatched;
+        if (output.printStats) std::cerr << " " << output.totals;
+        if (output.printStats && cache) {
+            CacheCounters counters = cache->counters();
+            std::cerr << " cache_hits=" << counters.hits << " cache_misses=" << counters.misses
+                      << " cache_evictions=" << counters.evictions;
+        }
+        if (output.printStats && store.isOpen()) std::cerr << " store_entries=" << store.size();
+        if (output.printStats && engine == SolverEngine::Portfolio) {
+            std::array<std::uint64_t, kPortfolioEngineCount> wins = PortfolioSolver::totalWins();
+            for (PortfolioEngine winner : kAllPortfolioEngines) {
+                std::cerr << " wins_" << portfolioEngineName(winner) << "=" << wins[static_cast<int>(winner)];
+            }
+        }
+        std::cerr << "\n";
+    }
+    return output.failed == 0 && output.timedOut == 0 && output.rejected == 0 ? 0 : 1;
+}
@@ -0,0 +1,177 @@
+#include "batchsolver.h"
+#include "portfolio.h"
+#include "satsolver.h"
+#include "solutioncache.h"
+#include "solutionstore.h"
+#include "solver.h"
+#include "transposition.h"
+#include <algorithm>
+#include <array>
+#include <memory>
+
+namespace {
+
+// Mask bit for each byte value; values above 9 map to 0 and are rejected
+struct DigitBits {
+    std::array<std::uint16_t, 256> bits{};
+
+    constexpr DigitBits() {
+        for (int d = 1; d <= 9; ++d)
+            bits[d] = static_cast<std::uint16_t>(1u << (d - 1));
+    }
+};
+
+constexpr DigitBits kDigitBits;
+
+// Unit masks for a chunk of boards, indexed [unit][board] so the inner
+// loop walks consecutive boards
+struct ChunkMasks {
+    std::uint16_t row[9][kMaxBatchChunk];
+    std::uint16_t col[9][kMaxBatchChunk];
+    std::uint16_t box[9][kMaxBatchChunk];
+    std::uint16_t conflict[kMaxBatchChunk];
+};
+
+void loadChunk(const Board* puzzles, std::size_t count, ChunkMasks& masks) {
+    std::fill(&masks.row[0][0], &masks.row[0][0] + 9 * kMaxBatchChunk, 0);
+    std::fill(&masks.col[0][0], &masks.col[0][0] + 9 * kMaxBatchChunk, 0);
+    std::fill(&masks.box[0][0], &masks.box[0][0] + 9 * kMaxBatchChunk, 0);
+    std::fill(masks.conflict, masks.conflict + kMaxBatchChunk, 0);
+
+    for (int cell = 0; cell < 81; ++cell) {
+        int row = cell / 9, col = cell % 9;
+        int box = (row / 3) * 3 + col / 3;
+        for (std::size_t k = 0; k < count; ++k) {
+            std::uint8_t num = puzzles[k][cell];
+            std::uint16_t bit = kDigitBits.bits[num];
+            std::uint16_t used = masks.row[row][k] | masks.col[col][k] | masks.box[box][k];
+            masks.conflict[k] |= (used & bit) | (num > 9);
+            masks.row[row][k] |= bit;
+            masks.col[col][k] |= bit;
+            masks.box[box][k] |= bit;
+        }
+    }
+}
+
+} // namespace
+
+std::size_t solveBatch(std::span<const Board> puzzles, std::span<Board> solutions,
+                       const BatchOptions& options,
+                       std::span<SolveStatus> status,
+                       std::span<SolveStats> stats) {
+    std::size_t chunkSize = std::clamp<std::size_t>(options.chunkSize, 1, kMaxBatchChunk);
+    std::size_t count = std::min(puzzles.size(), solutions.size());
+
+    SudokuSolver solver;
+    SolverWorkspace& ws = SudokuSolver::threadWorkspace();
+    bool classic = !options.units || options.units->isClassic();
+    if (options.units) solver.setUnits(*options.units);
+    // The SAT engine's clause buffers are kept per thread, like the workspace
+    thread_local SatSudokuSolver satSolver;
+    bool cdcl = options.engine == SolverEngine::Cdcl;
+    satSolver.setUnits(options.units ? *options.units : UnitTable::classic());
+    // Likewise the portfolio's threads, started the first time it is asked for
+    thread_local std::unique_ptr<PortfolioSolver> portfolio;
+    bool racing = options.engine == SolverEngine::Portfolio;
+    if (racing && !portfolio) portfolio = std::make_unique<PortfolioSolver>();
+    if (racing) portfolio->setUnits(options.units ? *options.units : UnitTable::classic());
+    auto searchStats = [&]() -> const SolveStats& {
+        if (racing) return portfolio->getStats();
+        return cdcl ? satSolver.getStats() : solver.getStats();
+    };
+    SolutionCache* cache = classic ? options.cache : nullptr;
+    SolutionStore* store = classic ? options.store : nullptr;
+    ChunkMasks masks;
+    std::size_t solved = 0;
+
+    for (std::size_t begin = 0; begin < count; begin += chunkSize) {
+        std::size_t chunk = std::min(chunkSize, count - begin);
+
+        PhaseTimer setupTimer;
+        if (classic) loadChunk(puzzles.data() + begin, chunk, masks);
+        std::int64_t setupNs = setupTimer.elapsedNs() / static_cast<std::int64_t>(chunk);
+
+        for (std::size_t k = 0; k < chunk; ++k) {
+            std::size_t index = begin + k;
+            solver.resetStats();
+            satSolver.resetStats();
+            if (racing) portfolio->resetStats();
+
+            // Variants place their givens one by one instead
+            bool ok = classic ? masks.conflict[k] == 0 : solver.prepare(puzzles[index], ws);
+            SolveStatus outcome = SolveStatus::Unsolvable;  // Unless solved or timed out
+            std::int64_t cacheNs = 0;
+            bool cached = false;
+            CanonicalBoard canonical;
+            if (ok && (cache || store)) {
+                PhaseTimer cacheTimer;
+                canonical = canonicalize(puzzles[index]);
+                SolveStatus cachedStatus;
+                Board cachedSolution;
+                if (cache) {
+                    cached = cache->lookup(canonical.board, cachedStatus, cachedSolution);
+                }
+                StoredSolution stored;
+                if (!cached && store && store->lookup(canonical.board, stored)) {
+                    cached = true;
+                    cachedStatus = stored.status;
+                    cachedSolution = stored.solution;
+                    if (cache) cache->insert(canonical.board, cachedStatus, cachedSolution);
+                }
+                if (cached) {
+                    ok = cachedStatus == SolveStatus::Solved;
+                    if (ok) solutions[index] = canonical.transform.invert(cachedSolution);
+                }
+                cacheNs = cacheTimer.elapsedNs();
+            }
+
+            if (ok && !cached) {
+                // Start the search from the chunk's masks instead of replaying
+                // the givens; the classic table numbers rows, columns, boxes
+                if (classic && !cdcl && !racing) {
+                    // Left as prepare() leaves it, hash included, so later
+                    // place and unplace calls keep it right
+                    ws.cells = puzzles[index];
+                    ws.hash = 0;
+                    for (int cell = 0; cell < 81; ++cell) {
+                        if (ws.cells[cell] != 0) ws.hash ^= kZobrist(cell, ws.cells[cell]);
+                    }
+                    for (int unit = 0; unit < 9; ++unit) {
+                        ws.unitUsed[unit] = masks.row[unit][k];
+                        ws.unitUsed[9 + unit] = masks.col[unit][k];
+                        ws.unitUsed[18 + unit] = masks.box[unit][k];
+                    }
+                }
+                if (racing) {
+                    outcome = portfolio->solve(puzzles[index], solutions[index], options.limits);
+                } else {
+                    outcome = cdcl ? satSolver.solve(puzzles[index], solutions[index], options.limits)
+                                   : solver.search(solutions[index], ws, options.limits);
+                }
+                ok = outcome == SolveStatus::Solved;
+                Board canonicalSolution = ok ? canonical.transform.apply(solutions[index]) : canonical.board;
+                // Timed-out and cancelled searches prove nothing about the board
+                bool settled = outcome == SolveStatus::Solved || outcome == SolveStatus::Unsolvable;
+                if (cache && settled) cache->insert(canonical.board, outcome, canonicalSolution);
+                if (store && settled) {
+                    StoredSolution entry;
+                    entry.status = outcome;
+                    entry.solution = canonicalSolution;
+                    entry.stats = searchStats();
+                    entry.grade = gradeFromStats(entry.stats);
+                    store->append(canonical.board, entry);
+                }
+            }
+
+            if (ok) solved++;
+            if (index < status.size()) {
+                status[index] = ok ? SolveStatus::Solved : outcome;
+            }
+            if (index < stats.size()) {
+                stats[index] = searchStats();
+                stats[index].setupNs += setupNs + cacheNs;
+            }
+        }
+    }
+    return solved;
+}
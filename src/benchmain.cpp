@@ -0,0 +1,348 @@
+#include "batchsolver.h"
+#include "solver.h"
+#include "portfolio.h"
+#include "puzzlecorpus.h"
+#include "satsolver.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <string>
+
+// Solver benchmark: runs every engine over the bundled corpora and reports
+// the latency distribution, throughput and heap allocations per solve as
+// JSON (stdout or --json FILE), with a readable summary on stderr.
+
+namespace {
+
+std::atomic<std::uint64_t> allocationCount{0};
+
+} // namespace
+
+// GCC pairs the free() below with inlined calls to the replaced operator new
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+// Count every heap allocation made by the process
+void* operator new(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+namespace {
+
+struct Corpus {
+    std::string name;
+    std::vector<std::string> puzzles;
+};
+
+struct Engine {
+    const char* name;
+    bool allocationFree;  // The run fails if a solve touches the heap
+    // Solves the board in place; returns false when there is no solution
+    bool (*solve)(Board& board, SolveStats& stats);
+};
+
+bool solveBacktracking(Board& board, SolveStats& stats) {
+    SudokuSolver solver;
+    bool solved = solver.solve(board, SudokuSolver::threadWorkspace());
+    stats = solver.getStats();
+    return solved;
+}
+
+bool solveCdcl(Board& board, SolveStats& stats) {
+    thread_local SatSudokuSolver solver;
+    bool solved = solver.solve(board, board) == SolveStatus::Solved;
+    stats = solver.getStats();
+    return solved;
+}
+
+PortfolioSolver& benchPortfolio() {
+    static PortfolioSolver solver;
+    return solver;
+}
+
+bool solvePortfolio(Board& board, SolveStats& stats) {
+    PortfolioSolver& solver = benchPortfolio();
+    bool solved = solver.solve(board, board) == SolveStatus::Solved;
+    stats = solver.getStats();
+    return solved;
+}
+
+const Engine engines[] = {
+    {"backtracking", true, solveBacktracking},
+    {"cdcl", false, solveCdcl},
+    {"portfolio", false, solvePortfolio},
+};
+
+struct Result {
+    std::string engine;
+    std::string corpus;
+    std::size_t puzzles = 0;   // Boards attempted
+    std::size_t rejected = 0;  // Corpus lines that are not valid boards
+    std::size_t solved = 0;
+    std::uint64_t allocations = 0;
+    std::int64_t p50Ns = 0;
+    std::int64_t p99Ns = 0;
+    std::int64_t maxNs = 0;
+    std::int64_t totalNs = 0;
+    double allocsPerSolve = 0;
+    double nodesPerSolve = 0;
+
+    double puzzlesPerSecond() const {
+        return totalNs > 0 ? puzzles * 1e9 / totalNs : 0;
+    }
+};
+
+std::int64_t percentile(const std::vector<std::int64_t>& sorted, double fraction) {
+    if (sorted.empty()) return 0;
+    std::size_t index = static_cast<std::size_t>(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+// The corpus's valid boards; the lines that are not are counted in the
+// result as rejected
+std::vector<Board> parseCorpus(const Corpus& corpus, Result& result) {
+    std::vector<Board> boards;
+    boards.reserve(corpus.puzzles.size());
+    for (const std::string& puzzle : corpus.puzzles) {
+        Board board;
+        if (parseBoard(puzzle, board)) boards.push_back(board);
+    }
+    result.puzzles = boards.size();
+    result.rejected = corpus.puzzles.size() - boards.size();
+    return boards;
+}
+
+void summarize(Result& result, std::vector<std::int64_t>& latencies, std::uint64_t nodes) {
+    std::sort(latencies.begin(), latencies.end());
+    for (std::int64_t latency : latencies) result.totalNs += latency;
+    result.p50Ns = percentile(latencies, 0.50);
+    result.p99Ns = percentile(latencies, 0.99);
+    result.maxNs = latencies.empty() ? 0 : latencies.back();
+    if (!latencies.empty()) {
+        result.allocsPerSolve = static_cast<double>(result.allocations) / latencies.size();
+        result.nodesPerSolve = static_cast<double>(nodes) / latencies.size();
+    }
+}
+
+Result run(const Engine& engine, const Corpus& corpus) {
+    Result result;
+    result.engine = engine.name;
+    result.corpus = corpus.name;
+
+    // Parse up front so only the solve is timed
+    std::vector<Board> boards = parseCorpus(corpus, result);
+    std::vector<std::int64_t> latencies;
+    latencies.reserve(boards.size());
+    std::uint64_t nodes = 0;
+
+    for (Board& board : boards) {
+        SolveStats stats;
+        std::uint64_t allocationsBefore = allocationCount.load(std::memory_order_relaxed);
+        PhaseTimer timer;
+        bool solved = engine.solve(board, stats);
+        std::int64_t elapsed = timer.elapsedNs();
+        result.allocations += allocationCount.load(std::memory_order_relaxed) - allocationsBefore;
+
+        latencies.push_back(elapsed);
+        nodes += stats.nodes;
+        if (solved) result.solved++;
+    }
+
+    summarize(result, latencies, nodes);
+    return result;
+}
+
+// solveBatch() over the corpus in chunks; each board is charged the
+// average latency of its chunk
+Result runBatch(const Corpus& corpus) {
+    Result result;
+    result.engine = "backtracking-batch";
+    result.corpus = corpus.name;
+
+    std::vector<Board> boards = parseCorpus(corpus, result);
+    std::vector<Board> solutions(boards.size());
+    std::vector<SolveStats> stats(boards.size());
+    std::vector<std::int64_t> latencies;
+    latencies.reserve(boards.size());
+
+    for (std::size_t begin = 0; begin < boards.size(); begin += kMaxBatchChunk) {
+        std::size_t count = std::min(kMaxBatchChunk, boards.size() - begin);
+        std::uint64_t allocationsBefore = allocationCount.load(std::memory_order_relaxed);
+        PhaseTimer timer;
+        result.solved += solveBatch(std::span<const Board>(boards.data() + begin, count),
+                                    std::span<Board>(solutions.data() + begin, count),
+                                    BatchOptions(), {},
+                                    std::span<SolveStats>(stats.data() + begin, count));
+        std::int64_t elapsed = timer.elapsedNs();
+        result.allocations += allocationCount.load(std::memory_order_relaxed) - allocationsBefore;
+        latencies.insert(latencies.end(), count, elapsed / static_cast<std::int64_t>(count));
+    }
+
+    std::uint64_t nodes = 0;
+    for (const SolveStats& boardStats : stats) nodes += boardStats.nodes;
+    summarize(result, latencies, nodes);
+    return result;
+}
+
+void writeJson(std::ostream& out, const std::vector<Result>& results) {
+    out << "{\n  \"benchmark\": \"SudokuBench\",\n  \"results\": [\n";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        out << "    {\"engine\": \"" << r.engine << "\""
+            << ", \"corpus\": \"" << r.corpus << "\""
+            << ", \"puzzles\": " << r.puzzles
+            << ", \"rejected\": " << r.rejected
+            << ", \"solved\": " << r.solved
+            << ", \"p50_ns\": " << r.p50Ns
+            << ", \"p99_ns\": " << r.p99Ns
+            << ", \"max_ns\": " << r.maxNs
+            << ", \"total_ns\": " << r.totalNs
+            << ", \"puzzles_per_sec\": " << r.puzzlesPerSecond()
+            << ", \"allocs_per_solve\": " << r.allocsPerSolve
+            << ", \"nodes_per_solve\": " << r.nodesPerSolve
+            << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [options]\n"
+              << "  --corpus NAME     game, hardest, adversarial, generated or all\n"
+              << "                    (default all)\n"
+              << "  --generated N     size of the generated corpus (default 1000)\n"
+              << "  --seed N          seed for the generated corpus (default 1)\n"
+              << "  --file PATH       add a corpus read from a file, one puzzle per line\n"
+              << "  --engine NAME     run only the named engine\n"
+              << "  --json PATH       write the JSON report to a file instead of stdout\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string corpusName = "all";
+    std::string engineName;
+    std::size_t generatedCount = 1000;
+    std::uint32_t seed = 1;
+    const char* jsonPath = nullptr;
+    std::vector<Corpus> corpora;
+
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--corpus") == 0 && hasValue) {
+            corpusName = argv[++i];
+        } else if (std::strcmp(argv[i], "--generated") == 0 && hasValue) {
+            generatedCount = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--seed") == 0 && hasValue) {
+            seed = static_cast<std::uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--engine") == 0 && hasValue) {
+            engineName = argv[++i];
+        } else if (std::strcmp(argv[i], "--json") == 0 && hasValue) {
+            jsonPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--file") == 0 && hasValue) {
+            std::ifstream file(argv[++i]);
+            if (!file) {
+                std::cerr << "Cannot open " << argv[i] << "\n";
+                return 1;
+            }
+            Corpus corpus{argv[i], {}};
+            std::string line;
+            while (std::getline(file, line)) {
+                if (!line.empty() && line[0] != '#') corpus.puzzles.push_back(line);
+            }
+            corpora.push_back(std::move(corpus));
+        } else {
+            printUsage(argv[0]);
+            return std::strcmp(argv[i], "--help") == 0 ? 0 : 2;
+        }
+    }
+
+    if (corpusName == "all" || corpusName == "game") {
+        Corpus game{"game", {}};
+        for (const auto& entry : gamePuzzles())
+            game.puzzles.insert(game.puzzles.end(), entry.second.begin(), entry.second.end());
+        corpora.push_back(std::move(game));
+    }
+    if (corpusName == "all" || corpusName == "hardest") {
+        corpora.push_back({"hardest", hardestPuzzles()});
+    }
+    if (corpusName == "all" || corpusName == "adversarial") {
+        corpora.push_back({"adversarial", adversarialPuzzles()});
+    }
+    if (corpusName == "all" || corpusName == "generated") {
+        corpora.push_back({"generated", generatedPuzzles(generatedCount, seed)});
+    }
+
+    std::vector<Result> results;
+    bool allocationCheckFailed = false;
+    auto report = [&](const Result& result, bool allocationFree) {
+        std::cerr << result.engine << "/" << result.corpus
+                  << ": " << result.solved << "/" << result.puzzles << " solved"
+                  << ", p50 " << result.p50Ns / 1000 << " us"
+                  << ", p99 " << result.p99Ns / 1000 << " us"
+                  << ", max " << result.maxNs / 1000 << " us"
+                  << ", " << result.puzzlesPerSecond() << " puzzles/s"
+                  << ", " << result.allocsPerSolve << " allocs/solve";
+        // Lines that did not parse were never attempted, so they are not
+        // counted as unsolved
+        if (result.rejected > 0) std::cerr << ", " << result.rejected << " rejected";
+        std::cerr << "\n";
+        if (allocationFree && result.allocations > 0) {
+            std::cerr << "  error: " << result.engine << " made " << result.allocations
+                      << " heap allocations, expected none\n";
+            allocationCheckFailed = true;
+        }
+        results.push_back(result);
+    };
+
+    for (const Engine& engine : engines) {
+        if (!engineName.empty() && engineName != engine.name) continue;
+        for (const Corpus& corpus : corpora) {
+            std::array<std::uint64_t, kPortfolioEngineCount> winsBefore = PortfolioSolver::totalWins();
+            Result result = run(engine, corpus);
+            // The losers of the last race stop before anything else is measured
+            if (engine.solve == solvePortfolio) benchPortfolio().wait();
+            report(result, engine.allocationFree);
+            if (engine.solve != solvePortfolio) continue;
+            // Which configuration settled the corpus's boards
+            std::array<std::uint64_t, kPortfolioEngineCount> wins = PortfolioSolver::totalWins();
+            std::cerr << "  wins:";
+            for (PortfolioEngine winner : kAllPortfolioEngines) {
+                int i = static_cast<int>(winner);
+                std::cerr << " " << portfolioEngineName(winner) << "=" << wins[i] - winsBefore[i];
+            }
+            std::cerr << "\n";
+        }
+    }
+    if (engineName.empty() || engineName == "backtracking-batch") {
+        for (const Corpus& corpus : corpora)
+            report(runBatch(corpus), true);
+    }
+
+    if (jsonPath) {
+        std::ofstream out(jsonPath);
+        if (!out) {
+            std::cerr << "Cannot write " << jsonPath << "\n";
+            return 1;
+        }
+        writeJson(out, results);
+    } else {
+        writeJson(std::cout, results);
+    }
+    return allocationCheckFailed ? 1 : 0;
+}
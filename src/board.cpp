@@ -0,0 +1,81 @@
+#include "board.h"
+#include <cstring>
+
+namespace {
+
+constexpr std::uint64_t kOnes = 0x0101010101010101ull;
+constexpr std::uint64_t kHighBits = 0x8080808080808080ull;
+
+// Turns 8 puzzle characters into cell values in place, eight bytes per
+// step with no cross-byte carries. Returns false if any byte is not a
+// digit or '.'.
+inline bool decodeWord(std::uint64_t& word) {
+    std::uint64_t values = word ^ (kOnes * '0');  // '0'..'9' -> 0..9, '.' -> 0x1E
+
+    // High bit set in every byte equal to 0x1E, i.e. every '.'
+    std::uint64_t dots = values ^ (kOnes * 0x1E);
+    dots = ~(((dots & ~kHighBits) + ~kHighBits) | dots) & kHighBits;
+    values ^= (dots >> 7) * 0x1E;
+
+    // Any byte of 10 or more now sets its high bit
+    if ((((values & ~kHighBits) + kOnes * 0x76) | values) & kHighBits) return false;
+    word = values;
+    return true;
+}
+
+} // namespace
+
+bool parseBoard(std::string_view text, Board& board) {
+    if (text.size() < 81) return false;
+
+    const char* input = text.data();
+    for (int i = 0; i < 80; i += 8) {
+        std::uint64_t word;
+        std::memcpy(&word, input + i, sizeof(word));
+        if (!decodeWord(word)) return false;
+        std::memcpy(board.data() + i, &word, sizeof(word));
+    }
+
+    char c = input[80];
+    if (c == '.') c = '0';
+    if (c < '0' || c > '9') return false;
+    board[80] = static_cast<std::uint8_t>(c - '0');
+    return true;
+}
+
+std::string formatBoard(const Board& board) {
+    std::string text(81, '0');
+    for (int i = 0; i < 81; ++i)
+        text[i] = static_cast<char>('0' + board[i]);
+    return text;
+}
+
+void packBoard(const Board& board, std::uint8_t* out) {
+    for (int i = 0; i < 40; ++i)
+        out[i] = static_cast<std::uint8_t>((board[2 * i] & 0x0F) | (board[2 * i + 1] << 4));
+    out[40] = board[80] & 0x0F;
+}
+
+void unpackBoard(const std::uint8_t* in, Board& board) {
+    for (int i = 0; i < 40; ++i) {
+        board[2 * i] = in[i] & 0x0F;
+        board[2 * i + 1] = in[i] >> 4;
+    }
+    board[80] = in[40] & 0x0F;
+}
+
+Board boardFromGrid(const std::vector<std::vector<int>>& grid) {
+    Board board{};
+    for (int row = 0; row < 9; ++row)
+        for (int col = 0; col < 9; ++col)
+            board[row * 9 + col] = static_cast<std::uint8_t>(grid[row][col]);
+    return board;
+}
+
+std::vector<std::vector<int>> gridFromBoard(const Board& board) {
+    std::vector<std::vector<int>> grid(9, std::vector<int>(9, 0));
+    for (int row = 0; row < 9; ++row)
+        for (int col = 0; col < 9; ++col)
+            grid[row][col] = board[row * 9 + col];
+    return grid;
+}
@@ -0,0 +1,373 @@
+#include "canonical.h"
+#include <algorithm>
+#include <functional>
+
+namespace {
+
+Board transpose(const Board& board) {
+    Board result;
+    for (int row = 0; row < 9; ++row)
+        for (int col = 0; col < 9; ++col)
+            result[col * 9 + row] = board[row * 9 + col];
+    return result;
+}
+
+// The six orderings of three items
+constexpr std::uint8_t kPermutations[6][3] = {
+    {0, 1, 2}, {0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}, {2, 1, 0}
+};
+
+// Rows, bands, columns and stacks of a board that hold exactly the same
+// cells. Swapping two of them leaves the board unchanged, so the searches
+// only try the first of each such group; sparse boards would otherwise
+// explore every ordering of their empty lines. Only lines of one band or
+// stack can be swapped on their own, so rows and cols are filled for
+// those pairs only.
+struct Twins {
+    bool rows[9][9] = {};
+    bool bands[3][3] = {};
+    bool cols[9][9] = {};
+    bool stacks[3][3] = {};
+
+    // Columns of a board are the rows of its transpose
+    Twins(const Board& board, const Board& transposed) {
+        for (int a = 0; a < 9; ++a)
+            for (int b = a - a % 3; b < a - a % 3 + 3; ++b) {
+                rows[a][b] = std::equal(&board[a * 9], &board[a * 9] + 9, &board[b * 9]);
+                cols[a][b] = std::equal(&transposed[a * 9], &transposed[a * 9] + 9, &transposed[b * 9]);
+            }
+        for (int a = 0; a < 3; ++a)
+            for (int b = 0; b < 3; ++b) {
+                bands[a][b] = std::equal(&board[a * 27], &board[a * 27] + 27, &board[b * 27]);
+                stacks[a][b] = std::equal(&transposed[a * 27], &transposed[a * 27] + 27, &transposed[b * 27]);
+            }
+    }
+
+    // Whether row can be swapped for the earlier row other by exchanging
+    // two identical rows of one band or two identical bands
+    bool sameRow(int other, int row) const {
+        if (other / 3 == row / 3) return rows[other][row];
+        return other % 3 == row % 3 && bands[other / 3][row / 3];
+    }
+};
+
+// Column order being built for one stack order. Positions hold source
+// columns; a set bit p in splits means positions p and p + 1 have already
+// been told apart by an earlier row. Columns still sharing a cell have
+// read the same in every row so far, so their order is left open.
+struct ColumnOrder {
+    std::array<std::uint8_t, 9> cols{};
+    std::uint16_t splits = 0;
+};
+
+// One way of placing a source row: its relabelled values and the state
+// it leaves for the rows below
+struct RowPlacement {
+    std::array<std::uint8_t, 9> values{};
+    std::array<std::uint8_t, 10> labels{};
+    std::uint8_t nextLabel = 1;
+    ColumnOrder order;
+};
+
+// Insertion sort for the at most three columns of a cell
+template <typename Key>
+void sortColumns(std::uint8_t* cols, int count, Key key) {
+    for (int i = 1; i < count; ++i)
+        for (int j = i; j > 0 && key(cols[j]) < key(cols[j - 1]); --j)
+            std::swap(cols[j], cols[j - 1]);
+}
+
+// Depth-first search over row orders for one stack order. Each placed row
+// refines the column order as little as needed to read smallest: empty
+// cells first, then digits already labelled in label order, then new
+// digits. Only new digits sharing a cell are a real choice (they decide
+// later labels), so only they branch.
+//
+// The best board is built in place: rows below bestRows match the current
+// path, so a row that compares greater than the best row at its depth can
+// never lead to a smaller board and is pruned right away.
+class RowSearch {
+public:
+    RowSearch(Board& best, int& bestRows, BoardTransform& bestTransform)
+        : best(best), bestRows(bestRows), bestTransform(bestTransform) {}
+
+    void run(const Board& source, const Twins& sourceTwins, bool transposed,
+             const std::array<std::uint8_t, 3>& stacks, int firstRow) {
+        this->source = &source;
+        twins = &sourceTwins;
+        current.transposed = transposed;
+
+        RowPlacement start;
+        for (int s = 0; s < 3; ++s)
+            for (int k = 0; k < 3; ++k)
+                start.order.cols[s * 3 + k] = static_cast<std::uint8_t>(stacks[s] * 3 + k);
+        start.order.splits = (1u << 2) | (1u << 5);
+        expandRow(0, firstRow, 0, start, 0);
+    }
+
+private:
+    void search(int depth, const RowPlacement& state, unsigned usedBands) {
+        if (depth == 9) {
+            bestTransform = current;
+            bestTransform.cols = state.order.cols;
+            bestTransform.relabel = state.labels;
+            return;
+        }
+
+        int band = depth % 3 == 0 ? -1 : current.rows[depth - 1] / 3;
+        auto eligible = [&](int row) {
+            if (band < 0 ? (usedBands >> (row / 3)) & 1 : row / 3 != band) return false;
+            return !isUsed(depth, row);
+        };
+        for (int row = 0; row < 9; ++row) {
+            if (!eligible(row)) continue;
+            bool repeat = false;
+            for (int other = 0; other < row && !repeat; ++other)
+                repeat = eligible(other) && twins->sameRow(other, row);
+            if (repeat) continue;
+
+            expandRow(depth, row, 0, state, usedBands);
+        }
+    }
+
+    bool isUsed(int depth, int row) const {
+        for (int d = depth - depth % 3; d < depth; ++d)
+            if (current.rows[d] == row) return true;
+        return false;
+    }
+
+    // Lays out the cells of the row from position onwards, branching over
+    // the orders of new digits that share a cell
+    void expandRow(int depth, int row, int position, RowPlacement state, unsigned usedBands) {
+        // Once every column is told apart the row reads straight off
+        if (position == 0 && state.order.splits == 0xFF) {
+            bool tight = depth < bestRows;
+            for (int p = 0; p < 9; ++p) {
+                std::uint8_t digit = (*source)[row * 9 + state.order.cols[p]];
+                if (digit != 0 && state.labels[digit] == 0) state.labels[digit] = state.nextLabel++;
+                std::uint8_t value = state.labels[digit];
+                state.values[p] = value;
+                if (tight && value != best[depth * 9 + p]) {
+                    if (value > best[depth * 9 + p]) return;
+                    tight = false;
+                }
+            }
+            finishRow(depth, row, state, usedBands);
+            return;
+        }
+
+        while (position < 9) {
+            int end = position;
+            while (end < 8 && !((state.order.splits >> end) & 1)) end++;
+
+            Cell cell;
+            for (int p = position; p <= end; ++p) {
+                std::uint8_t col = state.order.cols[p];
+                std::uint8_t digit = (*source)[row * 9 + col];
+                if (digit == 0) cell.empty[cell.emptyCount++] = col;
+                else if (state.labels[digit] != 0) cell.known[cell.knownCount++] = col;
+                else cell.fresh[cell.freshCount++] = col;
+            }
+            auto labelOf = [&](std::uint8_t col) { return state.labels[(*source)[row * 9 + col]]; };
+            sortColumns(cell.known, cell.knownCount, labelOf);
+
+            if (cell.freshCount > 1) {
+                sortColumns(cell.fresh, cell.freshCount, [](std::uint8_t col) { return col; });
+                do {
+                    RowPlacement next = state;
+                    layCell(row, position, cell, next);
+                    if (!exceedsBest(depth, next.values, end + 1)) expandRow(depth, row, end + 1, next, usedBands);
+                } while (std::next_permutation(cell.fresh, cell.fresh + cell.freshCount));
+                return;
+            }
+
+            layCell(row, position, cell, state);
+            if (exceedsBest(depth, state.values, end + 1)) return;
+            position = end + 1;
+        }
+        finishRow(depth, row, state, usedBands);
+    }
+
+    // Columns of one cell of the column order, by what the row holds there
+    struct Cell {
+        std::uint8_t empty[3], known[3], fresh[3];
+        int emptyCount = 0, knownCount = 0, freshCount = 0;
+    };
+
+    // Places a cell's columns in reading order: empty cells (left tied),
+    // labelled digits by label, then new digits, which take the next labels
+    void layCell(int row, int position, const Cell& cell, RowPlacement& state) const {
+        int p = position;
+        for (int i = 0; i < cell.emptyCount; ++i) {
+            state.order.cols[p] = cell.empty[i];
+            state.values[p++] = 0;
+        }
+        for (int i = 0; i < cell.knownCount; ++i) {
+            if (p > position) state.order.splits |= static_cast<std::uint16_t>(1u << (p - 1));
+            state.order.cols[p] = cell.known[i];
+            state.values[p++] = state.labels[(*source)[row * 9 + cell.known[i]]];
+        }
+        for (int i = 0; i < cell.freshCount; ++i) {
+            if (p > position) state.order.splits |= static_cast<std::uint16_t>(1u << (p - 1));
+            state.order.cols[p] = cell.fresh[i];
+            state.labels[(*source)[row * 9 + cell.fresh[i]]] = state.nextLabel;
+            state.values[p++] = state.nextLabel++;
+        }
+    }
+
+    // Whether the first count values of a row already read larger than the
+    // best board's row at this depth. The best can change between branches,
+    // so the prefix is compared afresh each time.
+    bool exceedsBest(int depth, const std::array<std::uint8_t, 9>& values, int count) const {
+        if (depth >= bestRows) return false;
+        for (int col = 0; col < count; ++col) {
+            std::uint8_t bestValue = best[depth * 9 + col];
+            if (values[col] != bestValue) return values[col] > bestValue;
+        }
+        return false;
+    }
+
+    // Compares a laid out row with the best board at this depth and goes
+    // on to the next row unless it would make the board larger
+    void finishRow(int depth, int row, const RowPlacement& state, unsigned usedBands) {
+        bool tight = depth < bestRows;
+        for (int col = 0; col < 9 && tight; ++col) {
+            std::uint8_t bestValue = best[depth * 9 + col];
+            if (state.values[col] > bestValue) return;
+            if (state.values[col] < bestValue) tight = false;
+        }
+
+        // Equal rows keep the best as is; smaller rows replace it from here on
+        if (depth >= bestRows || !tight) {
+            for (int col = 0; col < 9; ++col) best[depth * 9 + col] = state.values[col];
+            bestRows = depth + 1;
+        }
+        current.rows[depth] = static_cast<std::uint8_t>(row);
+        search(depth + 1, state, usedBands | (1u << (row / 3)));
+    }
+
+    Board& best;
+    int& bestRows;
+    BoardTransform& bestTransform;
+    const Board* source = nullptr;
+    const Twins* twins = nullptr;
+    BoardTransform current;
+};
+
+// Empty cells in each stack of one row
+std::array<int, 3> emptiesPerStack(const Board& source, int row) {
+    std::array<int, 3> empties{};
+    for (int col = 0; col < 9; ++col) empties[col / 3] += source[row * 9 + col] == 0;
+    return empties;
+}
+
+// How good a row is as the first row of the canonical board. The givens in
+// a row are distinct, so once relabelled they read 1, 2, 3... whatever the
+// column order: the row's best form only depends on where its empty cells
+// go, and that is empty cells first in each stack, emptiest stacks first.
+// Rows with more empties in the emptiest stack, then the next, win.
+int firstRowScore(const Board& source, int row) {
+    std::array<int, 3> empties = emptiesPerStack(source, row);
+    std::sort(empties.begin(), empties.end(), std::greater<int>());
+    return empties[0] * 16 + empties[1] * 4 + empties[2];
+}
+
+// Runs the row search for every stack order that gives the first row its
+// best form, emptiest stacks first
+void searchFromFirstRow(RowSearch& rowSearch, const Board& source, const Twins& twins, bool transposed,
+                        int firstRow) {
+    std::array<int, 3> empties = emptiesPerStack(source, firstRow);
+    for (const auto& order : kPermutations) {
+        if (empties[order[0]] < empties[order[1]] || empties[order[1]] < empties[order[2]]) continue;
+        bool repeat = false;
+        for (int a = 0; a < 3; ++a)
+            for (int b = a + 1; b < 3; ++b)
+                if (order[a] > order[b] && twins.stacks[order[a]][order[b]]) repeat = true;
+        if (repeat) continue;
+        rowSearch.run(source, twins, transposed, {order[0], order[1], order[2]}, firstRow);
+    }
+}
+
+} // namespace
+
+Board BoardTransform::apply(const Board& board) const {
+    Board source = transposed ? transpose(board) : board;
+    Board result;
+    for (int row = 0; row < 9; ++row)
+        for (int col = 0; col < 9; ++col)
+            result[row * 9 + col] = relabel[source[rows[row] * 9 + cols[col]]];
+    return result;
+}
+
+Board BoardTransform::invert(const Board& transformed) const {
+    std::array<std::uint8_t, 10> inverse{};
+    for (int digit = 1; digit <= 9; ++digit)
+        if (relabel[digit] != 0) inverse[relabel[digit]] = static_cast<std::uint8_t>(digit);
+
+    Board source;
+    for (int row = 0; row < 9; ++row)
+        for (int col = 0; col < 9; ++col)
+            source[rows[row] * 9 + cols[col]] = inverse[transformed[row * 9 + col]];
+    return transposed ? transpose(source) : source;
+}
+
+CanonicalBoard canonicalize(const Board& board) {
+    CanonicalBoard result;
+    int bestRows = 0;
+    RowSearch rowSearch(result.board, bestRows, result.transform);
+
+    // Only the rows (of the board or its transpose) with the best first-row
+    // score can start the canonical board
+    const Board sources[2] = {board, transpose(board)};
+    const Twins twins[2] = {Twins(sources[0], sources[1]), Twins(sources[1], sources[0])};
+    int scores[2][9];
+    int bestScore = -1;
+    for (int transposed = 0; transposed < 2; ++transposed)
+        for (int row = 0; row < 9; ++row) {
+            scores[transposed][row] = firstRowScore(sources[transposed], row);
+            bestScore = std::max(bestScore, scores[transposed][row]);
+        }
+
+    for (int transposed = 0; transposed < 2; ++transposed)
+        for (int row = 0; row < 9; ++row) {
+            if (scores[transposed][row] != bestScore) continue;
+            bool repeat = false;
+            for (int other = 0; other < row && !repeat; ++other)
+                repeat = scores[transposed][other] == bestScore && twins[transposed].sameRow(other, row);
+            if (!repeat) searchFromFirstRow(rowSearch, sources[transposed], twins[transposed], transposed != 0, row);
+        }
+
+    // Digits missing from the board still need a label so that a full
+    // solution can be mapped back; give them the unused labels in order
+    std::array<std::uint8_t, 10>& relabel = result.transform.relabel;
+    bool labelTaken[10] = {};
+    for (int digit = 1; digit <= 9; ++digit) labelTaken[relabel[digit]] = relabel[digit] != 0;
+    std::uint8_t label = 1;
+    for (int digit = 1; digit <= 9; ++digit) {
+        if (relabel[digit] != 0) continue;
+        while (labelTaken[label]) label++;
+        relabel[digit] = label++;
+    }
+    return result;
+}
+
+std::uint64_t canonicalId(const Board& canonical) {
+    // Eight cells per word, each word folded in with a multiply-xorshift
+    // mixer (as in splitmix64) so that every cell affects every ID bit
+    auto mix = [](std::uint64_t x) {
+        x ^= x >> 30;
+        x *= 0xBF58476D1CE4E5B9ull;
+        x ^= x >> 27;
+        x *= 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    };
+
+    std::uint64_t id = 0x9E3779B97F4A7C15ull;
+    for (int i = 0; i < 80; i += 8) {
+        // Packed by hand so the ID is the same on any byte order
+        std::uint64_t word = 0;
+        for (int k = 0; k < 8; ++k) word |= static_cast<std::uint64_t>(canonical[i + k]) << (8 * k);
+        id = mix(id ^ word) + 0x9E3779B97F4A7C15ull;
+    }
+    return mix(id ^ canonical[80]);
+}
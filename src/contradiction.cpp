@@ -0,0 +1,138 @@
+#include "contradiction.h"
+#include <array>
+#include <bit>
+
+namespace {
+
+constexpr std::uint16_t kAllDigits = 0x1FF;
+
+// Singles propagation with a count of candidate cells per unit and digit,
+// so each candidate removal finds a new hidden single or a digit with no
+// place in O(1) instead of rescanning units
+class Propagator {
+public:
+    Propagator(const Board& board, const UnitTable& table) : givens(board), units(table) {
+        values.fill(0);
+        candidates.fill(kAllDigits);
+        for (auto& unit : places) unit.fill(9);
+        placed.fill(0);
+    }
+
+    Contradiction run() {
+        for (int cell = 0; cell < 81; ++cell) {
+            int digit = givens[cell];
+            if (digit == 0) continue;
+            if (digit > 9) fail(ContradictionKind::Clash, cell, -1, digit);
+            if (failure || !assign(cell, digit)) return failure;
+        }
+
+        // Naked singles first, they need no search for their cell
+        while (nakedCount > 0 || hiddenCount > 0) {
+            if (nakedCount > 0) {
+                int cell = naked[--nakedCount];
+                if (values[cell] == 0 && !assign(cell, std::countr_zero(candidates[cell]) + 1)) break;
+            } else {
+                auto [unit, digit] = hidden[--hiddenCount];
+                if (!placeHidden(unit, digit)) break;
+            }
+        }
+        return failure;
+    }
+
+    // The givens and every single placed so far
+    const Board& filled() const {
+        return values;
+    }
+
+private:
+    static std::uint16_t bitOf(int digit) {
+        return static_cast<std::uint16_t>(1u << (digit - 1));
+    }
+
+    bool assign(int cell, int digit) {
+        std::uint16_t bit = bitOf(digit);
+        if (!(candidates[cell] & bit)) return fail(ContradictionKind::Clash, cell, -1, digit);
+
+        // The cell's other digits lose it as a place
+        std::uint16_t others = candidates[cell] & ~bit;
+        candidates[cell] = bit;
+        values[cell] = static_cast<std::uint8_t>(digit);
+        for (std::uint8_t unit : units.unitsOf(cell)) placed[unit] |= bit;
+        while (others) {
+            int other = std::countr_zero(others) + 1;
+            others &= others - 1;
+            if (!losePlace(cell, other)) return false;
+        }
+
+        for (std::uint8_t peer : units.peers(cell)) {
+            if (!(candidates[peer] & bit)) continue;
+            if (values[peer] != 0) return fail(ContradictionKind::Clash, cell, -1, digit);
+            candidates[peer] &= ~bit;
+            if (candidates[peer] == 0) return fail(ContradictionKind::NoCandidates, peer, -1, 0);
+            if (std::has_single_bit(candidates[peer])) naked[nakedCount++] = peer;
+            if (!losePlace(peer, digit)) return false;
+        }
+        return true;
+    }
+
+    // The cell no longer holds digit as a candidate; update its units
+    bool losePlace(int cell, int digit) {
+        std::uint16_t bit = bitOf(digit);
+        for (std::uint8_t unit : units.unitsOf(cell)) {
+            int left = --places[unit][digit - 1];
+            if (placed[unit] & bit) continue;
+            if (left == 0) return fail(ContradictionKind::NoPlaceForDigit, -1, unit, digit);
+            if (left == 1) hidden[hiddenCount++] = {unit, static_cast<std::uint8_t>(digit)};
+        }
+        return true;
+    }
+
+    bool placeHidden(int unit, int digit) {
+        std::uint16_t bit = bitOf(digit);
+        if (placed[unit] & bit) return true;
+        for (std::uint8_t cell : units.cells(unit)) {
+            if (values[cell] == 0 && (candidates[cell] & bit)) return assign(cell, digit);
+        }
+        return fail(ContradictionKind::NoPlaceForDigit, -1, unit, digit);
+    }
+
+    bool fail(ContradictionKind kind, int cell, int unit, int digit) {
+        failure.kind = kind;
+        failure.cell = cell;
+        failure.unit = unit;
+        failure.digit = digit;
+        return false;
+    }
+
+    struct UnitDigit {
+        std::uint8_t unit;
+        std::uint8_t digit;
+    };
+
+    Board givens;
+    const UnitTable& units;
+    Board values;
+    std::array<std::uint16_t, 81> candidates;
+    std::array<std::array<std::uint8_t, 9>, UnitTable::kMaxUnits> places;  // Candidate cells per unit and digit
+    std::array<std::uint16_t, UnitTable::kMaxUnits> placed;                // Digits already placed per unit
+    // A cell is queued once, when it drops to a single candidate, and a
+    // unit and digit once, when the digit drops to a single place
+    std::array<std::uint8_t, 81> naked;
+    std::array<UnitDigit, UnitTable::kMaxUnits * 9> hidden;
+    int nakedCount = 0;
+    int hiddenCount = 0;
+    Contradiction failure;
+};
+
+} // namespace
+
+Contradiction findContradiction(const Board& board, const UnitTable& units) {
+    return Propagator(board, units).run();
+}
+
+Contradiction placeSingles(const Board& board, Board& filled, const UnitTable& units) {
+    Propagator propagator(board, units);
+    Contradiction found = propagator.run();
+    if (!found) filled = propagator.filled();
+    return found;
+}
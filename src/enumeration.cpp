@@ -0,0 +1,241 @@
+#include "enumeration.h"
+#include "solver.h"
+#include "threadpool.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <future>
+#include <stop_token>
+
+namespace {
+
+inline std::uint16_t digitBit(int num) {
+    return static_cast<std::uint16_t>(1u << (num - 1));
+}
+
+// Subtrees per thread, so a thread finishing early picks up more work
+// instead of idling while one deep subtree runs on
+constexpr std::size_t kSubtreesPerThread = 16;
+// Cells filled up front at most, bounding the subtree list
+constexpr int kMaxSplitDepth = 6;
+
+// Boards the search of board reaches after filling its first empty cells,
+// in the order the search reaches them; full boards are kept as they are
+std::vector<Board> splitSubtrees(const Board& board, const UnitTable& units, std::size_t target) {
+    std::vector<Board> subtrees{board};
+    for (int level = 0; level < kMaxSplitDepth && subtrees.size() < target; ++level) {
+        std::vector<Board> next;
+        bool grew = false;
+        for (const Board& subtree : subtrees) {
+            const std::uint8_t* empty = std::find(subtree.begin(), subtree.end(), 0);
+            if (empty == subtree.end()) {
+                next.push_back(subtree);
+                continue;
+            }
+            int cell = static_cast<int>(empty - subtree.begin());
+            std::uint16_t used = 0;
+            for (std::uint8_t peer : units.peers(cell)) {
+                if (subtree[peer] != 0) used |= digitBit(subtree[peer]);
+            }
+            for (int num = 1; num <= 9; ++num) {
+                if (used & digitBit(num)) continue;
+                next.push_back(subtree);
+                next.back()[cell] = static_cast<std::uint8_t>(num);
+            }
+            grew = true;
+        }
+        if (!grew) break;
+        subtrees = std::move(next);
+    }
+    return subtrees;
+}
+
+} // namespace
+
+void SolutionEncoder::add(const Board& solution) {
+    int shared = 0;
+    if (hasPrevious) {
+        while (shared < 80 && solution[shared] == previous[shared]) shared++;
+    }
+    bytes.push_back(static_cast<std::uint8_t>(shared));
+    for (int cell = shared; cell < 81; cell += 2) {
+        std::uint8_t high = cell + 1 < 81 ? solution[cell + 1] : 0;
+        bytes.push_back(static_cast<std::uint8_t>((solution[cell] & 0x0F) | (high << 4)));
+    }
+    previous = solution;
+    hasPrevious = true;
+}
+
+SolutionWriter::SolutionWriter(const std::string& path) : file(std::fopen(path.c_str(), "wb")) {
+    if (file && std::fwrite(kSolutionStreamMagic, 1, sizeof(kSolutionStreamMagic), file) != sizeof(kSolutionStreamMagic))
+        failed = true;
+}
+
+SolutionWriter::~SolutionWriter() {
+    close();
+}
+
+bool SolutionWriter::write(std::span<const std::uint8_t> records) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!file) return false;
+    if (std::fwrite(records.data(), 1, records.size(), file) != records.size()) failed = true;
+    return !failed;
+}
+
+bool SolutionWriter::endPuzzle() {
+    std::uint8_t end = kEndOfPuzzle;
+    return write(std::span<const std::uint8_t>(&end, 1));
+}
+
+bool SolutionWriter::close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!file) return !failed;
+    if (std::fclose(file) != 0) failed = true;
+    file = nullptr;
+    return !failed;
+}
+
+bool readSolutionFile(const std::string& path,
+                      const std::function<void(std::size_t puzzle, const Board& solution)>& onSolution) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return false;
+    char magic[sizeof(kSolutionStreamMagic)];
+    bool ok = std::fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+              std::memcmp(magic, kSolutionStreamMagic, sizeof(magic)) == 0;
+
+    std::size_t puzzle = 0;
+    Board solution{};
+    bool hasPrevious = false;
+    int shared;
+    while (ok && (shared = std::fgetc(file)) != EOF) {
+        if (shared == kEndOfPuzzle) {
+            puzzle++;
+            hasPrevious = false;
+            continue;
+        }
+        // Only a record after another can share cells
+        if (shared > 80 || (shared > 0 && !hasPrevious)) {
+            ok = false;
+            break;
+        }
+        for (int cell = shared; cell < 81 && ok; cell += 2) {
+            int packed = std::fgetc(file);
+            if (packed == EOF) {
+                ok = false;
+                break;
+            }
+            solution[cell] = static_cast<std::uint8_t>(packed & 0x0F);
+            if (cell + 1 < 81) solution[cell + 1] = static_cast<std::uint8_t>(packed >> 4);
+        }
+        if (!ok) break;
+        hasPrevious = true;
+        onSolution(puzzle, solution);
+    }
+    if (std::ferror(file)) ok = false;
+    std::fclose(file);
+    return ok;
+}
+
+SolveStatus enumerateSolutions(const Board& board, const EnumerateOptions& options,
+                               const SolutionBlockCallback& onBlock, std::uint64_t& count,
+                               SolveStats* stats) {
+    count = 0;
+    if (stats) *stats = SolveStats();
+    const UnitTable& units = options.units ? *options.units : UnitTable::classic();
+    std::size_t threads = options.threads > 0 ? options.threads
+                                              : std::max(1u, std::thread::hardware_concurrency());
+
+    // Clashing givens would otherwise be split into subtrees first
+    {
+        SudokuSolver solver;
+        solver.setUnits(units);
+        if (!solver.prepare(board, SudokuSolver::threadWorkspace())) return SolveStatus::Unsolvable;
+    }
+    std::vector<Board> subtrees = splitSubtrees(board, units, threads > 1 ? threads * kSubtreesPerThread : 1);
+
+    std::uint64_t maxCount = options.maxCount > 0 ? options.maxCount : UINT64_MAX;
+    SolveLimits::Clock::time_point deadline = options.limits.deadlineFrom(SolveLimits::Clock::now());
+    std::atomic<std::size_t> nextSubtree{0};
+    std::atomic<std::uint64_t> streamed{0};
+    std::atomic<std::uint64_t> nodesUsed{0};
+    std::atomic<bool> timedOut{false};
+    std::atomic<bool> sinkStopped{false};
+    std::stop_source stop;
+    std::stop_callback forward(options.limits.stop, [&stop] { stop.request_stop(); });
+    std::mutex mutex;  // Serializes onBlock and the stats
+
+    auto worker = [&] {
+        SudokuSolver solver;
+        solver.setUnits(units);
+        solver.setTranspositions(options.transpositions);
+        SolverWorkspace workspace;
+        SolutionEncoder encoder;
+        SolveStats totals;
+
+        auto flush = [&] {
+            if (encoder.size() == 0) return !sinkStopped;
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!sinkStopped && !onBlock(encoder.data())) {
+                sinkStopped = true;
+                stop.request_stop();
+            }
+            encoder.clear();
+            return !sinkStopped;
+        };
+        SolutionCallback onSolution = [&](const Board& solution) {
+            // The cap is shared, so every thread's solutions count against it
+            std::uint64_t index = streamed.fetch_add(1, std::memory_order_relaxed);
+            if (index >= maxCount) return false;
+            encoder.add(solution);
+            if (index + 1 == maxCount) {
+                stop.request_stop();
+                return false;
+            }
+            return encoder.size() < options.blockSize || flush();
+        };
+
+        while (!stop.stop_requested()) {
+            std::size_t index = nextSubtree.fetch_add(1, std::memory_order_relaxed);
+            if (index >= subtrees.size()) break;
+
+            SolveLimits limits;
+            limits.deadline = deadline;
+            limits.stop = stop.get_token();
+            if (options.limits.maxNodes > 0) {
+                std::uint64_t used = nodesUsed.load(std::memory_order_relaxed);
+                if (used >= options.limits.maxNodes) {
+                    timedOut = true;
+                    stop.request_stop();
+                    break;
+                }
+                limits.maxNodes = options.limits.maxNodes - used;
+            }
+
+            std::uint64_t found;
+            SolveStatus status = solver.enumerateSolutions(subtrees[index], workspace, onSolution, found, 0, limits);
+            nodesUsed.fetch_add(solver.getStats().nodes, std::memory_order_relaxed);
+            totals += solver.getStats();
+            if (status == SolveStatus::TimedOut) {
+                timedOut = true;
+                stop.request_stop();
+            }
+        }
+        flush();
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stats) *stats += totals;
+    };
+
+    if (threads == 1 || subtrees.size() == 1) {
+        worker();
+    } else {
+        ThreadPool pool(std::min(threads, subtrees.size()));
+        std::vector<std::future<void>> done;
+        for (std::size_t i = 0; i < pool.size(); ++i) done.push_back(pool.submit(worker));
+        for (auto& future : done) future.get();
+    }
+
+    count = std::min(streamed.load(), maxCount);
+    if (sinkStopped || (options.limits.stop.stop_requested() && count < maxCount)) return SolveStatus::Cancelled;
+    if (timedOut && count < maxCount) return SolveStatus::TimedOut;
+    return count > 0 ? SolveStatus::Solved : SolveStatus::Unsolvable;
+}
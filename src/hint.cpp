@@ -0,0 +1,258 @@
+#include "hint.h"
+#include <algorithm>
+#include <bit>
+
+namespace {
+
+constexpr std::uint16_t kAllDigits = 0x1FF;
+
+inline std::uint16_t digitBit(int num) {
+    return static_cast<std::uint16_t>(1u << (num - 1));
+}
+
+void addReason(int cell, Hint& hint) {
+    if (std::find(hint.reasons.begin(), hint.reasons.end(), cell) == hint.reasons.end())
+        hint.reasons.push_back(static_cast<std::uint8_t>(cell));
+}
+
+} // namespace
+
+Hint HintFinder::next(const Board& current) {
+    // Earlier eliminations only hold while every filled cell stays as it was
+    for (int cell = 0; cell < 81; ++cell) {
+        if (lastBoard[cell] != 0 && current[cell] != lastBoard[cell]) {
+            removed.fill(0);
+            break;
+        }
+    }
+    lastBoard = current;
+    board = current;
+
+    Hint hint;
+    if (!loadCandidates(board)) return hint;
+    bool found = findNakedSingle(hint) || findHiddenSingle(hint) || findLockedCandidates(hint) ||
+                 findSubset(2, false, hint) || findSubset(2, true, hint) || findSubset(3, false, hint) ||
+                 findSubset(3, true, hint) || findSubset(4, false, hint) || findSubset(4, true, hint) ||
+                 findXWing(hint);
+    if (!found) return Hint();
+    for (const HintElimination& elimination : hint.eliminations) removed[elimination.cell] |= elimination.digits;
+    return hint;
+}
+
+// Candidates of every empty cell; false on a clash, an empty cell with no
+// candidate or a digit with no place in a unit
+bool HintFinder::loadCandidates(const Board& current) {
+    for (int cell = 0; cell < 81; ++cell) {
+        int num = current[cell];
+        if (num > 9) return false;
+        std::uint16_t used = 0;
+        for (std::uint8_t peer : units->peers(cell)) {
+            if (current[peer] != 0) used |= digitBit(current[peer]);
+        }
+        if (num != 0) {
+            if (used & digitBit(num)) return false;
+            candidates[cell] = 0;
+            continue;
+        }
+        candidates[cell] = kAllDigits & ~used & ~removed[cell];
+        if (candidates[cell] == 0) return false;
+    }
+    for (int unit = 0; unit < units->size(); ++unit) {
+        std::uint16_t seen = 0;
+        for (std::uint8_t cell : units->cells(unit)) {
+            seen |= current[cell] != 0 ? digitBit(current[cell]) : candidates[cell];
+        }
+        if (seen != kAllDigits) return false;
+    }
+    return true;
+}
+
+void HintFinder::addBlockers(int cell, int digit, Hint& hint) const {
+    for (std::uint8_t peer : units->peers(cell)) {
+        if (board[peer] == digit) {
+            addReason(peer, hint);
+            return;
+        }
+    }
+}
+
+bool HintFinder::findNakedSingle(Hint& hint) const {
+    for (int cell = 0; cell < 81; ++cell) {
+        if (board[cell] != 0 || !std::has_single_bit(candidates[cell])) continue;
+        hint.technique = HintTechnique::NakedSingle;
+        hint.cell = cell;
+        hint.digit = std::countr_zero(candidates[cell]) + 1;
+        hint.digits = candidates[cell];
+        // A filled peer for each digit the cell cannot take
+        for (int num = 1; num <= 9; ++num) {
+            if (num != hint.digit) addBlockers(cell, num, hint);
+        }
+        return true;
+    }
+    return false;
+}
+
+bool HintFinder::findHiddenSingle(Hint& hint) const {
+    for (int unit = 0; unit < units->size(); ++unit) {
+        const UnitTable::Unit& cells = units->cells(unit);
+        std::uint16_t placed = 0, once = 0, twice = 0;
+        for (std::uint8_t cell : cells) {
+            if (board[cell] != 0) placed |= digitBit(board[cell]);
+            twice |= once & candidates[cell];
+            once |= candidates[cell];
+        }
+        std::uint16_t singles = once & ~twice & ~placed;
+        if (singles == 0) continue;
+
+        int num = std::countr_zero(singles) + 1;
+        hint.technique = HintTechnique::HiddenSingle;
+        hint.digit = num;
+        hint.digits = digitBit(num);
+        hint.unit = unit;
+        // The filled peers that keep the digit out of the unit's other cells
+        for (std::uint8_t cell : cells) {
+            if (candidates[cell] & digitBit(num)) hint.cell = cell;
+            else if (board[cell] == 0) addBlockers(cell, num, hint);
+        }
+        return true;
+    }
+    return false;
+}
+
+bool HintFinder::findLockedCandidates(Hint& hint) const {
+    for (int unit = 0; unit < units->size(); ++unit) {
+        const UnitTable::Unit& cells = units->cells(unit);
+        for (int num = 1; num <= 9; ++num) {
+            std::uint16_t bit = digitBit(num);
+            // Units holding every place of the digit besides this one
+            std::uint64_t shared = ~(std::uint64_t{1} << unit);
+            int places = 0;
+            for (std::uint8_t cell : cells) {
+                if (!(candidates[cell] & bit)) continue;
+                shared &= units->unitMask(cell);
+                places++;
+            }
+            if (places < 2) continue;
+
+            for (; shared; shared &= shared - 1) {
+                int other = std::countr_zero(shared);
+                for (std::uint8_t cell : units->cells(other)) {
+                    if ((candidates[cell] & bit) && !(units->unitMask(cell) >> unit & 1))
+                        hint.eliminations.push_back({cell, bit});
+                }
+                if (hint.eliminations.empty()) continue;
+
+                hint.technique = HintTechnique::LockedCandidates;
+                hint.digit = num;
+                hint.digits = bit;
+                hint.unit = unit;
+                hint.otherUnit = other;
+                for (std::uint8_t cell : cells) {
+                    if (candidates[cell] & bit) addReason(cell, hint);
+                }
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Naked: size empty cells of a unit whose candidates together are size
+// digits, which leave the unit's other cells. Hidden: size digits whose
+// places in a unit are together size cells, which lose their other digits.
+bool HintFinder::findSubset(int size, bool hidden, Hint& hint) const {
+    for (int unit = 0; unit < units->size(); ++unit) {
+        const UnitTable::Unit& cells = units->cells(unit);
+        // Per position in the unit its candidates, and per digit its places
+        std::array<std::uint16_t, 9> places{};
+        std::uint16_t open = 0, missing = 0;
+        for (int position = 0; position < 9; ++position) {
+            std::uint16_t mask = candidates[cells[position]];
+            if (mask != 0) open |= static_cast<std::uint16_t>(1u << position);
+            for (; mask; mask &= mask - 1) places[std::countr_zero(mask)] |= static_cast<std::uint16_t>(1u << position);
+        }
+        for (int digit = 0; digit < 9; ++digit) {
+            if (places[digit] != 0) missing |= static_cast<std::uint16_t>(1u << digit);
+        }
+        // A subset as large as what is open removes nothing
+        if (std::popcount(static_cast<unsigned>(open)) <= size) continue;
+
+        for (std::uint16_t subset = 1; subset < 0x200; ++subset) {
+            if (std::popcount(static_cast<unsigned>(subset)) != size) continue;
+            std::uint16_t cellMask = 0, digitMask = 0;
+            if (hidden) {
+                if ((subset & missing) != subset) continue;
+                digitMask = subset;
+                for (std::uint16_t rest = subset; rest; rest &= rest - 1) cellMask |= places[std::countr_zero(rest)];
+            } else {
+                if ((subset & open) != subset) continue;
+                cellMask = subset;
+                for (std::uint16_t rest = subset; rest; rest &= rest - 1)
+                    digitMask |= candidates[cells[std::countr_zero(rest)]];
+            }
+            if (std::popcount(static_cast<unsigned>(hidden ? cellMask : digitMask)) != size) continue;
+
+            for (int position = 0; position < 9; ++position) {
+                bool inSubset = cellMask >> position & 1;
+                if (inSubset != hidden) continue;
+                std::uint8_t cell = cells[position];
+                std::uint16_t lost = candidates[cell] & (hidden ? ~digitMask : digitMask);
+                if (lost != 0) hint.eliminations.push_back({cell, lost});
+            }
+            if (hint.eliminations.empty()) continue;
+
+            hint.technique = hidden ? HintTechnique::HiddenSubset : HintTechnique::NakedSubset;
+            hint.digits = digitMask;
+            hint.unit = unit;
+            for (int position = 0; position < 9; ++position) {
+                if (cellMask >> position & 1) hint.reasons.push_back(cells[position]);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+bool HintFinder::findXWing(Hint& hint) const {
+    // Units 0-8 are the rows and 9-17 the columns; rows as the base lines
+    // cover columns and the other way round
+    for (int num = 1; num <= 9; ++num) {
+        std::uint16_t bit = digitBit(num);
+        for (int byRows = 1; byRows >= 0; --byRows) {
+            auto cellAt = [byRows](int line, int position) { return byRows ? line * 9 + position : position * 9 + line; };
+            std::array<std::uint16_t, 9> lines{};
+            for (int line = 0; line < 9; ++line) {
+                for (int position = 0; position < 9; ++position) {
+                    if (candidates[cellAt(line, position)] & bit) lines[line] |= static_cast<std::uint16_t>(1u << position);
+                }
+            }
+
+            for (int first = 0; first < 9; ++first) {
+                if (std::popcount(static_cast<unsigned>(lines[first])) != 2) continue;
+                for (int second = first + 1; second < 9; ++second) {
+                    if (lines[second] != lines[first]) continue;
+                    for (std::uint16_t cover = lines[first]; cover; cover &= cover - 1) {
+                        int position = std::countr_zero(cover);
+                        for (int line = 0; line < 9; ++line) {
+                            int cell = cellAt(line, position);
+                            if (line != first && line != second && (candidates[cell] & bit))
+                                hint.eliminations.push_back({static_cast<std::uint8_t>(cell), bit});
+                        }
+                    }
+                    if (hint.eliminations.empty()) continue;
+
+                    hint.technique = HintTechnique::XWing;
+                    hint.digit = num;
+                    hint.digits = bit;
+                    hint.unit = byRows ? first : 9 + first;
+                    for (std::uint16_t cover = lines[first]; cover; cover &= cover - 1) {
+                        hint.reasons.push_back(static_cast<std::uint8_t>(cellAt(first, std::countr_zero(cover))));
+                        hint.reasons.push_back(static_cast<std::uint8_t>(cellAt(second, std::countr_zero(cover))));
+                    }
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
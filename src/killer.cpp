@@ -0,0 +1,381 @@
+#include "killer.h"
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <span>
+
+namespace {
+
+// Every set of distinct digits (bit d-1 for digit d), sorted by size and
+// then sum, so the combinations a cage of n cells can use to make s are
+// one contiguous run
+struct CombinationTable {
+    static constexpr int kSums = 46;  // 0 to 1+2+...+9
+
+    std::array<std::uint16_t, 512> masks{};
+    std::array<std::uint16_t, 10 * kSums + 1> start{};
+
+    static constexpr int key(int mask) {
+        int sum = 0;
+        for (int digit = 1; digit <= 9; ++digit)
+            if (mask & (1 << (digit - 1))) sum += digit;
+        return std::popcount(static_cast<unsigned>(mask)) * kSums + sum;
+    }
+
+    constexpr CombinationTable() {
+        for (int mask = 0; mask < 512; ++mask) ++start[key(mask) + 1];
+        for (int k = 0; k < 10 * kSums; ++k) start[k + 1] += start[k];
+        std::array<std::uint16_t, 10 * kSums + 1> next = start;
+        for (int mask = 0; mask < 512; ++mask) masks[next[key(mask)]++] = static_cast<std::uint16_t>(mask);
+    }
+
+    std::span<const std::uint16_t> combinations(int size, int sum) const {
+        if (size < 0 || size > 9 || sum < 0 || sum >= kSums) return {};
+        int k = size * kSums + sum;
+        return {masks.data() + start[k], masks.data() + start[k + 1]};
+    }
+};
+
+constexpr CombinationTable kCombinations;
+static_assert(kCombinations.start.back() == 512);
+
+constexpr std::uint16_t kAllDigits = 0x1FF;
+constexpr std::uint8_t kNoCage = 0xFF;
+constexpr std::string_view kCageNames = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+
+inline std::uint16_t digitBit(int num) {
+    return static_cast<std::uint16_t>(1u << (num - 1));
+}
+
+} // namespace
+
+bool parseKiller(std::string_view text, KillerPuzzle& puzzle) {
+    auto nextField = [&text]() {
+        std::size_t begin = text.find_first_not_of(" \t\r\n");
+        if (begin == std::string_view::npos) begin = text.size();
+        std::size_t end = text.find_first_of(" \t\r\n", begin);
+        if (end == std::string_view::npos) end = text.size();
+        std::string_view field = text.substr(begin, end - begin);
+        text.remove_prefix(end);
+        return field;
+    };
+    std::string_view givens = nextField();
+    std::string_view map = nextField();
+    std::string_view sums = nextField();
+    if (givens.size() != 81 || map.size() != 81 || !nextField().empty()) return false;
+
+    KillerPuzzle parsed;
+    if (!parseBoard(givens, parsed.givens)) return false;
+
+    // Cages are numbered in order of first appearance in the map
+    std::array<int, 128> cageOfName;
+    cageOfName.fill(-1);
+    for (int cell = 0; cell < 81; ++cell) {
+        char name = map[cell];
+        if (name == '.') continue;
+        if (kCageNames.find(name) == std::string_view::npos) return false;
+        int& cage = cageOfName[static_cast<unsigned char>(name)];
+        if (cage < 0) {
+            cage = static_cast<int>(parsed.cages.size());
+            parsed.cages.emplace_back();
+        }
+        parsed.cages[cage].cells.push_back(static_cast<std::uint8_t>(cell));
+    }
+
+    for (std::size_t i = 0; i < parsed.cages.size(); ++i) {
+        if (i > 0) {
+            if (sums.empty() || sums.front() != ',') return false;
+            sums.remove_prefix(1);
+        }
+        auto [end, error] = std::from_chars(sums.data(), sums.data() + sums.size(), parsed.cages[i].sum);
+        if (error != std::errc()) return false;
+        sums.remove_prefix(end - sums.data());
+    }
+    if (!sums.empty()) return false;
+
+    puzzle = std::move(parsed);
+    return true;
+}
+
+std::string formatKiller(const KillerPuzzle& puzzle) {
+    std::array<int, 81> cageOf;
+    cageOf.fill(-1);
+    for (std::size_t i = 0; i < puzzle.cages.size(); ++i)
+        for (std::uint8_t cell : puzzle.cages[i].cells)
+            if (cell < 81) cageOf[cell] = static_cast<int>(i);
+
+    // Sums follow the order the cages first appear in the map; names are
+    // reused past the 62nd cage, so such puzzles do not round-trip
+    std::string map(81, '.');
+    std::string sums;
+    std::vector<char> names(puzzle.cages.size(), 0);
+    std::size_t named = 0;
+    for (int cell = 0; cell < 81; ++cell) {
+        int cage = cageOf[cell];
+        if (cage < 0) continue;
+        if (names[cage] == 0) {
+            names[cage] = kCageNames[named++ % kCageNames.size()];
+            if (!sums.empty()) sums += ',';
+            sums += std::to_string(puzzle.cages[cage].sum);
+        }
+        map[cell] = names[cage];
+    }
+    return formatBoard(puzzle.givens) + ' ' + map + ' ' + sums;
+}
+
+// Builds the peer lists (Sudoku peers plus cage mates), the derived cages
+// and the first search level from the givens
+bool KillerSolver::load(const KillerPuzzle& puzzle) {
+    cages = puzzle.cages;
+    cageOf.fill(kNoCage);
+    for (std::size_t i = 0; i < cages.size(); ++i) {
+        const Cage& cage = cages[i];
+        if (cage.cells.empty() || cage.cells.size() > 9 || i >= kNoCage) return false;
+        for (std::uint8_t cell : cage.cells) {
+            if (cell >= 81 || cageOf[cell] != kNoCage) return false;
+            cageOf[cell] = static_cast<std::uint8_t>(i);
+        }
+    }
+
+    for (int cell = 0; cell < 81; ++cell) {
+        int count = 0;
+        for (std::uint8_t peer : units->peers(cell)) peers[cell][count++] = peer;
+        if (cageOf[cell] != kNoCage) {
+            for (std::uint8_t mate : cages[cageOf[cell]].cells) {
+                if (mate != cell && !(units->unitMask(cell) & units->unitMask(mate)))
+                    peers[cell][count++] = mate;
+            }
+        }
+        peerCount[cell] = static_cast<std::uint8_t>(count);
+    }
+
+    // Rule of 45: the cells of a unit outside the cages lying wholly in it
+    // hold distinct digits making up the rest of 45, so they form a cage too
+    std::vector<std::uint64_t> sharedUnits(cages.size(), ~std::uint64_t{0});
+    for (std::size_t i = 0; i < cages.size(); ++i)
+        for (std::uint8_t cell : cages[i].cells) sharedUnits[i] &= units->unitMask(cell);
+    for (int unit = 0; unit < units->size(); ++unit) {
+        std::uint64_t unitBit = std::uint64_t{1} << unit;
+        Cage rest;
+        rest.sum = 45;
+        for (std::size_t i = 0; i < sharedUnits.size(); ++i)
+            if (sharedUnits[i] & unitBit) rest.sum -= cages[i].sum;
+        for (std::uint8_t cell : units->cells(unit)) {
+            if (cageOf[cell] == kNoCage || !(sharedUnits[cageOf[cell]] & unitBit)) rest.cells.push_back(cell);
+        }
+        if (rest.cells.empty() && rest.sum != 0) return false;
+        if (!rest.cells.empty() && rest.cells.size() < 9) cages.push_back(std::move(rest));
+    }
+
+    if (states.empty()) states.resize(82);
+    State& state = states[0];
+    state.candidates.fill(kAllDigits);
+    state.cells.fill(0);
+    for (int cell = 0; cell < 81; ++cell) {
+        int num = puzzle.givens[cell];
+        if (num == 0) continue;
+        if (num > 9 || !assign(state, cell, num)) return false;
+    }
+    return true;
+}
+
+bool KillerSolver::assign(State& state, int cell, int num) {
+    std::uint16_t bit = digitBit(num);
+    if (!(state.candidates[cell] & bit)) return false;
+    state.cells[cell] = static_cast<std::uint8_t>(num);
+    state.candidates[cell] = bit;
+    for (int i = 0; i < peerCount[cell]; ++i) {
+        std::uint8_t peer = peers[cell][i];
+        if (!(state.candidates[peer] & bit)) continue;
+        if (state.cells[peer] != 0) return false;
+        state.candidates[peer] &= ~bit;
+        stats.eliminations++;
+        if (state.candidates[peer] == 0) return false;
+    }
+    return true;
+}
+
+// Narrows a cage's open cells to the digits of the combinations that can
+// still make the rest of its sum, and places or points the digits every
+// such combination needs
+bool KillerSolver::restrictCage(State& state, int cage, bool& changed) {
+    const std::vector<std::uint8_t>& cells = cages[cage].cells;
+    int remaining = cages[cage].sum;
+    int open = 0;
+    std::array<std::uint8_t, 9> openCells;
+    std::uint16_t used = 0, reachable = 0;
+    for (std::uint8_t cell : cells) {
+        if (state.cells[cell] != 0) {
+            remaining -= state.cells[cell];
+            used |= digitBit(state.cells[cell]);
+        } else {
+            reachable |= state.candidates[cell];
+            openCells[open++] = cell;
+        }
+    }
+    if (open == 0) return remaining == 0;
+
+    // A combination needs a digit for every open cell, and each cell keeps
+    // only the digits some usable combination gives it
+    std::array<std::uint16_t, 9> allowed{};
+    std::uint16_t required = kAllDigits;
+    bool usable = false;
+    for (std::uint16_t mask : kCombinations.combinations(open, remaining)) {
+        if ((mask & used) || (mask & ~reachable)) continue;
+        bool fits = true;
+        for (int i = 0; i < open && fits; ++i) fits = (state.candidates[openCells[i]] & mask) != 0;
+        if (!fits) continue;
+        for (int i = 0; i < open; ++i) allowed[i] |= state.candidates[openCells[i]] & mask;
+        required &= mask;
+        usable = true;
+    }
+    if (!usable) return false;
+
+    for (int i = 0; i < open; ++i) {
+        std::uint16_t& candidates = state.candidates[openCells[i]];
+        if (allowed[i] == candidates) continue;
+        stats.eliminations += std::popcount(static_cast<unsigned>(candidates & ~allowed[i]));
+        candidates = allowed[i];
+        changed = true;
+    }
+
+    while (required) {
+        int num = std::countr_zero(required) + 1;
+        std::uint16_t bit = digitBit(num);
+        required &= required - 1;
+
+        int places = 0, place = -1;
+        std::uint64_t sharedUnits = ~std::uint64_t{0};
+        for (std::uint8_t cell : cells) {
+            if (state.cells[cell] != 0 || !(state.candidates[cell] & bit)) continue;
+            places++;
+            place = cell;
+            sharedUnits &= units->unitMask(cell);
+        }
+        if (places == 0) return false;
+        if (places == 1) {
+            if (!assign(state, place, num)) return false;
+            changed = true;
+            continue;
+        }
+
+        // The digit is inside the cage, so nowhere else in a unit holding
+        // all of its places
+        for (; sharedUnits; sharedUnits &= sharedUnits - 1) {
+            for (std::uint8_t cell : units->cells(std::countr_zero(sharedUnits))) {
+                if (!(state.candidates[cell] & bit) || std::find(cells.begin(), cells.end(), cell) != cells.end())
+                    continue;
+                if (state.cells[cell] != 0) return false;
+                state.candidates[cell] &= ~bit;
+                stats.eliminations++;
+                if (state.candidates[cell] == 0) return false;
+                changed = true;
+            }
+        }
+    }
+    return true;
+}
+
+// Naked singles, hidden singles and cage combinations until nothing changes
+bool KillerSolver::propagate(State& state) {
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int cell = 0; cell < 81; ++cell) {
+            if (state.cells[cell] == 0 && std::has_single_bit(state.candidates[cell])) {
+                if (!assign(state, cell, std::countr_zero(state.candidates[cell]) + 1)) return false;
+                changed = true;
+            }
+        }
+
+        for (int index = 0; index < units->size(); ++index) {
+            const UnitTable::Unit& unit = units->cells(index);
+            std::uint16_t once = 0, twice = 0, placed = 0;
+            for (std::uint8_t cell : unit) {
+                if (state.cells[cell] != 0) {
+                    placed |= digitBit(state.cells[cell]);
+                } else {
+                    twice |= once & state.candidates[cell];
+                    once |= state.candidates[cell];
+                }
+            }
+            if ((once | placed) != kAllDigits) return false;
+
+            for (std::uint16_t singles = once & ~twice & ~placed; singles; singles &= singles - 1) {
+                int num = std::countr_zero(singles) + 1;
+                int place = -1;
+                for (std::uint8_t cell : unit) {
+                    if (state.cells[cell] == 0 && (state.candidates[cell] & digitBit(num))) place = cell;
+                }
+                if (place < 0 || !assign(state, place, num)) return false;
+                changed = true;
+            }
+        }
+
+        for (int cage = 0; cage < static_cast<int>(cages.size()); ++cage) {
+            if (!restrictCage(state, cage, changed)) return false;
+        }
+    }
+    return true;
+}
+
+bool KillerSolver::search(int depth) {
+    // The clock is read every few hundred nodes
+    constexpr std::uint64_t kClockInterval = 256;
+
+    const State& state = states[depth];
+    if (depth > stats.maxDepth) stats.maxDepth = depth;
+
+    // Branch on the open cell with the fewest candidates
+    int best = -1, bestCount = 10;
+    for (int cell = 0; cell < 81 && bestCount > 2; ++cell) {
+        if (state.cells[cell] != 0) continue;
+        int count = std::popcount(static_cast<unsigned>(state.candidates[cell]));
+        if (count < bestCount) {
+            best = cell;
+            bestCount = count;
+        }
+    }
+    if (best < 0) {
+        solved = state.cells;
+        return true;
+    }
+
+    for (std::uint16_t candidates = state.candidates[best]; candidates; candidates &= candidates - 1) {
+        if (stats.nodes >= nodeLimit ||
+            (stats.nodes % kClockInterval == 0 &&
+             (SolveLimits::Clock::now() >= deadline || stop.stop_requested()))) {
+            timedOut = true;
+            return false;
+        }
+        stats.nodes++;
+        State& next = states[depth + 1];
+        next = state;
+        if (assign(next, best, std::countr_zero(candidates) + 1) && propagate(next) && search(depth + 1))
+            return true;
+        if (timedOut) return false;
+        stats.backtracks++;
+    }
+    return false;
+}
+
+SolveStatus KillerSolver::solve(const KillerPuzzle& puzzle, Board& solution, const SolveLimits& limits) {
+    stats = SolveStats();
+    timedOut = false;
+    deadline = limits.deadlineFrom(SolveLimits::Clock::now());
+    nodeLimit = limits.maxNodes > 0 ? limits.maxNodes : UINT64_MAX;
+    stop = limits.stop;
+
+    PhaseTimer setupTimer;
+    bool consistent = load(puzzle) && propagate(states[0]);
+    stats.setupNs = setupTimer.elapsedNs();
+    if (!consistent) return SolveStatus::Unsolvable;
+
+    PhaseTimer searchTimer;
+    bool found = search(0);
+    stats.searchNs = searchTimer.elapsedNs();
+    if (timedOut) return stop.stop_requested() ? SolveStatus::Cancelled : SolveStatus::TimedOut;
+    if (!found) return SolveStatus::Unsolvable;
+    solution = solved;
+    return SolveStatus::Solved;
+}
@@ -31,10 +31,14 @@ MainWindow::MainWindow(QWidget *parent)
     , isDarkTheme(settings.value("darkTheme", false).toBool())
     , puzzlesSolved(settings.value("puzzlesSolved", 0).toInt())
     , bestTime(settings.value("bestTime", -1).toInt())
-    , solveStartTime(QTime::currentTime())
+    , hasSolveStats(false)
     , mistakes(0)
     , score(0)
     , gameTimer(new QTimer(this))
+    , replayBox(nullptr)
+    , playbackTimer(new QTimer(this))
+    , solveTrace(1 << 18)
+    , playbackIndex(0)
 {
     // Set window properties
     setWindowTitle("Sudoku Solver");
@@ -64,8 +68,25 @@ MainWindow::MainWindow(QWidget *parent)
     difficultyBox->setFixedWidth(140);
     difficultyBox->setFont(QFont("SF Pro Display", 14));
     
+    // Replay speed for the Solve button (milliseconds per trace event)
+    replayBox = new QComboBox(this);
+    replayBox->addItem("Instant solve", 0);
+    replayBox->addItem("Replay: Slow", 120);
+    replayBox->addItem("Replay: Normal", 40);
+    replayBox->addItem("Replay: Fast", 5);
+    replayBox->setFixedWidth(180);
+    replayBox->setFont(QFont("SF Pro Display", 14));
+    
+    // Variant rules, applied to validation, hints and solving
+    QComboBox* rulesBox = new QComboBox(this);
+    rulesBox->addItems({"Classic", "Diagonal", "Windoku"});
+    rulesBox->setFixedWidth(140);
+    rulesBox->setFont(QFont("SF Pro Display", 14));
+    
     titleLayout->addWidget(titleLabel);
     titleLayout->addWidget(difficultyBox);
+    titleLayout->addWidget(replayBox);
+    titleLayout->addWidget(rulesBox);
     titleLayout->addStretch();
     
     // Right side: Controls
@@ -75,14 +96,17 @@ MainWindow::MainWindow(QWidget *parent)
     QPushButton* themeButton = createIconButton(isDarkTheme ? "☀️" : "🌙", "Toggle theme");
     QPushButton* saveButton = createIconButton("💾", "Save puzzle");
     QPushButton* loadButton = createIconButton("📂", "Load puzzle");
+    QPushButton* statsButton = createIconButton("📊", "Statistics");
     
     connect(themeButton, &QPushButton::clicked, this, &MainWindow::toggleTheme);
     connect(saveButton, &QPushButton::clicked, this, &MainWindow::saveGrid);
     connect(loadButton, &QPushButton::clicked, this, &MainWindow::loadGrid);
+    connect(statsButton, &QPushButton::clicked, this, &MainWindow::showStats);
     
     controlsLayout->addWidget(themeButton);
     controlsLayout->addWidget(saveButton);
     controlsLayout->addWidget(loadButton);
+    controlsLayout->addWidget(statsButton);
     
     headerLayout->addLayout(titleLayout);
     headerLayout->addLayout(controlsLayout);
@@ -130,6 +154,9 @@ MainWindow::MainWindow(QWidget *parent)
     gridWidget->setMinimumSize(500, 500);
     connect(gridWidget, &SudokuGrid::gridChanged, this, &MainWindow::onGridChanged);
     connect(gridWidget, &SudokuGrid::validityChanged, this, &MainWindow::onValidityChanged);
+    connect(gridWidget, &SudokuGrid::hintShown, [this](const Hint& hint) {
+        showMessage(describeHint(hint), "#0984e3");
+    });
     connect(gridWidget, &SudokuGrid::puzzleSolved, [this](int timeInSeconds) {
         gameTimer->stop();
         showMessage("🎉 Puzzle solved!", "#00b894");
@@ -215,6 +242,15 @@ MainWindow::MainWindow(QWidget *parent)
     newGameButton->setFont(QFont("SF Pro Display", 16, QFont::DemiBold));
     newGameButton->setStyleSheet(getButtonStyle("#0984e3"));
     
+    connect(rulesBox, &QComboBox::currentTextChanged, [this](const QString& rules) {
+        stopPlayback();
+        UnitTable table;
+        if (rules == "Diagonal") table.addDiagonals();
+        if (rules == "Windoku") table.addWindows();
+        gridWidget->setUnits(table);
+        solver.setUnits(gridWidget->getUnits());
+    });
+    
     connect(newGameButton, &QPushButton::clicked, [this, difficultyBox]() {
         if (gridWidget) {
             gridWidget->newGame(difficultyBox->currentText());
@@ -280,6 +316,9 @@ MainWindow::MainWindow(QWidget *parent)
         }
     });
     
+    // Solve replay steps through the recorded trace
+    connect(playbackTimer, &QTimer::timeout, this, &MainWindow::playNextTraceEvent);
+    
     // Apply initial theme
     applyTheme(isDarkTheme);
 }
@@ -507,17 +546,37 @@ QString MainWindow::getButtonStyle(const QString& color) {
 }
 
 void MainWindow::onSolveClicked() {
+    // Mid-replay the grid shows a half-searched board; check and solve the
+    // puzzle the replay started from instead
+    stopPlayback();
     if (!gridWidget || !gridWidget->isValid()) {
         showMessage("Cannot solve invalid puzzle", "#d63031");
         return;
     }
     
-    solver.setGrid(gridWidget->getGrid());
-    solveStartTime = QTime::currentTime();
+    std::vector<std::vector<int>> puzzle = gridWidget->getGrid();
+    if (Contradiction contradiction = findContradiction(boardFromGrid(puzzle), gridWidget->getUnits())) {
+        showMessage(describeContradiction(contradiction), "#d63031");
+        return;
+    }
+    
+    int replayInterval = replayBox ? replayBox->currentData().toInt() : 0;
     
-    if (solver.solve()) {
-        gridWidget->setGrid(solver.getGrid());
-        int timeInSeconds = solveStartTime.secsTo(QTime::currentTime());
+    solver.setGrid(puzzle);
+    solveTrace.clear();
+    solver.setTrace(replayInterval > 0 ? &solveTrace : nullptr);
+    
+    // Pathological puzzles would otherwise freeze the window indefinitely
+    SolveLimits limits;
+    limits.timeBudget = std::chrono::seconds(10);
+    SolveStatus status = solver.solve(limits);
+    bool solved = status == SolveStatus::Solved;
+    solver.setTrace(nullptr);
+    hasSolveStats = true;
+    
+    const SolveStats& solveStats = solver.getStats();
+    if (solved) {
+        int timeInSeconds = static_cast<int>(solveStats.totalNs() / 1000000000);
         puzzlesSolved++;
         if (bestTime == -1 || timeInSeconds < bestTime) {
             bestTime = timeInSeconds;
@@ -525,13 +584,63 @@ void MainWindow::onSolveClicked() {
         settings.setValue("puzzlesSolved", puzzlesSolved);
         settings.setValue("bestTime", bestTime);
         updateStats();
-        showMessage(QString("🎉 Puzzle solved in %1!").arg(QTime(0, 0).addSecs(timeInSeconds).toString("mm:ss")), "#00b894");
+        
+        if (replayInterval > 0 && !solveTrace.wrapped()) {
+            // Replay the recorded search; the solution is applied when playback ends
+            playbackPuzzle = puzzle;
+            playbackSolution = solver.getGrid();
+            playbackIndex = 0;
+            gridWidget->setEnabled(false);
+            playbackTimer->start(replayInterval);
+            return;
+        }
+        
+        gridWidget->setGrid(solver.getGrid());
+        if (replayInterval > 0) {
+            showMessage("Search too long to replay, showing the solution", "#636e72");
+        } else {
+            showMessage(QString("🎉 Puzzle solved in %1 (%2 nodes)!")
+                .arg(formatDuration(solveStats.totalNs()))
+                .arg(solveStats.nodes), "#00b894");
+        }
+    } else if (status == SolveStatus::TimedOut) {
+        showMessage(QString("Gave up after %1 (%2 nodes)")
+            .arg(formatDuration(solveStats.totalNs()))
+            .arg(solveStats.nodes), "#d63031");
     } else {
         showMessage("No solution exists for this puzzle", "#d63031");
     }
 }
 
+void MainWindow::playNextTraceEvent() {
+    // Skip over eliminations and givens so every tick shows a visible change
+    while (playbackIndex < solveTrace.size() &&
+           (solveTrace.at(playbackIndex).type == TraceEventType::Eliminate ||
+            solveTrace.at(playbackIndex).technique == SolveTechnique::Given)) {
+        playbackIndex++;
+    }
+    
+    if (playbackIndex >= solveTrace.size()) {
+        stopPlayback();
+        gridWidget->setGrid(playbackSolution);
+        showMessage(QString("🎉 Replayed %1 solver steps").arg(solveTrace.size()), "#00b894");
+        return;
+    }
+    
+    gridWidget->showTraceEvent(solveTrace.at(playbackIndex++));
+}
+
+void MainWindow::stopPlayback() {
+    if (!playbackTimer->isActive()) return;
+    
+    // Put back the puzzle the replay started from
+    playbackTimer->stop();
+    gridWidget->restoreAfterPlayback(playbackPuzzle);
+    gridWidget->setEnabled(true);
+}
+
 void MainWindow::onClearClicked() {
+    stopPlayback();
     if (gridWidget) {
         gridWidget->clear();
         showMessage("Grid cleared", "#636e72");
@@ -551,15 +660,18 @@ void MainWindow::saveGrid() {
         this,
         "Save Puzzle",
         QDir::homePath(),
-        "Sudoku Files (*.sudoku)"
+        "Sudoku Files (*.sudoku);;Puzzle Collections (*.sdm *.sdk *.csv)"
     );
     
     if (!fileName.isEmpty()) {
-        if (!fileName.endsWith(".sudoku")) {
+        bool isCollection = SudokuGrid::isCollectionFile(fileName);
+        if (!isCollection && !fileName.endsWith(".sudoku")) {
             fileName += ".sudoku";
         }
         
-        if (gridWidget->savePuzzleToFile(fileName)) {
+        bool saved = isCollection ? gridWidget->exportToCollectionFile(fileName)
+                                  : gridWidget->savePuzzleToFile(fileName);
+        if (saved) {
             showMessage("💾 Puzzle saved successfully!", "#00b894");
         } else {
             showMessage("Failed to save puzzle", "#d63031");
@@ -574,11 +686,13 @@ void MainWindow::loadGrid() {
         this,
         "Load Puzzle",
         QDir::homePath(),
-        "Sudoku Files (*.sudoku)"
+        "Sudoku Files (*.sudoku);;Puzzle Collections (*.sdm *.sdk *.csv *.txt)"
     );
     
     if (!fileName.isEmpty()) {
-        if (gridWidget->loadPuzzleFromFile(fileName)) {
+        bool loaded = SudokuGrid::isCollectionFile(fileName) ? gridWidget->importFromCollectionFile(fileName)
+                                                             : gridWidget->loadPuzzleFromFile(fileName);
+        if (loaded) {
             showMessage("📂 Puzzle loaded successfully!", "#00b894");
             gameTimer->start(1000);
             mistakes = 0;
@@ -608,7 +722,105 @@ void MainWindow::updateStats() {
     }
 }
 
+QString MainWindow::formatDuration(std::int64_t ns) const {
+    if (ns < 1000) return QString("%1 ns").arg(ns);
+    if (ns < 1000000) return QString("%1 µs").arg(ns / 1e3, 0, 'f', 1);
+    if (ns < 1000000000) return QString("%1 ms").arg(ns / 1e6, 0, 'f', 2);
+    return QString("%1 s").arg(ns / 1e9, 0, 'f', 2);
+}
+
+QString MainWindow::unitName(int unit) const {
+    static const char* unitKinds[] = {"row", "column", "box", "diagonal", "window"};
+    // Number the unit among those of its kind
+    const UnitTable& units = gridWidget->getUnits();
+    UnitKind kind = units.kind(unit);
+    int number = 1;
+    for (int other = 0; other < unit; ++other) {
+        if (units.kind(other) == kind) number++;
+    }
+    return QString("%1 %2").arg(unitKinds[static_cast<int>(kind)]).arg(number);
+}
+
+QString MainWindow::describeContradiction(const Contradiction& contradiction) const {
+    auto cellName = [](int cell) { return QString("R%1C%2").arg(cell / 9 + 1).arg(cell % 9 + 1); };
+    switch (contradiction.kind) {
+        case ContradictionKind::Clash:
+            return QString("No solution: %1 cannot hold %2").arg(cellName(contradiction.cell)).arg(contradiction.digit);
+        case ContradictionKind::NoCandidates:
+            return QString("No solution: no digit fits %1").arg(cellName(contradiction.cell));
+        case ContradictionKind::NoPlaceForDigit:
+            return QString("No solution: %1 has no place in %2").arg(contradiction.digit).arg(unitName(contradiction.unit));
+        case ContradictionKind::None:
+            break;
+    }
+    return QString();
+}
+
+QString MainWindow::describeHint(const Hint& hint) const {
+    auto cellName = [](int cell) { return QString("R%1C%2").arg(cell / 9 + 1).arg(cell % 9 + 1); };
+    auto digitList = [](std::uint16_t digits) {
+        QStringList list;
+        for (int num = 1; num <= 9; ++num) {
+            if (digits >> (num - 1) & 1) list << QString::number(num);
+        }
+        return list.join(",");
+    };
+    QStringList removed;
+    for (const HintElimination& elimination : hint.eliminations) {
+        removed << QString("%1 from %2").arg(digitList(elimination.digits)).arg(cellName(elimination.cell));
+    }
+
+    switch (hint.technique) {
+        case HintTechnique::NakedSingle:
+            return QString("Naked single: %1 is the only digit left for %2").arg(hint.digit).arg(cellName(hint.cell));
+        case HintTechnique::HiddenSingle:
+            return QString("Hidden single: %1 is the only place for %2 in %3")
+                .arg(cellName(hint.cell))
+                .arg(hint.digit)
+                .arg(unitName(hint.unit));
+        case HintTechnique::LockedCandidates:
+            return QString("Locked candidates: %1 in %2 lies in %3, remove %4")
+                .arg(hint.digit)
+                .arg(unitName(hint.unit))
+                .arg(unitName(hint.otherUnit))
+                .arg(removed.join("; "));
+        case HintTechnique::NakedSubset:
+            return QString("Naked subset: %1 fill the highlighted cells of %2, remove %3")
+                .arg(digitList(hint.digits))
+                .arg(unitName(hint.unit))
+                .arg(removed.join("; "));
+        case HintTechnique::HiddenSubset:
+            return QString("Hidden subset: %1 only fit the highlighted cells of %2, remove %3")
+                .arg(digitList(hint.digits))
+                .arg(unitName(hint.unit))
+                .arg(removed.join("; "));
+        case HintTechnique::XWing:
+            return QString("X-Wing on %1, remove %2").arg(hint.digit).arg(removed.join("; "));
+        case HintTechnique::None:
+            break;
+    }
+    return QString("No simple step found, revealed a cell from the solution");
+}
+
 void MainWindow::showStats() {
+    QString solverText = "No puzzle solved yet";
+    if (hasSolveStats) {
+        const SolveStats& solveStats = solver.getStats();
+        solverText = QString(
+            "Nodes Expanded: %1<br>"
+            "Backtracks: %2<br>"
+            "Candidates Eliminated: %3<br>"
+            "Max Depth: %4<br>"
+            "Setup Time: %5<br>"
+            "Search Time: %6"
+        ).arg(solveStats.nodes)
+         .arg(solveStats.backtracks)
+         .arg(solveStats.eliminations)
+         .arg(solveStats.maxDepth)
+         .arg(formatDuration(solveStats.setupNs))
+         .arg(formatDuration(solveStats.searchNs));
+    }
+    
     QMessageBox stats(this);
     stats.setWindowTitle("Statistics");
     stats.setText("<h2>Your Sudoku Stats</h2>");
@@ -618,11 +830,15 @@ void MainWindow::showStats() {
         "<br>"
         "<b>Current Session:</b><br>"
         "Moves Made: %3<br>"
-        "Hints Used: %4"
+        "Hints Used: %4<br>"
+        "<br>"
+        "<b>Last Solver Run:</b><br>"
+        "%5"
     ).arg(puzzlesSolved)
      .arg(bestTime > 0 ? QTime(0, 0).addSecs(bestTime).toString("mm:ss") : "--:--")
      .arg(gridWidget->getCurrentState().moveCount)
-     .arg(settings.value("hintsUsed", 0).toInt()));
+     .arg(settings.value("hintsUsed", 0).toInt())
+     .arg(solverText));
 
     stats.setStyleSheet(isDarkTheme ? 
         "QMessageBox { background-color: #1a1a2e; } QLabel { color: white; }" :
@@ -758,6 +974,9 @@ void MainWindow::createMenus() {
     gridWidget = new SudokuGrid(this);
     connect(gridWidget, &SudokuGrid::gridChanged, this, &MainWindow::onGridChanged);
     connect(gridWidget, &SudokuGrid::validityChanged, this, &MainWindow::onValidityChanged);
+    connect(gridWidget, &SudokuGrid::hintShown, [this](const Hint& hint) {
+        showMessage(describeHint(hint), "#0984e3");
+    });
     connect(gridWidget, &SudokuGrid::puzzleSolved, [this](int timeInSeconds) {
         gameTimer->stop();
         showMessage("🎉 Puzzle solved!", "#00b894");
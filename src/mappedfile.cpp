@@ -0,0 +1,166 @@
+#include "mappedfile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string& path) {
+    open(path);
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        return false;
+    }
+    fileHandle = file;
+    opened = true;
+    length = static_cast<std::size_t>(size.QuadPart);
+    if (length == 0) return true;
+
+    mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mappingHandle) data = static_cast<const char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if (!data) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool MappedFile::openWritable(const std::string& path, std::size_t size) {
+    close();
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER newSize;
+    newSize.QuadPart = static_cast<LONGLONG>(size);
+    if (!SetFilePointerEx(file, newSize, nullptr, FILE_BEGIN) || !SetEndOfFile(file)) {
+        CloseHandle(file);
+        return false;
+    }
+    fileHandle = file;
+    opened = true;
+    writable = true;
+    length = size;
+    if (length == 0) return true;
+
+    mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+    if (mappingHandle) data = static_cast<const char*>(MapViewOfFile(mappingHandle, FILE_MAP_WRITE, 0, 0, 0));
+    if (!data) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool MappedFile::flush(std::size_t offset, std::size_t count) {
+    if (!writable || !data || offset >= length) return true;
+    count = count < length - offset ? count : length - offset;
+    return FlushViewOfFile(data + offset, count) && FlushFileBuffers(fileHandle);
+}
+
+void MappedFile::close() {
+    if (data) UnmapViewOfFile(data);
+    if (mappingHandle) CloseHandle(mappingHandle);
+    if (fileHandle) CloseHandle(fileHandle);
+    data = nullptr;
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+    length = 0;
+    opened = false;
+    writable = false;
+}
+
+#else
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        ::close(fd);
+        return false;
+    }
+    length = static_cast<std::size_t>(info.st_size);
+
+    // An empty file has nothing to map but is still a valid input
+    if (length > 0) {
+        void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            ::close(fd);
+            length = 0;
+            return false;
+        }
+        // Records are read front to back; let the kernel read ahead aggressively
+        madvise(mapped, length, MADV_SEQUENTIAL);
+        data = static_cast<const char*>(mapped);
+    }
+    // The mapping stays valid after the descriptor is closed
+    ::close(fd);
+    opened = true;
+    return true;
+}
+
+bool MappedFile::openWritable(const std::string& path, std::size_t size) {
+    close();
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return false;
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    if (size > 0) {
+        void* mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapped == MAP_FAILED) {
+            ::close(fd);
+            return false;
+        }
+        data = static_cast<const char*>(mapped);
+    }
+    ::close(fd);
+    length = size;
+    opened = true;
+    writable = true;
+    return true;
+}
+
+bool MappedFile::flush(std::size_t offset, std::size_t count) {
+    if (!writable || !data || offset >= length) return true;
+    count = count < length - offset ? count : length - offset;
+
+    // msync wants a page-aligned start
+    std::size_t page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    std::size_t start = offset - offset % page;
+    return msync(const_cast<char*>(data) + start, count + (offset - start), MS_SYNC) == 0;
+}
+
+void MappedFile::close() {
+    if (data) munmap(const_cast<char*>(data), length);
+    data = nullptr;
+    length = 0;
+    opened = false;
+    writable = false;
+}
+
+#endif
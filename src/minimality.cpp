@@ -0,0 +1,204 @@
+#include "minimality.h"
+#include "contradiction.h"
+#include "solver.h"
+#include "threadpool.h"
+#include "transposition.h"
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <span>
+
+namespace {
+
+inline std::uint16_t digitBit(int num) {
+    return static_cast<std::uint16_t>(1u << (num - 1));
+}
+
+enum class ClueTest : std::uint8_t {
+    Needed,     // Another digit fits there once it is cleared
+    Redundant,  // The solution stays unique without it
+    Stopped     // The test hit a limit or a stop request
+};
+
+// The limits with the time budget turned into a deadline, so it spans
+// every test
+SolveLimits sharedLimits(const SolveLimits& limits) {
+    SolveLimits shared = limits;
+    shared.deadline = limits.deadlineFrom(SolveLimits::Clock::now());
+    shared.timeBudget = std::chrono::nanoseconds(0);
+    return shared;
+}
+
+// What the tests of one call share
+struct TestContext {
+    explicit TestContext(const MinimalityOptions& options)
+        : units(options.units ? *options.units : UnitTable::classic()),
+          table(options.transpositions),
+          limits(sharedLimits(options.limits)) {
+        if (!table) {
+            ownTable = std::make_unique<TranspositionTable>();
+            table = ownTable.get();
+        }
+    }
+
+    const UnitTable& units;
+    TranspositionTable* table;
+    std::unique_ptr<TranspositionTable> ownTable;
+    SolveLimits limits;
+    SolveStatus stopStatus = SolveStatus::TimedOut;  // Of the first stopped test
+    SolveStats stats;
+    std::mutex mutex;  // Guards stopStatus and stats
+};
+
+// Whether the clue at cell can be cleared from puzzle, whose only solution
+// is solution: it can when no other digit there leads to a solution
+ClueTest testClue(Board puzzle, const Board& solution, int cell, SudokuSolver& solver, SolverWorkspace& ws,
+                  TestContext& context, SolveStats& stats) {
+    puzzle[cell] = 0;
+    std::uint16_t used = 0;
+    for (std::uint8_t peer : context.units.peers(cell)) {
+        if (puzzle[peer] != 0) used |= digitBit(puzzle[peer]);
+    }
+    for (int num = 1; num <= 9; ++num) {
+        if (num == solution[cell] || (used & digitBit(num))) continue;
+        puzzle[cell] = static_cast<std::uint8_t>(num);
+        // Singles settle most digits without a search: they either run
+        // into a dead end or leave a much smaller board to search
+        Board filled;
+        if (placeSingles(puzzle, filled, context.units)) continue;
+        // Counting to one stops at the first solution and, unlike solve(),
+        // records and skips dead ends in the shared table
+        std::uint64_t found;
+        SolveStatus status = solver.countSolutions(filled, ws, found, 1, context.limits);
+        stats += solver.getStats();
+        if (status == SolveStatus::Solved) return ClueTest::Needed;
+        if (status != SolveStatus::Unsolvable) {
+            std::lock_guard<std::mutex> lock(context.mutex);
+            context.stopStatus = status;
+            return ClueTest::Stopped;
+        }
+    }
+    return ClueTest::Redundant;
+}
+
+// Tests the clues at cells of puzzle into results, on the pool's threads
+// when there is one
+void testClues(const Board& puzzle, const Board& solution, std::span<const int> cells, ThreadPool* pool,
+               TestContext& context, std::span<ClueTest> results) {
+    std::atomic<std::size_t> next{0};
+    auto worker = [&] {
+        SudokuSolver solver;
+        solver.setUnits(context.units);
+        solver.setTranspositions(context.table);
+        SolverWorkspace ws;
+        SolveStats stats;
+        std::size_t index;
+        while ((index = next.fetch_add(1, std::memory_order_relaxed)) < cells.size()) {
+            results[index] = testClue(puzzle, solution, cells[index], solver, ws, context, stats);
+        }
+        std::lock_guard<std::mutex> lock(context.mutex);
+        context.stats += stats;
+    };
+
+    std::size_t workers = pool ? std::min(pool->size(), cells.size()) : 1;
+    if (workers <= 1) {
+        worker();
+        return;
+    }
+    std::vector<std::future<void>> done;
+    for (std::size_t i = 0; i < workers; ++i) done.push_back(pool->submit(worker));
+    for (auto& future : done) future.get();
+}
+
+// Up to two solutions of puzzle into count, the first into solution
+SolveStatus findSolution(const Board& puzzle, TestContext& context, Board& solution, std::uint64_t& count) {
+    SudokuSolver solver;
+    solver.setUnits(context.units);
+    solver.setTranspositions(context.table);
+    SolutionCallback keepFirst = [&](const Board& found) {
+        if (count == 0) solution = found;
+        return true;
+    };
+    SolveStatus status = solver.enumerateSolutions(puzzle, SudokuSolver::threadWorkspace(), keepFirst, count, 2,
+                                                   context.limits);
+    context.stats += solver.getStats();
+    return status;
+}
+
+std::vector<int> clueCells(const Board& puzzle) {
+    std::vector<int> cells;
+    for (int cell = 0; cell < 81; ++cell) {
+        if (puzzle[cell] != 0) cells.push_back(cell);
+    }
+    return cells;
+}
+
+} // namespace
+
+SolveStatus checkMinimality(const Board& puzzle, const MinimalityOptions& options, MinimalityReport& report,
+                            SolveStats* stats) {
+    report = MinimalityReport();
+    TestContext context(options);
+
+    Board solution{};
+    SolveStatus status = findSolution(puzzle, context, solution, report.solutions);
+    if (status == SolveStatus::Solved && report.solutions == 1) {
+        std::vector<int> cells = clueCells(puzzle);
+        std::vector<ClueTest> results(cells.size(), ClueTest::Stopped);
+        testClues(puzzle, solution, cells, options.pool, context, results);
+        for (std::size_t i = 0; i < cells.size(); ++i) {
+            if (results[i] == ClueTest::Redundant) report.redundant.push_back(cells[i]);
+            if (results[i] == ClueTest::Stopped) status = context.stopStatus;
+        }
+    }
+    if (stats) *stats = context.stats;
+    return status;
+}
+
+SolveStatus reduceToMinimal(const Board& puzzle, const MinimalityOptions& options, Board& minimal,
+                            SolveStats* stats, std::uint64_t* solutions) {
+    TestContext context(options);
+
+    Board solution{};
+    std::uint64_t count = 0;
+    SolveStatus status = findSolution(puzzle, context, solution, count);
+    if (solutions) *solutions = count;
+    if (status == SolveStatus::Solved && count != 1) status = SolveStatus::Unsolvable;
+
+    Board current = puzzle;
+    std::vector<int> pending = clueCells(puzzle);
+    // One test per thread at a time: a batch any larger mostly tests clues
+    // against a puzzle that is about to lose one
+    std::size_t batchSize = options.pool ? options.pool->size() : 1;
+    std::vector<ClueTest> results;
+    while (status == SolveStatus::Solved && !pending.empty()) {
+        std::size_t batch = std::min(batchSize, pending.size());
+        results.assign(batch, ClueTest::Stopped);
+        testClues(current, solution, std::span<const int>(pending.data(), batch), options.pool, context, results);
+
+        std::vector<int> retest;
+        bool removed = false;
+        for (std::size_t i = 0; i < batch; ++i) {
+            if (results[i] == ClueTest::Stopped) {
+                status = context.stopStatus;
+                break;
+            }
+            // Needed stays needed; redundant only holds for the first
+            // removal of the batch, the others are tested again
+            if (results[i] == ClueTest::Redundant && !removed) {
+                current[pending[i]] = 0;
+                removed = true;
+            } else if (results[i] == ClueTest::Redundant) {
+                retest.push_back(pending[i]);
+            }
+        }
+        retest.insert(retest.end(), pending.begin() + static_cast<std::ptrdiff_t>(batch), pending.end());
+        pending = std::move(retest);
+    }
+
+    if (status == SolveStatus::Solved) minimal = current;
+    if (stats) *stats = context.stats;
+    return status;
+}
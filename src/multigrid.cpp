@@ -0,0 +1,345 @@
+#include "multigrid.h"
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <map>
+
+namespace {
+
+constexpr std::uint16_t kAllDigits = 0x1FF;
+
+inline std::uint16_t digitBit(int num) {
+    return static_cast<std::uint16_t>(1u << (num - 1));
+}
+
+} // namespace
+
+const MultiGrid& MultiGrid::samurai() {
+    static const MultiGrid layout = [] {
+        MultiGrid grid;
+        grid.addGrid(0, 0);
+        grid.addGrid(0, 12);
+        grid.addGrid(6, 6);
+        grid.addGrid(12, 0);
+        grid.addGrid(12, 12);
+        return grid;
+    }();
+    return layout;
+}
+
+bool MultiGrid::addGrid(int row, int col) {
+    if (row < 0 || col < 0) return false;
+    int added = 81;
+    for (const auto& origin : origins) {
+        int rowOffset = row - origin[0], colOffset = col - origin[1];
+        if (std::abs(rowOffset) >= 9 || std::abs(colOffset) >= 9) continue;
+        if (rowOffset % 3 != 0 || colOffset % 3 != 0) return false;
+        if (rowOffset == 0 && colOffset == 0) return false;
+    }
+    // Cells already covered are shared, not added
+    for (int r = row; r < row + 9; ++r) {
+        for (int c = col; c < col + 9; ++c) {
+            for (const auto& position : positions) {
+                if (position[0] == r && position[1] == c) {
+                    added--;
+                    break;
+                }
+            }
+        }
+    }
+    if (cellCount() + added > kMaxCells) return false;
+    origins.push_back({row, col});
+    rebuild();
+    return true;
+}
+
+// Numbers the cells (in square order), then derives the units of every
+// grid and each cell's units and peers
+void MultiGrid::rebuild() {
+    std::map<std::array<int, 2>, std::uint16_t> index;
+    for (const auto& origin : origins)
+        for (int i = 0; i < 81; ++i) index[{origin[0] + i / 9, origin[1] + i % 9}] = 0;
+    positions.clear();
+    for (auto& [position, cell] : index) {
+        cell = static_cast<std::uint16_t>(positions.size());
+        positions.push_back(position);
+    }
+
+    gridCells.clear();
+    units.clear();
+    for (const auto& origin : origins) {
+        std::size_t first = gridCells.size();
+        for (int i = 0; i < 81; ++i) gridCells.push_back(index[{origin[0] + i / 9, origin[1] + i % 9}]);
+        const std::uint16_t* grid = gridCells.data() + first;
+        for (int i = 0; i < 9; ++i) {
+            Unit row, column, box;
+            for (int j = 0; j < 9; ++j) {
+                row[j] = grid[i * 9 + j];
+                column[j] = grid[j * 9 + i];
+                box[j] = grid[(i / 3 * 3 + j / 3) * 9 + i % 3 * 3 + j % 3];
+            }
+            for (const Unit& unit : {row, column, box}) {
+                if (std::find(units.begin(), units.end(), unit) == units.end()) units.push_back(unit);
+            }
+        }
+    }
+
+    std::vector<std::vector<std::uint16_t>> unitsOfCell(positions.size());
+    for (std::size_t unit = 0; unit < units.size(); ++unit)
+        for (std::uint16_t cell : units[unit]) unitsOfCell[cell].push_back(static_cast<std::uint16_t>(unit));
+
+    unitStart.assign(1, 0);
+    cellUnits.clear();
+    peerStart.assign(1, 0);
+    peerList.clear();
+    std::vector<std::uint16_t> cellPeers;
+    for (std::size_t cell = 0; cell < positions.size(); ++cell) {
+        cellUnits.insert(cellUnits.end(), unitsOfCell[cell].begin(), unitsOfCell[cell].end());
+        unitStart.push_back(static_cast<std::uint32_t>(cellUnits.size()));
+
+        cellPeers.clear();
+        for (std::uint16_t unit : unitsOfCell[cell])
+            for (std::uint16_t peer : units[unit])
+                if (peer != cell) cellPeers.push_back(peer);
+        std::sort(cellPeers.begin(), cellPeers.end());
+        cellPeers.erase(std::unique(cellPeers.begin(), cellPeers.end()), cellPeers.end());
+        peerList.insert(peerList.end(), cellPeers.begin(), cellPeers.end());
+        peerStart.push_back(static_cast<std::uint32_t>(peerList.size()));
+    }
+}
+
+bool parseMultiGrid(std::string_view text, const MultiGrid& layout, std::vector<Board>& grids) {
+    grids.assign(layout.gridCount(), Board{});
+    for (Board& grid : grids) {
+        std::size_t begin = text.find_first_not_of(" \t\r\n");
+        if (begin == std::string_view::npos) return false;
+        std::size_t end = std::min(text.find_first_of(" \t\r\n", begin), text.size());
+        if (!parseBoard(text.substr(begin, end - begin), grid)) return false;
+        text.remove_prefix(end);
+    }
+    return text.find_first_not_of(" \t\r\n") == std::string_view::npos;
+}
+
+std::string formatMultiGrid(std::span<const Board> grids) {
+    std::string text;
+    for (const Board& grid : grids) {
+        if (!text.empty()) text += ' ';
+        text += formatBoard(grid);
+    }
+    return text;
+}
+
+MultiGridSolver::MultiGridSolver(const MultiGrid& layout) : layout(&layout) {}
+
+// Sizes the search levels for the layout and places the givens on the first
+bool MultiGridSolver::load(std::span<const Board> givens) {
+    if (static_cast<int>(givens.size()) != layout->gridCount()) return false;
+    cellCount = layout->cellCount();
+    // At most one level per cell, plus the givens
+    std::size_t levelCells = static_cast<std::size_t>(cellCount + 1) * cellCount;
+    if (candidates.size() != levelCells) {
+        candidates.assign(levelCells, 0);
+        values.assign(levelCells, 0);
+    }
+    singles.clear();
+
+    std::uint16_t* cand = candidatesAt(0);
+    std::uint8_t* value = valuesAt(0);
+    std::fill(cand, cand + cellCount, kAllDigits);
+    std::fill(value, value + cellCount, 0);
+    for (int grid = 0; grid < layout->gridCount(); ++grid) {
+        for (int i = 0; i < 81; ++i) {
+            int num = givens[grid][i];
+            if (num == 0) continue;
+            int cell = layout->cellOf(grid, i);
+            if (num > 9) return false;
+            if (value[cell] == num) continue;
+            if (!assign(0, cell, num)) return false;
+        }
+    }
+    return true;
+}
+
+bool MultiGridSolver::assign(int depth, int cell, int num) {
+    std::uint16_t* cand = candidatesAt(depth);
+    std::uint8_t* value = valuesAt(depth);
+    std::uint16_t bit = digitBit(num);
+    if (value[cell] != 0 || !(cand[cell] & bit)) return false;
+    value[cell] = static_cast<std::uint8_t>(num);
+    cand[cell] = bit;
+    for (std::uint16_t peer : layout->peers(cell)) {
+        if (!(cand[peer] & bit)) continue;
+        if (value[peer] != 0) return false;
+        cand[peer] &= ~bit;
+        stats.eliminations++;
+        if (cand[peer] == 0) return false;
+        if (std::has_single_bit(cand[peer])) singles.push_back(peer);
+    }
+    return true;
+}
+
+// Naked singles as they appear, then hidden singles in every unit, then
+// locked candidates, until nothing changes
+bool MultiGridSolver::propagate(int depth) {
+    std::uint16_t* cand = candidatesAt(depth);
+    std::uint8_t* value = valuesAt(depth);
+    bool changed = true;
+    while (changed) {
+        while (!singles.empty()) {
+            int cell = singles.back();
+            singles.pop_back();
+            if (value[cell] == 0 && !assign(depth, cell, std::countr_zero(cand[cell]) + 1)) return false;
+        }
+
+        changed = false;
+        for (int index = 0; index < layout->unitCount(); ++index) {
+            const MultiGrid::Unit& unit = layout->cells(index);
+            std::uint16_t once = 0, twice = 0, placed = 0;
+            for (std::uint16_t cell : unit) {
+                if (value[cell] != 0) {
+                    placed |= cand[cell];
+                } else {
+                    twice |= once & cand[cell];
+                    once |= cand[cell];
+                }
+            }
+            if ((once | placed) != kAllDigits) return false;
+
+            for (std::uint16_t hidden = once & ~twice & ~placed; hidden; hidden &= hidden - 1) {
+                std::uint16_t bit = hidden & -hidden;
+                for (std::uint16_t cell : unit) {
+                    if (value[cell] != 0 || !(cand[cell] & bit)) continue;
+                    if (!assign(depth, cell, std::countr_zero(bit) + 1)) return false;
+                    changed = true;
+                    break;
+                }
+            }
+            if (changed && !singles.empty()) break;
+        }
+        if (!changed && !lockCandidates(depth, changed)) return false;
+    }
+    return true;
+}
+
+// Locked candidates: when a digit's places in one unit all lie in another
+// unit as well (a box and a line, or the boxes two grids share), the digit
+// leaves the rest of that other unit
+bool MultiGridSolver::lockCandidates(int depth, bool& changed) {
+    std::uint16_t* cand = candidatesAt(depth);
+    const std::uint8_t* value = valuesAt(depth);
+    for (int index = 0; index < layout->unitCount(); ++index) {
+        const MultiGrid::Unit& unit = layout->cells(index);
+        std::uint16_t once = 0, twice = 0, thrice = 0, more = 0;
+        for (std::uint16_t cell : unit) {
+            if (value[cell] != 0) continue;
+            more |= thrice & cand[cell];
+            thrice |= twice & cand[cell];
+            twice |= once & cand[cell];
+            once |= cand[cell];
+        }
+
+        for (std::uint16_t locked = twice & ~more; locked; locked &= locked - 1) {
+            std::uint16_t bit = locked & -locked;
+            std::array<std::uint16_t, 3> places;
+            int count = 0;
+            for (std::uint16_t cell : unit) {
+                if (value[cell] == 0 && (cand[cell] & bit)) places[count++] = cell;
+            }
+
+            for (std::uint16_t other : layout->unitsOf(places[0])) {
+                if (other == index) continue;
+                bool holdsAll = true;
+                for (int i = 1; i < count && holdsAll; ++i) {
+                    auto units = layout->unitsOf(places[i]);
+                    holdsAll = std::find(units.begin(), units.end(), other) != units.end();
+                }
+                if (!holdsAll) continue;
+
+                for (std::uint16_t cell : layout->cells(other)) {
+                    if (value[cell] != 0 || !(cand[cell] & bit) ||
+                        std::find(places.begin(), places.begin() + count, cell) != places.begin() + count)
+                        continue;
+                    cand[cell] &= ~bit;
+                    stats.eliminations++;
+                    if (cand[cell] == 0) return false;
+                    if (std::has_single_bit(cand[cell])) singles.push_back(cell);
+                    changed = true;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool MultiGridSolver::search(int depth) {
+    // The clock is read every few hundred nodes
+    constexpr std::uint64_t kClockInterval = 256;
+
+    const std::uint16_t* cand = candidatesAt(depth);
+    const std::uint8_t* value = valuesAt(depth);
+    if (depth > stats.maxDepth) stats.maxDepth = depth;
+
+    // Branch on the open cell with the fewest candidates, and among those
+    // on the one with the most open peers, whose choice propagates furthest
+    int best = -1, bestCount = 10, bestOpen = -1;
+    for (int cell = 0; cell < cellCount; ++cell) {
+        if (value[cell] != 0) continue;
+        int count = std::popcount(static_cast<unsigned>(cand[cell]));
+        if (count > bestCount) continue;
+        int open = 0;
+        for (std::uint16_t peer : layout->peers(cell)) open += value[peer] == 0;
+        if (count < bestCount || open > bestOpen) {
+            best = cell;
+            bestCount = count;
+            bestOpen = open;
+        }
+    }
+    if (best < 0) {
+        solvedDepth = depth;
+        return true;
+    }
+
+    for (std::uint16_t options = cand[best]; options; options &= options - 1) {
+        if (stats.nodes >= nodeLimit ||
+            (stats.nodes % kClockInterval == 0 &&
+             (SolveLimits::Clock::now() >= deadline || stop.stop_requested()))) {
+            timedOut = true;
+            return false;
+        }
+        stats.nodes++;
+        std::copy(cand, cand + cellCount, candidatesAt(depth + 1));
+        std::copy(value, value + cellCount, valuesAt(depth + 1));
+        singles.clear();
+        if (assign(depth + 1, best, std::countr_zero(options) + 1) && propagate(depth + 1) && search(depth + 1))
+            return true;
+        if (timedOut) return false;
+        stats.backtracks++;
+    }
+    return false;
+}
+
+SolveStatus MultiGridSolver::solve(std::span<const Board> givens, std::span<Board> solution,
+                                   const SolveLimits& limits) {
+    stats = SolveStats();
+    timedOut = false;
+    deadline = limits.deadlineFrom(SolveLimits::Clock::now());
+    nodeLimit = limits.maxNodes > 0 ? limits.maxNodes : UINT64_MAX;
+    stop = limits.stop;
+    if (static_cast<int>(solution.size()) != layout->gridCount()) return SolveStatus::Unsolvable;
+
+    PhaseTimer setupTimer;
+    bool consistent = load(givens) && propagate(0);
+    stats.setupNs = setupTimer.elapsedNs();
+    if (!consistent) return SolveStatus::Unsolvable;
+
+    PhaseTimer searchTimer;
+    bool found = search(0);
+    stats.searchNs = searchTimer.elapsedNs();
+    if (timedOut) return stop.stop_requested() ? SolveStatus::Cancelled : SolveStatus::TimedOut;
+    if (!found) return SolveStatus::Unsolvable;
+
+    const std::uint8_t* value = valuesAt(solvedDepth);
+    for (int grid = 0; grid < layout->gridCount(); ++grid)
+        for (int i = 0; i < 81; ++i) solution[grid][i] = value[layout->cellOf(grid, i)];
+    return SolveStatus::Solved;
+}
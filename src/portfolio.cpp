@@ -0,0 +1,177 @@
+#include "portfolio.h"
+#include <algorithm>
+#include <atomic>
+
+namespace {
+
+std::array<std::atomic<std::uint64_t>, kPortfolioEngineCount> wins{};
+
+// Cell index of the same square after a half turn
+inline int rotated(int cell) {
+    return 80 - cell;
+}
+
+// Whether every unit turned 180 degrees is again a unit of the table, as
+// for the classic rules, the diagonals and the Windoku windows
+bool turnsWithBoard(const UnitTable& units) {
+    std::vector<UnitTable::Unit> sorted;
+    for (int unit = 0; unit < units.size(); ++unit) {
+        UnitTable::Unit cells = units.cells(unit);
+        std::sort(cells.begin(), cells.end());
+        sorted.push_back(cells);
+    }
+    std::sort(sorted.begin(), sorted.end());
+    for (int unit = 0; unit < units.size(); ++unit) {
+        UnitTable::Unit cells = units.cells(unit);
+        for (auto& cell : cells) cell = static_cast<std::uint8_t>(rotated(cell));
+        std::sort(cells.begin(), cells.end());
+        if (!std::binary_search(sorted.begin(), sorted.end(), cells)) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+const char* portfolioEngineName(PortfolioEngine engine) {
+    switch (engine) {
+    case PortfolioEngine::Backtracking: return "backtracking";
+    case PortfolioEngine::Rotated: return "rotated";
+    case PortfolioEngine::Mrv: return "mrv";
+    case PortfolioEngine::Cdcl: return "cdcl";
+    }
+    return "unknown";
+}
+
+bool portfolioEngineFromName(std::string_view name, PortfolioEngine& engine) {
+    for (PortfolioEngine candidate : kAllPortfolioEngines) {
+        if (name == portfolioEngineName(candidate)) {
+            engine = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::array<std::uint64_t, kPortfolioEngineCount> PortfolioSolver::totalWins() {
+    std::array<std::uint64_t, kPortfolioEngineCount> counts;
+    for (int i = 0; i < kPortfolioEngineCount; ++i) counts[i] = wins[i].load(std::memory_order_relaxed);
+    return counts;
+}
+
+PortfolioSolver::PortfolioSolver(std::span<const PortfolioEngine> engines) {
+    for (PortfolioEngine engine : engines) {
+        auto worker = std::make_unique<Worker>();
+        worker->engine = engine;
+        workers.push_back(std::move(worker));
+    }
+    // Started once every worker exists, since they all share the round
+    for (auto& worker : workers) {
+        worker->thread = std::jthread([this, &worker = *worker](std::stop_token shutdown) { run(worker, shutdown); });
+    }
+}
+
+PortfolioSolver::~PortfolioSolver() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        roundStop.request_stop();
+    }
+    // Each jthread is asked to stop and joined as the workers go
+    workers.clear();
+}
+
+void PortfolioSolver::setUnits(const UnitTable& table) {
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [&] { return running == 0; });
+    units = &table;
+    bool turns = turnsWithBoard(table);
+    for (auto& worker : workers) {
+        worker->backtracking.setUnits(table);
+        worker->mrv.setUnits(table);
+        worker->cdcl.setUnits(table);
+        worker->enabled = worker->engine != PortfolioEngine::Rotated || turns;
+    }
+}
+
+void PortfolioSolver::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [&] { return running == 0; });
+}
+
+SolveStatus PortfolioSolver::solve(const Board& puzzle, Board& solution, const SolveLimits& solveLimits) {
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [&] { return running == 0; });
+
+    board = puzzle;
+    limits = solveLimits;
+    roundStop = std::stop_source();
+    limits.stop = roundStop.get_token();
+    running = workers.size();
+    decided = false;
+    round++;
+    started.notify_all();
+
+    // The caller's own stop request cancels every engine
+    std::stop_callback forward(solveLimits.stop, [source = roundStop]() mutable { source.request_stop(); });
+    finished.wait(lock, [&] { return decided || running == 0; });
+    if (!decided) {
+        stats = SolveStats();
+        return solveLimits.stop.stop_requested() ? SolveStatus::Cancelled : SolveStatus::TimedOut;
+    }
+    if (status == SolveStatus::Solved) solution = result;
+    return status;
+}
+
+void PortfolioSolver::run(Worker& worker, std::stop_token shutdown) {
+    std::uint64_t seen = 0;
+    while (true) {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!started.wait(lock, shutdown, [&] { return round != seen; })) return;
+        seen = round;
+        Board puzzle = board;
+        SolveLimits roundLimits = limits;
+        lock.unlock();
+
+        Board solution{};
+        SolveStatus outcome = worker.enabled ? runEngine(worker, puzzle, solution, roundLimits)
+                                             : SolveStatus::Cancelled;
+
+        lock.lock();
+        if (!decided && (outcome == SolveStatus::Solved || outcome == SolveStatus::Unsolvable)) {
+            decided = true;
+            status = outcome;
+            result = solution;
+            lastWinner = worker.engine;
+            switch (worker.engine) {
+            case PortfolioEngine::Backtracking:
+            case PortfolioEngine::Rotated: stats = worker.backtracking.getStats(); break;
+            case PortfolioEngine::Mrv: stats = worker.mrv.getStats(); break;
+            case PortfolioEngine::Cdcl: stats = worker.cdcl.getStats(); break;
+            }
+            wins[static_cast<int>(worker.engine)].fetch_add(1, std::memory_order_relaxed);
+            roundStop.request_stop();
+        }
+        running--;
+        finished.notify_all();
+    }
+}
+
+SolveStatus PortfolioSolver::runEngine(Worker& worker, const Board& puzzle, Board& solution,
+                                       const SolveLimits& roundLimits) {
+    switch (worker.engine) {
+    case PortfolioEngine::Backtracking:
+        solution = puzzle;
+        return worker.backtracking.solve(solution, worker.workspace, roundLimits);
+    case PortfolioEngine::Rotated: {
+        Board turned;
+        for (int cell = 0; cell < 81; ++cell) turned[rotated(cell)] = puzzle[cell];
+        SolveStatus outcome = worker.backtracking.solve(turned, worker.workspace, roundLimits);
+        for (int cell = 0; cell < 81; ++cell) solution[rotated(cell)] = turned[cell];
+        return outcome;
+    }
+    case PortfolioEngine::Mrv:
+        return worker.mrv.solve(puzzle, solution, roundLimits);
+    case PortfolioEngine::Cdcl:
+        return worker.cdcl.solve(puzzle, solution, roundLimits);
+    }
+    return SolveStatus::Cancelled;
+}
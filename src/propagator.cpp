@@ -0,0 +1,389 @@
+#include "propagator.h"
+#include <algorithm>
+#include <bit>
+#include <charconv>
+
+namespace {
+
+constexpr std::uint16_t kAllDigits = 0x1FF;
+
+inline std::uint16_t digitBit(int num) {
+    return static_cast<std::uint16_t>(1u << (num - 1));
+}
+
+inline int lowestDigit(std::uint16_t mask) {
+    return std::countr_zero(mask) + 1;
+}
+
+inline int highestDigit(std::uint16_t mask) {
+    return std::bit_width(mask);
+}
+
+// Digits low to high inclusive; empty when low > high
+inline std::uint16_t digitRange(int low, int high) {
+    low = std::max(low, 1);
+    high = std::min(high, 9);
+    if (low > high) return 0;
+    return static_cast<std::uint16_t>(((1u << high) - 1) & ~((1u << (low - 1)) - 1));
+}
+
+// Cells (row + dr, col + dc) for each offset that stay on the board
+std::vector<std::uint8_t> offsetCells(int cell, std::initializer_list<std::array<int, 2>> offsets) {
+    std::vector<std::uint8_t> cells;
+    int row = cell / 9, col = cell % 9;
+    for (const auto& offset : offsets) {
+        int r = row + offset[0], c = col + offset[1];
+        if (r >= 0 && r < 9 && c >= 0 && c < 9) cells.push_back(static_cast<std::uint8_t>(r * 9 + c));
+    }
+    return cells;
+}
+
+// Comma-separated cell indices 0-80
+bool parseCells(std::string_view text, std::vector<std::uint8_t>& cells) {
+    cells.clear();
+    while (!text.empty()) {
+        std::size_t comma = text.find(',');
+        std::string_view field = text.substr(0, comma);
+        int cell = -1;
+        auto result = std::from_chars(field.data(), field.data() + field.size(), cell);
+        if (result.ec != std::errc() || result.ptr != field.data() + field.size() || cell < 0 || cell >= 81)
+            return false;
+        cells.push_back(static_cast<std::uint8_t>(cell));
+        if (comma == std::string_view::npos) break;
+        text.remove_prefix(comma + 1);
+    }
+    return !cells.empty();
+}
+
+} // namespace
+
+int CandidateGrid::fixedDigit(int cell) const {
+    return std::has_single_bit(masks[cell]) ? lowestDigit(masks[cell]) : 0;
+}
+
+bool CandidateGrid::restrict(int cell, std::uint16_t mask) {
+    std::uint16_t narrowed = masks[cell] & mask;
+    if (narrowed == masks[cell]) return true;
+    log->eliminations += std::popcount(static_cast<unsigned>(masks[cell] & ~narrowed));
+    masks[cell] = narrowed;
+    log->cells.push_back(static_cast<std::uint8_t>(cell));
+    return narrowed != 0;
+}
+
+DistinctNeighboursPropagator::DistinctNeighboursPropagator(std::uint8_t cell, std::vector<std::uint8_t> neighbours)
+    : cell(cell), neighbours(std::move(neighbours)) {}
+
+std::vector<std::uint8_t> DistinctNeighboursPropagator::watchedCells() const {
+    return {cell};
+}
+
+bool DistinctNeighboursPropagator::propagate(CandidateGrid& grid) const {
+    int num = grid.fixedDigit(cell);
+    if (num == 0) return true;
+    for (std::uint8_t neighbour : neighbours) {
+        if (!grid.remove(neighbour, digitBit(num))) return false;
+    }
+    return true;
+}
+
+NonConsecutivePropagator::NonConsecutivePropagator(std::uint8_t cell, std::vector<std::uint8_t> neighbours)
+    : cell(cell), neighbours(std::move(neighbours)) {}
+
+std::vector<std::uint8_t> NonConsecutivePropagator::watchedCells() const {
+    return {cell};
+}
+
+bool NonConsecutivePropagator::propagate(CandidateGrid& grid) const {
+    // A neighbour keeps the digits not next to at least one of the cell's
+    std::uint16_t allowed = 0;
+    for (std::uint16_t mask = grid.candidates(cell); mask; mask &= mask - 1) {
+        int num = lowestDigit(mask);
+        allowed |= kAllDigits & ~(digitRange(num - 1, num - 1) | digitRange(num + 1, num + 1));
+        if (allowed == kAllDigits) return true;
+    }
+    for (std::uint8_t neighbour : neighbours) {
+        if (!grid.restrict(neighbour, allowed)) return false;
+    }
+    return true;
+}
+
+ThermometerPropagator::ThermometerPropagator(std::vector<std::uint8_t> cells) : cells(std::move(cells)) {}
+
+std::vector<std::uint8_t> ThermometerPropagator::watchedCells() const {
+    return cells;
+}
+
+bool ThermometerPropagator::propagate(CandidateGrid& grid) const {
+    // Each cell lies above the lowest digit before it and below the highest
+    // after it
+    int low = 0;
+    for (std::uint8_t cell : cells) {
+        if (!grid.restrict(cell, digitRange(low + 1, 9))) return false;
+        low = lowestDigit(grid.candidates(cell));
+    }
+    int high = 10;
+    for (auto it = cells.rbegin(); it != cells.rend(); ++it) {
+        if (!grid.restrict(*it, digitRange(1, high - 1))) return false;
+        high = highestDigit(grid.candidates(*it));
+    }
+    return true;
+}
+
+ArrowPropagator::ArrowPropagator(std::uint8_t circle, std::vector<std::uint8_t> arrow)
+    : circle(circle), arrow(std::move(arrow)) {}
+
+std::vector<std::uint8_t> ArrowPropagator::watchedCells() const {
+    std::vector<std::uint8_t> cells = arrow;
+    cells.push_back(circle);
+    return cells;
+}
+
+bool ArrowPropagator::propagate(CandidateGrid& grid) const {
+    // Bounds: the circle lies between the smallest and largest sums the
+    // arrow can make, and each arrow cell between what the circle and the
+    // other cells leave
+    int sumLow = 0, sumHigh = 0;
+    for (std::uint8_t cell : arrow) {
+        sumLow += lowestDigit(grid.candidates(cell));
+        sumHigh += highestDigit(grid.candidates(cell));
+    }
+    if (!grid.restrict(circle, digitRange(sumLow, sumHigh))) return false;
+
+    int circleLow = lowestDigit(grid.candidates(circle));
+    int circleHigh = highestDigit(grid.candidates(circle));
+    for (std::uint8_t cell : arrow) {
+        std::uint16_t mask = grid.candidates(cell);
+        int othersLow = sumLow - lowestDigit(mask);
+        int othersHigh = sumHigh - highestDigit(mask);
+        if (!grid.restrict(cell, digitRange(circleLow - othersHigh, circleHigh - othersLow))) return false;
+    }
+    return true;
+}
+
+void ConstraintSolver::addPropagator(std::unique_ptr<Propagator> propagator) {
+    std::uint16_t index = static_cast<std::uint16_t>(propagators.size());
+    for (std::uint8_t cell : propagator->watchedCells()) {
+        if (cell < 81) watchers[cell].push_back(index);
+    }
+    propagators.push_back(std::move(propagator));
+}
+
+void ConstraintSolver::clearPropagators() {
+    propagators.clear();
+    for (auto& list : watchers) list.clear();
+}
+
+void ConstraintSolver::wake(int cell) {
+    for (std::uint16_t index : watchers[cell]) {
+        if (queued[index]) continue;
+        queued[index] = 1;
+        queue.push_back(index);
+    }
+}
+
+// Until nothing changes: place new singles and wake the propagators of
+// every changed cell, run the queued propagators in order, then look for
+// hidden singles
+bool ConstraintSolver::propagate(State& state) {
+    CandidateGrid& grid = state.grid;
+    std::size_t head = 0;
+    for (;;) {
+        for (std::size_t i = 0; i < log.cells.size(); ++i) {
+            int cell = log.cells[i];
+            wake(cell);
+            int num = grid.fixedDigit(cell);
+            if (num == 0 || state.placed[cell] != 0) continue;
+            state.placed[cell] = static_cast<std::uint8_t>(num);
+            for (std::uint8_t peer : units->peers(cell)) {
+                if (!grid.remove(peer, digitBit(num))) return false;
+            }
+        }
+        log.cells.clear();
+
+        if (head < queue.size()) {
+            std::uint16_t index = queue[head++];
+            queued[index] = 0;
+            if (!propagators[index]->propagate(grid)) return false;
+            continue;
+        }
+        queue.clear();
+        head = 0;
+
+        for (int index = 0; index < units->size(); ++index) {
+            const UnitTable::Unit& unit = units->cells(index);
+            std::uint16_t once = 0, twice = 0, placed = 0;
+            for (std::uint8_t cell : unit) {
+                if (state.placed[cell] != 0) {
+                    placed |= digitBit(state.placed[cell]);
+                } else {
+                    twice |= once & grid.candidates(cell);
+                    once |= grid.candidates(cell);
+                }
+            }
+            if ((once | placed) != kAllDigits) return false;
+
+            for (std::uint16_t singles = once & ~twice & ~placed; singles; singles &= singles - 1) {
+                std::uint16_t bit = singles & -singles;
+                for (std::uint8_t cell : unit) {
+                    if (state.placed[cell] == 0 && (grid.candidates(cell) & bit)) {
+                        if (!grid.restrict(cell, bit)) return false;
+                        break;
+                    }
+                }
+            }
+        }
+        if (log.cells.empty()) return true;
+    }
+}
+
+bool ConstraintSolver::search(int depth) {
+    // The clock is read every few hundred nodes
+    constexpr std::uint64_t kClockInterval = 256;
+
+    const State& state = states[depth];
+    if (depth > stats.maxDepth) stats.maxDepth = depth;
+
+    // Branch on the open cell with the fewest candidates
+    int best = -1, bestCount = 10;
+    for (int cell = 0; cell < 81 && bestCount > 2; ++cell) {
+        if (state.placed[cell] != 0) continue;
+        int count = std::popcount(static_cast<unsigned>(state.grid.candidates(cell)));
+        if (count < bestCount) {
+            best = cell;
+            bestCount = count;
+        }
+    }
+    if (best < 0) {
+        solved = state.placed;
+        return true;
+    }
+
+    for (std::uint16_t candidates = state.grid.candidates(best); candidates; candidates &= candidates - 1) {
+        if (stats.nodes >= nodeLimit ||
+            (stats.nodes % kClockInterval == 0 &&
+             (SolveLimits::Clock::now() >= deadline || stop.stop_requested()))) {
+            timedOut = true;
+            return false;
+        }
+        stats.nodes++;
+        State& next = states[depth + 1];
+        next = state;
+        // Whatever the failed branch left pending is dropped
+        log.cells.clear();
+        for (std::uint16_t index : queue) queued[index] = 0;
+        queue.clear();
+        if (next.grid.restrict(best, candidates & -candidates) && propagate(next) && search(depth + 1))
+            return true;
+        if (timedOut) return false;
+        stats.backtracks++;
+    }
+    return false;
+}
+
+SolveStatus ConstraintSolver::solve(const Board& board, Board& solution, const SolveLimits& limits) {
+    stats = SolveStats();
+    timedOut = false;
+    deadline = limits.deadlineFrom(SolveLimits::Clock::now());
+    nodeLimit = limits.maxNodes > 0 ? limits.maxNodes : UINT64_MAX;
+    stop = limits.stop;
+
+    PhaseTimer setupTimer;
+    if (states.empty()) states.resize(82);
+    log.cells.clear();
+    log.eliminations = 0;
+    queue.clear();
+    queued.assign(propagators.size(), 0);
+
+    State& root = states[0];
+    root.grid.masks.fill(kAllDigits);
+    root.grid.log = &log;
+    root.placed.fill(0);
+    bool consistent = true;
+    for (int cell = 0; cell < 81 && consistent; ++cell) {
+        int num = board[cell];
+        if (num > 9) consistent = false;
+        else if (num != 0) consistent = root.grid.restrict(cell, digitBit(num));
+    }
+    // Every rule runs once before any cell wakes it
+    for (std::size_t index = 0; index < propagators.size(); ++index) {
+        queued[index] = 1;
+        queue.push_back(static_cast<std::uint16_t>(index));
+    }
+    consistent = consistent && propagate(root);
+    stats.setupNs = setupTimer.elapsedNs();
+
+    bool found = false;
+    if (consistent) {
+        PhaseTimer searchTimer;
+        found = search(0);
+        stats.searchNs = searchTimer.elapsedNs();
+    }
+    stats.eliminations = log.eliminations;
+    if (timedOut) return stop.stop_requested() ? SolveStatus::Cancelled : SolveStatus::TimedOut;
+    if (!found) return SolveStatus::Unsolvable;
+    solution = solved;
+    return SolveStatus::Solved;
+}
+
+bool parseVariant(std::string_view text, VariantPuzzle& puzzle) {
+    puzzle = VariantPuzzle();
+    bool first = true;
+    while (true) {
+        std::size_t begin = text.find_first_not_of(" \t\r\n");
+        if (begin == std::string_view::npos) break;
+        std::size_t end = std::min(text.find_first_of(" \t\r\n", begin), text.size());
+        std::string_view token = text.substr(begin, end - begin);
+        text.remove_prefix(end);
+
+        if (first) {
+            if (!parseBoard(token, puzzle.givens)) return false;
+            first = false;
+        } else if (token == "anti-knight") {
+            puzzle.antiKnight = true;
+        } else if (token == "anti-king") {
+            puzzle.antiKing = true;
+        } else if (token == "non-consecutive") {
+            puzzle.nonConsecutive = true;
+        } else if (token.starts_with("thermo=")) {
+            std::vector<std::uint8_t> cells;
+            if (!parseCells(token.substr(7), cells)) return false;
+            puzzle.thermometers.push_back(std::move(cells));
+        } else if (token.starts_with("arrow=")) {
+            token.remove_prefix(6);
+            std::size_t colon = token.find(':');
+            std::vector<std::uint8_t> circle;
+            VariantPuzzle::Arrow arrow;
+            if (colon == std::string_view::npos || !parseCells(token.substr(0, colon), circle) ||
+                circle.size() != 1 || !parseCells(token.substr(colon + 1), arrow.cells))
+                return false;
+            arrow.circle = circle[0];
+            puzzle.arrows.push_back(std::move(arrow));
+        } else {
+            return false;
+        }
+    }
+    return !first;
+}
+
+void addPropagators(const VariantPuzzle& puzzle, ConstraintSolver& solver) {
+    solver.clearPropagators();
+    for (int cell = 0; cell < 81; ++cell) {
+        auto index = static_cast<std::uint8_t>(cell);
+        if (puzzle.antiKnight) {
+            solver.addPropagator(std::make_unique<DistinctNeighboursPropagator>(
+                index, offsetCells(cell, {{-2, -1}, {-2, 1}, {-1, -2}, {-1, 2}, {1, -2}, {1, 2}, {2, -1}, {2, 1}})));
+        }
+        if (puzzle.antiKing) {
+            solver.addPropagator(std::make_unique<DistinctNeighboursPropagator>(
+                index, offsetCells(cell, {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}})));
+        }
+        if (puzzle.nonConsecutive) {
+            solver.addPropagator(std::make_unique<NonConsecutivePropagator>(
+                index, offsetCells(cell, {{-1, 0}, {0, -1}, {0, 1}, {1, 0}})));
+        }
+    }
+    for (const auto& cells : puzzle.thermometers)
+        solver.addPropagator(std::make_unique<ThermometerPropagator>(cells));
+    for (const auto& arrow : puzzle.arrows)
+        solver.addPropagator(std::make_unique<ArrowPropagator>(arrow.circle, arrow.cells));
+}
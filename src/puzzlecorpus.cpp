@@ -0,0 +1,134 @@
+#include "puzzlecorpus.h"
+#include <algorithm>
+#include <array>
+#include <numeric>
+#include <random>
+
+const std::map<std::string, std::vector<std::string>>& gamePuzzles() {
+    static const std::map<std::string, std::vector<std::string>> puzzles = {
+        {"Easy", {
+            "530070000600195000098000060800060003400803001700020006060000280000419005000080079",
+            "170000006000061000004000700060004003080070050500800070007000400000150000200000098",
+            "200080300060070084030500209000105408000000000402706000301007040720040060004010003",
+            "000000657702400100350006000200000740000052000064000008000100503007009204928000000",
+            "020000000000600003074080000000003002080040010600500000000010780500009000000000040",
+            "100007090030020008009600500005300900010080002600004000300000010040000007007000300",
+            "000000012000000003002300400001800005060070800000009000008500000900040500470000090",
+            "000200000000060700700000009800000040010000050040000003200000004003010000000008000",
+            "000000657702400100350006000200000740000052000064000008000100503007009204928000000"
+        }},
+        {"Medium", {
+            "009000400200009000087002090030070502000000000704050060070200140000800007006000800",
+            "020000000000600003074080000000003002080040010600500000000010780500009000000000040",
+            "000000907000420180000705026100904000050000040000507009920108000034059000507000000",
+            "020000000000700003074080000000003002080040010600500000000010780500009000000000040",
+            "300000000970010000600583000200000900040020000000600008006040000090000307000001402",
+            "000090200004000000100308000052007006000000000400100987000605001000000600008070000",
+            "000000000900000084062300050000600200070102030003007000020009140690000007000000000",
+            "000000000079050180800000007007306800450708096003402700700000009016030420000000000",
+            "000000000001900500960001070000700004000030000300005000080200049002008700000000000"
+        }},
+        {"Hard", {
+            "400000805030000000000700000020000060000080400000010000000603070500200000104000000",
+            "520006000000000701300000000000400800600000050000000000041800000000030020008700000",
+            "600000803040700000000000000000504070300200000106000000020000050000080600000010000",
+            "000000000079050180800000007007306800450708096003402700700000009016030420000000000",
+            "000000000001900500960001070000700004000030000300005000080200049002008700000000000",
+            "000000052080000000000700340000900000000080000070000600004600800000000000000000000",
+            "000075400000000008080190000300001060000000034000068170204000603900000401530000000",
+            "300000000000000000000000000000000000000000000000000000000000000000000000000000000",
+            "000000000000000000000000000000000000000000000000000000000000000000000000000000000"
+        }},
+        {"Expert", {
+            "800000000003600000070090200050007000000045700000100030001000068008500010090000400",
+            "000000085000210009960080100500800016000000000890006007009070052300054000480000000",
+            "000200000000060700700000009800000040010000050040000003200000004003010000000008000",
+            "000070100000800005900200000000400800100000002005003000000005009700006000002010000",
+            "000000801700200000000600000000500070010000050060003000000009000000001006803000000",
+            "000000000900000084062300050000600200070102030003007000020009140690000007000000000",
+            "000000000079050180800000007007306800450708096003402700700000009016030420000000000",
+            "000000000001900500960001070000700004000030000300005000080200049002008700000000000",
+            "000000052080000000000700340000900000000080000070000600004600800000000000000000000"
+        }}
+    };
+    return puzzles;
+}
+
+const std::vector<std::string>& hardestPuzzles() {
+    static const std::vector<std::string> puzzles = {
+        "100007090030020008009600500005300900010080002600004000300000010040000007007000300", // AI Escargot
+        "800000000003600000070090200050007000000045700000100030001000068008500010090000400", // Inkala 2010
+        "000000012000000003002300400001800005060070800000009000008500000900040500470000090", // Platinum Blonde
+        "000000039000001005003050800008090006070002000100400000009080050020000600400700000", // Golden Nugget
+        "100000002090400050006000700050903000000070000000850040700000600030009080002000001", // Easter Monster
+        "000000000000003085001020000000507000004000100090000000500000073002010000000040009"  // Anti brute force
+    };
+    return puzzles;
+}
+
+const std::vector<std::string>& adversarialPuzzles() {
+    // The hardest puzzles with one wrong clue added that clashes with no
+    // other, so only exhausting the search proves them unsolvable
+    static const std::vector<std::string> puzzles = [] {
+        std::vector<std::string> list = hardestPuzzles();
+        list.insert(list.end(), {
+            "100007090030020008009600500005300900010080002600004000300000010040000007007000305",
+            "800000000003600000070090200050007000000045700000100030001000068008500010090000403",
+            "000000039000001005003050800008090006070002000100400000009080050020000600400700001",
+            "100000002090400050006000700050903000000070000000850040700000600030009080002000031"
+        });
+        return list;
+    }();
+    return puzzles;
+}
+
+namespace {
+
+// Random permutation of {0,1,2} applied to three groups of three
+std::array<int, 9> shuffledGroups(std::mt19937& rng) {
+    std::array<int, 3> outer = {0, 1, 2};
+    std::shuffle(outer.begin(), outer.end(), rng);
+    std::array<int, 9> order;
+    for (int group = 0; group < 3; ++group) {
+        std::array<int, 3> inner = {0, 1, 2};
+        std::shuffle(inner.begin(), inner.end(), rng);
+        for (int k = 0; k < 3; ++k)
+            order[group * 3 + k] = outer[group] * 3 + inner[k];
+    }
+    return order;
+}
+
+std::string shufflePuzzle(const std::string& puzzle, std::mt19937& rng) {
+    std::array<int, 9> rows = shuffledGroups(rng);
+    std::array<int, 9> cols = shuffledGroups(rng);
+    std::array<char, 10> digits;
+    std::iota(digits.begin(), digits.end(), '0');
+    std::shuffle(digits.begin() + 1, digits.end(), rng);
+    bool transpose = rng() & 1;
+
+    std::string result(81, '0');
+    for (int r = 0; r < 9; ++r) {
+        for (int c = 0; c < 9; ++c) {
+            int sourceRow = transpose ? cols[c] : rows[r];
+            int sourceCol = transpose ? rows[r] : cols[c];
+            result[r * 9 + c] = digits[puzzle[sourceRow * 9 + sourceCol] - '0'];
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+std::vector<std::string> generatedPuzzles(std::size_t count, std::uint32_t seed) {
+    std::vector<std::string> sources;
+    for (const auto& entry : gamePuzzles())
+        sources.insert(sources.end(), entry.second.begin(), entry.second.end());
+    sources.insert(sources.end(), hardestPuzzles().begin(), hardestPuzzles().end());
+
+    std::mt19937 rng(seed);
+    std::vector<std::string> puzzles;
+    puzzles.reserve(count);
+    for (std::size_t i = 0; i < count; ++i)
+        puzzles.push_back(shufflePuzzle(sources[i % sources.size()], rng));
+    return puzzles;
+}
@@ -0,0 +1,336 @@
+#include "puzzleio.h"
+#include "mappedfile.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+std::string_view extensionOf(std::string_view path) {
+    std::size_t dot = path.find_last_of('.');
+    std::size_t slash = path.find_last_of("/\\");
+    if (dot == std::string_view::npos || (slash != std::string_view::npos && dot < slash)) return {};
+    return path.substr(dot + 1);
+}
+
+bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        char x = a[i], y = b[i];
+        if (x >= 'A' && x <= 'Z') x = static_cast<char>(x - 'A' + 'a');
+        if (y >= 'A' && y <= 'Z') y = static_cast<char>(y - 'A' + 'a');
+        if (x != y) return false;
+    }
+    return true;
+}
+
+std::string_view trimField(std::string_view field) {
+    while (!field.empty() && (field.front() == ' ' || field.front() == '"')) field.remove_prefix(1);
+    while (!field.empty() && (field.back() == ' ' || field.back() == '"')) field.remove_suffix(1);
+    return field;
+}
+
+} // namespace
+
+PuzzleFormat formatFromPath(std::string_view path) {
+    PuzzleFormat format = PuzzleFormat::Sdm;
+    formatFromName(extensionOf(path), format);
+    return format;
+}
+
+bool formatFromName(std::string_view name, PuzzleFormat& format) {
+    if (equalsIgnoreCase(name, "sdm") || equalsIgnoreCase(name, "txt")) {
+        format = PuzzleFormat::Sdm;
+    } else if (equalsIgnoreCase(name, "sdk")) {
+        format = PuzzleFormat::Sdk;
+    } else if (equalsIgnoreCase(name, "csv")) {
+        format = PuzzleFormat::Csv;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+PuzzleReader::PuzzleReader(PuzzleFormat format, bool atFileStart)
+    : format(format)
+    , carry{}
+    , carryLength(0)
+    , carryOverflow(false)
+    , lineNumber(atFileStart ? 0 : 1)
+    , records(0)
+    , rejected(0)
+    , pendingCells(0)
+{
+}
+
+void PuzzleReader::feed(std::string_view data, const PuzzleCallback& onRecord) {
+    const char* begin = data.data();
+    const char* end = begin + data.size();
+
+    // Complete a line left over from the previous piece
+    if (carryLength > 0 || carryOverflow) {
+        const char* newline = static_cast<const char*>(std::memchr(begin, '\n', end - begin));
+        const char* stop = newline ? newline : end;
+        std::size_t length = stop - begin;
+        if (carryLength + length <= carry.size()) {
+            std::memcpy(carry.data() + carryLength, begin, length);
+            carryLength += length;
+        } else {
+            carryOverflow = true;
+        }
+        if (!newline) return;
+
+        if (carryOverflow) {
+            lineNumber++;
+            rejected++;
+        } else {
+            parseLine(std::string_view(carry.data(), carryLength), onRecord);
+        }
+        carryLength = 0;
+        carryOverflow = false;
+        begin = newline + 1;
+    }
+
+    while (begin < end) {
+        const char* newline = static_cast<const char*>(std::memchr(begin, '\n', end - begin));
+        if (!newline) break;
+        parseLine(std::string_view(begin, newline - begin), onRecord);
+        begin = newline + 1;
+    }
+
+    // Keep the unfinished tail for the next piece
+    std::size_t tail = end - begin;
+    if (tail > carry.size()) {
+        carryOverflow = true;
+    } else if (tail > 0) {
+        std::memcpy(carry.data(), begin, tail);
+        carryLength = tail;
+    }
+}
+
+void PuzzleReader::finish(const PuzzleCallback& onRecord) {
+    if (carryOverflow) {
+        rejected++;
+    } else if (carryLength > 0) {
+        parseLine(std::string_view(carry.data(), carryLength), onRecord);
+    }
+    carryLength = 0;
+    carryOverflow = false;
+
+    // An .sdk file may end without a blank line after the last puzzle
+    if (pendingCells > 0) {
+        rejected++;
+        pendingCells = 0;
+    }
+}
+
+void PuzzleReader::parseLine(std::string_view line, const PuzzleCallback& onRecord) {
+    lineNumber++;
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+
+    switch (format) {
+    case PuzzleFormat::Sdm: {
+        if (line.empty() || line[0] == '#') return;
+        PuzzleRecord record;
+        if (parseBoard(line, record.puzzle)) {
+            records++;
+            onRecord(record);
+        } else {
+            rejected++;
+        }
+        break;
+    }
+    case PuzzleFormat::Sdk:
+        parseSdkLine(line, onRecord);
+        break;
+    case PuzzleFormat::Csv:
+        parseCsvLine(line, onRecord);
+        break;
+    }
+}
+
+void PuzzleReader::parseSdkLine(std::string_view line, const PuzzleCallback& onRecord) {
+    if (!line.empty() && (line[0] == '#' || line[0] == '[')) return;
+
+    if (line.find_first_not_of(" \t") == std::string_view::npos) {
+        // A blank line ends the current puzzle
+        if (pendingCells > 0) {
+            rejected++;
+            pendingCells = 0;
+        }
+        return;
+    }
+
+    // Digits and '.' are cells; spaces, '|', '-' and '+' are decoration
+    for (char c : line) {
+        int value;
+        if (c >= '0' && c <= '9') {
+            value = c - '0';
+        } else if (c == '.') {
+            value = 0;
+        } else {
+            continue;
+        }
+        pending.puzzle[pendingCells++] = static_cast<std::uint8_t>(value);
+        if (pendingCells == 81) {
+            records++;
+            onRecord(pending);
+            pendingCells = 0;
+        }
+    }
+}
+
+void PuzzleReader::parseCsvLine(std::string_view line, const PuzzleCallback& onRecord) {
+    if (line.empty()) return;
+
+    // The first field holding a board is the puzzle, the next one its solution
+    PuzzleRecord record;
+    int boardsFound = 0;
+    std::size_t start = 0;
+    while (start <= line.size() && boardsFound < 2) {
+        std::size_t comma = line.find(',', start);
+        if (comma == std::string_view::npos) comma = line.size();
+        std::string_view field = trimField(line.substr(start, comma - start));
+        if (field.size() == 81) {
+            Board& target = boardsFound == 0 ? record.puzzle : record.solution;
+            if (parseBoard(field, target)) boardsFound++;
+        }
+        start = comma + 1;
+    }
+
+    if (boardsFound == 0) {
+        // The header row names the columns
+        if (lineNumber != 1) rejected++;
+        return;
+    }
+    record.hasSolution = boardsFound == 2;
+    records++;
+    onRecord(record);
+}
+
+std::vector<std::string_view> splitRecordBlocks(std::string_view data, PuzzleFormat format,
+                                                std::size_t blockSize) {
+    std::vector<std::string_view> blocks;
+    if (blockSize == 0) blockSize = 1;
+
+    std::size_t start = 0;
+    while (start < data.size()) {
+        std::size_t end = start + blockSize;
+        if (end >= data.size()) {
+            end = data.size();
+        } else if (format == PuzzleFormat::Sdk) {
+            // .sdk puzzles span several lines; cut after the next blank line
+            std::size_t newline = data.find('\n', end);
+            end = data.size();
+            while (newline != std::string_view::npos) {
+                std::size_t next = data.find('\n', newline + 1);
+                std::size_t lineEnd = next == std::string_view::npos ? data.size() : next;
+                std::string_view line = data.substr(newline + 1, lineEnd - newline - 1);
+                if (line.find_first_not_of(" \t\r") == std::string_view::npos) {
+                    end = next == std::string_view::npos ? data.size() : next + 1;
+                    break;
+                }
+                newline = next;
+            }
+        } else {
+            std::size_t newline = data.find('\n', end);
+            end = newline == std::string_view::npos ? data.size() : newline + 1;
+        }
+        blocks.push_back(data.substr(start, end - start));
+        start = end;
+    }
+    return blocks;
+}
+
+bool readPuzzleFile(const std::string& path, PuzzleFormat format, const PuzzleCallback& onRecord,
+                    std::uint64_t* rejected) {
+    PuzzleReader reader(format);
+
+    // Parse straight from the mapped pages; pipes and other unmappable
+    // inputs fall back to buffered reads
+    MappedFile mapped;
+    if (mapped.open(path)) {
+        reader.feed(mapped.view(), onRecord);
+        reader.finish(onRecord);
+        if (rejected) *rejected = reader.rejectedCount();
+        return true;
+    }
+
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return false;
+
+    std::vector<char> buffer(1 << 20);
+    bool ok = true;
+    while (true) {
+        std::size_t length = std::fread(buffer.data(), 1, buffer.size(), file);
+        if (length > 0) reader.feed(std::string_view(buffer.data(), length), onRecord);
+        if (length < buffer.size()) {
+            ok = !std::ferror(file);
+            break;
+        }
+    }
+    reader.finish(onRecord);
+    std::fclose(file);
+
+    if (rejected) *rejected = reader.rejectedCount();
+    return ok;
+}
+
+PuzzleWriter::PuzzleWriter(const std::string& path, PuzzleFormat format)
+    : file(std::fopen(path.c_str(), "wb"))
+    , format(format)
+    , written(0)
+{
+    if (file) std::setvbuf(file, nullptr, _IOFBF, 1 << 16);
+}
+
+PuzzleWriter::~PuzzleWriter() {
+    close();
+}
+
+bool PuzzleWriter::write(const PuzzleRecord& record) {
+    if (!file) return false;
+
+    // SDM and .sdk hold one grid per record: the solved one when there is one
+    const Board& grid = record.hasSolution ? record.solution : record.puzzle;
+    char line[2 * 81 + 2];
+    switch (format) {
+    case PuzzleFormat::Sdm:
+        for (int i = 0; i < 81; ++i) line[i] = static_cast<char>('0' + grid[i]);
+        line[81] = '\n';
+        std::fwrite(line, 1, 82, file);
+        break;
+    case PuzzleFormat::Sdk:
+        if (written > 0) std::fputc('\n', file);
+        for (int row = 0; row < 9; ++row) {
+            for (int col = 0; col < 9; ++col) {
+                std::uint8_t value = grid[row * 9 + col];
+                line[col] = value ? static_cast<char>('0' + value) : '.';
+            }
+            line[9] = '\n';
+            std::fwrite(line, 1, 10, file);
+        }
+        break;
+    case PuzzleFormat::Csv: {
+        if (written == 0) std::fputs("puzzle,solution\n", file);
+        std::size_t length = 0;
+        for (int i = 0; i < 81; ++i) line[length++] = static_cast<char>('0' + record.puzzle[i]);
+        line[length++] = ',';
+        if (record.hasSolution) {
+            for (int i = 0; i < 81; ++i) line[length++] = static_cast<char>('0' + record.solution[i]);
+        }
+        line[length++] = '\n';
+        std::fwrite(line, 1, length, file);
+        break;
+    }
+    }
+    written++;
+    return !std::ferror(file);
+}
+
+bool PuzzleWriter::close() {
+    if (!file) return true;
+    bool ok = !std::ferror(file);
+    ok = std::fclose(file) == 0 && ok;
+    file = nullptr;
+    return ok;
+}
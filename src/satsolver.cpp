@@ -0,0 +1,523 @@
+#include "satsolver.h"
+#include <algorithm>
+#include <optional>
+
+namespace {
+
+// Luby sequence 1 1 2 1 1 2 4 1 1 2 ... for restart intervals
+std::uint64_t luby(std::uint64_t index) {
+    std::uint64_t size = 1, power = 1;
+    while (size < index + 1) {
+        size = 2 * size + 1;
+        power *= 2;
+    }
+    while (size - 1 != index) {
+        size = (size - 1) / 2;
+        power /= 2;
+        index %= size;
+    }
+    return power;
+}
+
+constexpr std::uint64_t kRestartConflicts = 64;
+constexpr double kActivityDecay = 0.95;
+
+} // namespace
+
+void SatSolver::clear() {
+    literalPool.clear();
+    clauses.clear();
+    for (auto& list : watches) list.clear();
+    originalClauses = 0;
+    unsatisfiable = false;
+    assigns.clear();
+    savedPhase.clear();
+    levels.clear();
+    reasons.clear();
+    trail.clear();
+    trailLimits.clear();
+    propagated = 0;
+    activity.clear();
+    activityStep = 1;
+    heap.clear();
+    heapPosition.clear();
+    seen.clear();
+    learned = 0;
+}
+
+int SatSolver::addVariable() {
+    int var = variableCount();
+    assigns.push_back(-1);
+    savedPhase.push_back(0);
+    levels.push_back(0);
+    reasons.push_back(kNoReason);
+    activity.push_back(0);
+    heapPosition.push_back(-1);
+    seen.push_back(0);
+    if (watches.size() < assigns.size() * 2) watches.resize(assigns.size() * 2);
+    heapInsert(var);
+    return var;
+}
+
+bool SatSolver::addClause(std::span<const Literal> clause) {
+    if (unsatisfiable) return false;
+    learntClause.assign(clause.begin(), clause.end());
+    std::sort(learntClause.begin(), learntClause.end());
+    learntClause.erase(std::unique(learntClause.begin(), learntClause.end()), learntClause.end());
+
+    // Drop literals false at the top level; a true literal or a literal and
+    // its negation satisfy the clause outright
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < learntClause.size(); ++i) {
+        Literal lit = learntClause[i];
+        if (valueOf(lit) == 1 || (i > 0 && learntClause[i - 1] == (lit ^ 1))) return true;
+        if (valueOf(lit) == 0) continue;
+        learntClause[kept++] = lit;
+    }
+    learntClause.resize(kept);
+
+    if (learntClause.empty()) {
+        unsatisfiable = true;
+    } else if (learntClause.size() == 1) {
+        enqueue(learntClause[0], kNoReason);
+        unsatisfiable = propagate() != kNoReason;
+    } else {
+        attach(learntClause, 0);
+        originalClauses = clauses.size();
+    }
+    return !unsatisfiable;
+}
+
+std::uint32_t SatSolver::attach(std::span<const Literal> literals, std::uint32_t lbd) {
+    std::uint32_t index = static_cast<std::uint32_t>(clauses.size());
+    clauses.push_back({static_cast<std::uint32_t>(literalPool.size()), static_cast<std::uint32_t>(literals.size()), lbd});
+    literalPool.insert(literalPool.end(), literals.begin(), literals.end());
+    watches[literals[0]].push_back({index, literals[1]});
+    watches[literals[1]].push_back({index, literals[0]});
+    return index;
+}
+
+void SatSolver::enqueue(Literal lit, std::uint32_t reason) {
+    int var = static_cast<int>(lit >> 1);
+    assigns[var] = static_cast<std::int8_t>((lit & 1) ^ 1);
+    levels[var] = decisionLevel();
+    reasons[var] = reason;
+    trail.push_back(lit);
+}
+
+// Unit propagation over the watch lists; returns the conflicting clause or
+// kNoReason. The watched literals of a clause are always its first two,
+// and an implied literal is moved to the front of its reason.
+std::uint32_t SatSolver::propagate() {
+    while (propagated < trail.size()) {
+        Literal falseLit = trail[propagated++] ^ 1;
+        std::vector<Watcher>& list = watches[falseLit];
+        std::size_t keep = 0, next = 0;
+        while (next < list.size()) {
+            Watcher watcher = list[next++];
+            if (valueOf(watcher.blocker) == 1) {
+                list[keep++] = watcher;
+                continue;
+            }
+
+            const Clause& clause = clauses[watcher.clause];
+            Literal* lits = literalPool.data() + clause.start;
+            if (lits[0] == falseLit) std::swap(lits[0], lits[1]);
+            Literal other = lits[0];
+            if (other != watcher.blocker && valueOf(other) == 1) {
+                list[keep++] = {watcher.clause, other};
+                continue;
+            }
+
+            bool moved = false;
+            for (std::uint32_t k = 2; k < clause.size; ++k) {
+                if (valueOf(lits[k]) != 0) {
+                    std::swap(lits[1], lits[k]);
+                    watches[lits[1]].push_back({watcher.clause, other});
+                    moved = true;
+                    break;
+                }
+            }
+            if (moved) continue;
+
+            list[keep++] = {watcher.clause, other};
+            if (valueOf(other) == 0) {
+                while (next < list.size()) list[keep++] = list[next++];
+                list.resize(keep);
+                propagated = trail.size();
+                return watcher.clause;
+            }
+            enqueue(other, watcher.clause);
+            stats.eliminations++;
+        }
+        list.resize(keep);
+    }
+    return kNoReason;
+}
+
+// First-UIP conflict analysis into learntClause, whose first literal is the
+// one the clause asserts after backtracking
+void SatSolver::analyze(std::uint32_t conflict, int& backtrackLevel, std::uint32_t& lbd) {
+    learntClause.assign(1, 0);
+    int pathCount = 0;
+    Literal implied = 0;
+    bool first = true;
+    std::size_t index = trail.size();
+    std::uint32_t reason = conflict;
+    do {
+        const Clause& clause = clauses[reason];
+        const Literal* lits = literalPool.data() + clause.start;
+        for (std::uint32_t i = first ? 0 : 1; i < clause.size; ++i) {
+            int var = static_cast<int>(lits[i] >> 1);
+            if (seen[var] || levels[var] == 0) continue;
+            bumpVariable(var);
+            seen[var] = 1;
+            if (levels[var] >= decisionLevel()) pathCount++;
+            else learntClause.push_back(lits[i]);
+        }
+        while (!seen[trail[--index] >> 1]) {}
+        implied = trail[index];
+        reason = reasons[implied >> 1];
+        seen[implied >> 1] = 0;
+        pathCount--;
+        first = false;
+    } while (pathCount > 0);
+    learntClause[0] = implied ^ 1;
+
+    // Drop literals implied by the others through their reasons
+    analyzed.assign(learntClause.begin(), learntClause.end());
+    std::size_t kept = 1;
+    for (std::size_t i = 1; i < learntClause.size(); ++i) {
+        if (!redundant(learntClause[i])) learntClause[kept++] = learntClause[i];
+    }
+    learntClause.resize(kept);
+    for (Literal lit : analyzed) seen[lit >> 1] = 0;
+
+    backtrackLevel = 0;
+    if (learntClause.size() > 1) {
+        std::size_t deepest = 1;
+        for (std::size_t i = 2; i < learntClause.size(); ++i) {
+            if (levels[learntClause[i] >> 1] > levels[learntClause[deepest] >> 1]) deepest = i;
+        }
+        std::swap(learntClause[1], learntClause[deepest]);
+        backtrackLevel = levels[learntClause[1] >> 1];
+    }
+
+    if (levelStamp.size() < static_cast<std::size_t>(decisionLevel()) + 1) levelStamp.resize(decisionLevel() + 1, 0);
+    ++stamp;
+    lbd = 0;
+    for (Literal lit : learntClause) {
+        int level = levels[lit >> 1];
+        if (levelStamp[level] != static_cast<int>(stamp)) {
+            levelStamp[level] = static_cast<int>(stamp);
+            lbd++;
+        }
+    }
+}
+
+// A literal is redundant when every other literal of its reason is already
+// in the learned clause or fixed at the top level
+bool SatSolver::redundant(Literal lit) const {
+    std::uint32_t reason = reasons[lit >> 1];
+    if (reason == kNoReason) return false;
+    const Clause& clause = clauses[reason];
+    const Literal* lits = literalPool.data() + clause.start;
+    for (std::uint32_t i = 1; i < clause.size; ++i) {
+        int var = static_cast<int>(lits[i] >> 1);
+        if (!seen[var] && levels[var] > 0) return false;
+    }
+    return true;
+}
+
+void SatSolver::cancelUntil(int level) {
+    if (decisionLevel() <= level) return;
+    for (std::size_t i = trail.size(); i > trailLimits[level]; --i) {
+        int var = static_cast<int>(trail[i - 1] >> 1);
+        savedPhase[var] = static_cast<std::int8_t>(trail[i - 1] & 1);
+        assigns[var] = -1;
+        reasons[var] = kNoReason;
+        if (heapPosition[var] < 0) heapInsert(var);
+    }
+    trail.resize(trailLimits[level]);
+    trailLimits.resize(level);
+    propagated = trail.size();
+}
+
+// At the top level, between restarts: keeps the learned clauses with a
+// low literal block distance and the better half of the rest
+void SatSolver::reduceLearned() {
+    // Top-level assignments are never analyzed, so their reasons can go
+    for (Literal lit : trail) reasons[lit >> 1] = kNoReason;
+
+    std::vector<std::uint32_t> order;
+    for (std::size_t i = originalClauses; i < clauses.size(); ++i) order.push_back(static_cast<std::uint32_t>(i));
+    std::sort(order.begin(), order.end(), [this](std::uint32_t a, std::uint32_t b) {
+        if (clauses[a].lbd != clauses[b].lbd) return clauses[a].lbd < clauses[b].lbd;
+        return clauses[a].size < clauses[b].size;
+    });
+    std::size_t keep = order.size() / 2;
+    while (keep < order.size() && clauses[order[keep]].lbd <= 2) keep++;
+    order.resize(keep);
+    std::sort(order.begin(), order.end());
+
+    // Compact the kept clauses after the original ones and rewatch them
+    std::size_t poolEnd = originalClauses > 0 ? clauses[originalClauses - 1].start + clauses[originalClauses - 1].size : 0;
+    std::size_t kept = originalClauses;
+    for (std::uint32_t index : order) {
+        Clause clause = clauses[index];
+        std::copy_n(literalPool.begin() + clause.start, clause.size, literalPool.begin() + poolEnd);
+        clause.start = static_cast<std::uint32_t>(poolEnd);
+        clauses[kept++] = clause;
+        poolEnd += clause.size;
+    }
+    clauses.resize(kept);
+    literalPool.resize(poolEnd);
+
+    for (auto& list : watches) list.clear();
+    for (std::size_t i = 0; i < clauses.size(); ++i) {
+        const Literal* lits = literalPool.data() + clauses[i].start;
+        watches[lits[0]].push_back({static_cast<std::uint32_t>(i), lits[1]});
+        watches[lits[1]].push_back({static_cast<std::uint32_t>(i), lits[0]});
+    }
+}
+
+// Runs until a model, a refutation, the limits or conflictBudget conflicts
+// (nullopt, back at the top level for a restart)
+std::optional<SolveStatus> SatSolver::search(std::uint64_t conflictBudget) {
+    // The clock is read every few hundred decisions or conflicts
+    constexpr std::uint64_t kClockInterval = 256;
+
+    std::uint64_t conflicts = 0;
+    for (;;) {
+        std::uint32_t conflict = propagate();
+        if (conflict != kNoReason) {
+            stats.backtracks++;
+            conflicts++;
+            if (decisionLevel() == 0) return SolveStatus::Unsolvable;
+
+            int backtrackLevel;
+            std::uint32_t lbd;
+            analyze(conflict, backtrackLevel, lbd);
+            cancelUntil(backtrackLevel);
+            if (learntClause.size() == 1) {
+                enqueue(learntClause[0], kNoReason);
+            } else {
+                enqueue(learntClause[0], attach(learntClause, lbd));
+                learned++;
+            }
+            activityStep /= kActivityDecay;
+            if (stats.backtracks % kClockInterval == 0 &&
+                (SolveLimits::Clock::now() >= deadline || stop.stop_requested()))
+                return stop.stop_requested() ? SolveStatus::Cancelled : SolveStatus::TimedOut;
+            continue;
+        }
+
+        if (conflicts >= conflictBudget) {
+            cancelUntil(0);
+            return std::nullopt;
+        }
+        if (stats.nodes >= nodeLimit ||
+            (stats.nodes % kClockInterval == 0 &&
+             (SolveLimits::Clock::now() >= deadline || stop.stop_requested())))
+            return stop.stop_requested() ? SolveStatus::Cancelled : SolveStatus::TimedOut;
+
+        int var = -1;
+        while (!heap.empty()) {
+            int candidate = heapPop();
+            if (assigns[candidate] < 0) {
+                var = candidate;
+                break;
+            }
+        }
+        if (var < 0) return SolveStatus::Solved;
+
+        stats.nodes++;
+        trailLimits.push_back(trail.size());
+        stats.maxDepth = std::max(stats.maxDepth, decisionLevel());
+        enqueue(literal(var, savedPhase[var] != 0), kNoReason);
+    }
+}
+
+SolveStatus SatSolver::solve(const SolveLimits& limits) {
+    stats = SolveStats();
+    deadline = limits.deadlineFrom(SolveLimits::Clock::now());
+    nodeLimit = limits.maxNodes > 0 ? limits.maxNodes : UINT64_MAX;
+    stop = limits.stop;
+    if (unsatisfiable) return SolveStatus::Unsolvable;
+    cancelUntil(0);
+    maxLearned = originalClauses / 3 + 1000;
+
+    PhaseTimer searchTimer;
+    SolveStatus status;
+    for (std::uint64_t restart = 0;; ++restart) {
+        std::optional<SolveStatus> outcome = search(luby(restart) * kRestartConflicts);
+        if (outcome) {
+            status = *outcome;
+            break;
+        }
+        if (clauses.size() - originalClauses > maxLearned) {
+            reduceLearned();
+            maxLearned += maxLearned / 10;
+        }
+    }
+    if (status == SolveStatus::Unsolvable) unsatisfiable = true;
+    stats.searchNs = searchTimer.elapsedNs();
+    return status;
+}
+
+void SatSolver::bumpVariable(int var) {
+    activity[var] += activityStep;
+    if (activity[var] > 1e100) {
+        for (double& value : activity) value *= 1e-100;
+        activityStep *= 1e-100;
+    }
+    if (heapPosition[var] >= 0) heapUp(heapPosition[var]);
+}
+
+void SatSolver::heapInsert(int var) {
+    heapPosition[var] = static_cast<int>(heap.size());
+    heap.push_back(var);
+    heapUp(heapPosition[var]);
+}
+
+int SatSolver::heapPop() {
+    int top = heap[0];
+    heapPosition[top] = -1;
+    heap[0] = heap.back();
+    heap.pop_back();
+    if (!heap.empty()) {
+        heapPosition[heap[0]] = 0;
+        heapDown(0);
+    }
+    return top;
+}
+
+void SatSolver::heapUp(int position) {
+    int var = heap[position];
+    while (position > 0) {
+        int parent = (position - 1) / 2;
+        if (activity[heap[parent]] >= activity[var]) break;
+        heap[position] = heap[parent];
+        heapPosition[heap[position]] = position;
+        position = parent;
+    }
+    heap[position] = var;
+    heapPosition[var] = position;
+}
+
+void SatSolver::heapDown(int position) {
+    int var = heap[position];
+    int size = static_cast<int>(heap.size());
+    for (;;) {
+        int child = 2 * position + 1;
+        if (child >= size) break;
+        if (child + 1 < size && activity[heap[child + 1]] > activity[heap[child]]) child++;
+        if (activity[heap[child]] <= activity[var]) break;
+        heap[position] = heap[child];
+        heapPosition[heap[position]] = position;
+        position = child;
+    }
+    heap[position] = var;
+    heapPosition[var] = position;
+}
+
+// Exactly one literal of the group: an at-least-one clause, then pairwise
+// exclusions for small groups and Sinz's sequential counter for larger
+// ones, where helper s[i] means one of the first i + 1 literals is true
+bool SatSudokuSolver::addExactlyOne(std::span<const SatSolver::Literal> group) {
+    using Literal = SatSolver::Literal;
+    if (!sat.addClause(group)) return false;
+    int n = static_cast<int>(group.size());
+    bool ok = true;
+    auto add = [&](Literal a, Literal b) {
+        Literal pair[] = {a, b};
+        ok = ok && sat.addClause(pair);
+    };
+    if (n <= kPairwiseLimit) {
+        for (int i = 0; i < n; ++i)
+            for (int j = i + 1; j < n; ++j) add(group[i] ^ 1, group[j] ^ 1);
+        return ok;
+    }
+
+    int counter = sat.addVariable();
+    for (int i = 1; i < n - 1; ++i) sat.addVariable();
+    auto s = [counter](int i, bool negated) { return SatSolver::literal(counter + i, negated); };
+    add(group[0] ^ 1, s(0, false));
+    for (int i = 1; i < n - 1; ++i) {
+        add(group[i] ^ 1, s(i, false));
+        add(s(i - 1, true), s(i, false));
+        add(group[i] ^ 1, s(i - 1, true));
+    }
+    add(group[n - 1] ^ 1, s(n - 2, true));
+    return ok;
+}
+
+SolveStatus SatSudokuSolver::solve(const Board& board, Board& solution, const SolveLimits& limits) {
+    stats = SolveStats();
+    PhaseTimer setupTimer;
+    sat.clear();
+
+    // Only digits the givens leave open get a variable
+    std::array<std::uint16_t, 81> candidates;
+    candidates.fill(0x1FF);
+    bool ok = true;
+    for (int cell = 0; cell < 81 && ok; ++cell) {
+        int num = board[cell];
+        if (num == 0) continue;
+        // Out-of-range bytes are rejected before they are shifted by
+        if (num > 9) {
+            ok = false;
+            break;
+        }
+        std::uint16_t bit = static_cast<std::uint16_t>(1u << (num - 1));
+        ok = (candidates[cell] & bit) != 0;
+        for (std::uint8_t peer : units->peers(cell)) {
+            if (board[peer] == num) ok = false;
+            candidates[peer] &= ~bit;
+        }
+    }
+
+    variables.fill(-1);
+    for (int cell = 0; cell < 81 && ok; ++cell) {
+        if (board[cell] != 0) continue;
+        if (candidates[cell] == 0) ok = false;
+        for (int digit = 1; digit <= 9; ++digit)
+            if (candidates[cell] & (1u << (digit - 1))) variables[cell * 9 + digit - 1] = sat.addVariable();
+    }
+
+    std::vector<SatSolver::Literal>& group = clause;
+    for (int cell = 0; cell < 81 && ok; ++cell) {
+        if (board[cell] != 0) continue;
+        group.clear();
+        for (int digit = 0; digit < 9; ++digit)
+            if (variables[cell * 9 + digit] >= 0) group.push_back(SatSolver::literal(variables[cell * 9 + digit]));
+        ok = addExactlyOne(group);
+    }
+    for (int unit = 0; unit < units->size() && ok; ++unit) {
+        std::uint16_t placed = 0;
+        for (std::uint8_t cell : units->cells(unit))
+            if (board[cell] != 0) placed |= static_cast<std::uint16_t>(1u << (board[cell] - 1));
+        for (int digit = 1; digit <= 9 && ok; ++digit) {
+            if (placed & (1u << (digit - 1))) continue;
+            group.clear();
+            for (std::uint8_t cell : units->cells(unit))
+                if (variables[cell * 9 + digit - 1] >= 0) group.push_back(SatSolver::literal(variables[cell * 9 + digit - 1]));
+            ok = !group.empty() && addExactlyOne(group);
+        }
+    }
+    stats.setupNs = setupTimer.elapsedNs();
+    if (!ok) return SolveStatus::Unsolvable;
+
+    SolveStatus status = sat.solve(limits);
+    std::int64_t setupNs = stats.setupNs;
+    stats = sat.getStats();
+    stats.setupNs = setupNs;
+    if (status != SolveStatus::Solved) return status;
+
+    solution = board;
+    for (int index = 0; index < 81 * 9; ++index) {
+        if (variables[index] >= 0 && sat.value(variables[index]))
+            solution[index / 9] = static_cast<std::uint8_t>(index % 9 + 1);
+    }
+    return SolveStatus::Solved;
+}
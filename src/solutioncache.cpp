@@ -0,0 +1,119 @@
+#include "solutioncache.h"
+#include "solver.h"
+#include <algorithm>
+
+std::size_t SolutionCache::BoardHash::operator()(const Board& board) const {
+    return static_cast<std::size_t>(canonicalId(board));
+}
+
+SolutionCache::SolutionCache(std::size_t capacity, std::size_t shardCount) {
+    // Small caches get fewer shards so the capacity is not rounded up much
+    shardCount = std::clamp<std::size_t>(shardCount, 1, std::max<std::size_t>(capacity, 1));
+    shardCapacity = std::max<std::size_t>((capacity + shardCount - 1) / shardCount, 1);
+    shards.reserve(shardCount);
+    for (std::size_t i = 0; i < shardCount; ++i) {
+        auto shard = std::make_unique<Shard>();
+        shard->index.reserve(shardCapacity);
+        shard->entries.reserve(shardCapacity);
+        shards.push_back(std::move(shard));
+    }
+}
+
+SolutionCache::Shard& SolutionCache::shardFor(const Board& canonical) {
+    // The low bits pick the bucket inside the shard's map; use the high ones here
+    return *shards[(canonicalId(canonical) >> 32) % shards.size()];
+}
+
+bool SolutionCache::lookup(const Board& canonical, SolveStatus& status, Board& solution) {
+    Shard& shard = shardFor(canonical);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto found = shard.index.find(canonical);
+    if (found == shard.index.end()) {
+        shard.counters.misses++;
+        return false;
+    }
+    Entry& entry = shard.entries[found->second];
+    entry.referenced = true;
+    status = entry.status;
+    solution = entry.solution;
+    shard.counters.hits++;
+    return true;
+}
+
+void SolutionCache::insert(const Board& canonical, SolveStatus status, const Board& solution) {
+    Shard& shard = shardFor(canonical);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto found = shard.index.find(canonical);
+    if (found != shard.index.end()) {
+        Entry& entry = shard.entries[found->second];
+        entry.status = status;
+        entry.solution = solution;
+        entry.referenced = true;
+        return;
+    }
+
+    std::size_t slot;
+    if (shard.entries.size() < shardCapacity) {
+        slot = shard.entries.size();
+        shard.entries.emplace_back();
+    } else {
+        // Sweep past recently used entries, clearing their bit, and evict
+        // the first one not touched since the hand last passed it
+        while (shard.entries[shard.hand].referenced) {
+            shard.entries[shard.hand].referenced = false;
+            shard.hand = (shard.hand + 1) % shardCapacity;
+        }
+        slot = shard.hand;
+        shard.hand = (shard.hand + 1) % shardCapacity;
+        shard.index.erase(shard.entries[slot].key);
+        shard.counters.evictions++;
+    }
+
+    Entry& entry = shard.entries[slot];
+    entry.key = canonical;
+    entry.solution = solution;
+    entry.status = status;
+    entry.referenced = false;
+    shard.index.emplace(canonical, slot);
+}
+
+SolveStatus SolutionCache::solve(const Board& puzzle, Board& solution) {
+    CanonicalBoard canonical = canonicalize(puzzle);
+
+    SolveStatus status;
+    Board cached;
+    if (lookup(canonical.board, status, cached)) {
+        if (status == SolveStatus::Solved) solution = canonical.transform.invert(cached);
+        return status;
+    }
+
+    SudokuSolver solver;
+    Board board = puzzle;
+    status = solver.solve(board, SudokuSolver::threadWorkspace()) ? SolveStatus::Solved
+                                                                    : SolveStatus::Unsolvable;
+    if (status == SolveStatus::Solved) solution = board;
+    insert(canonical.board, status, canonical.transform.apply(board));
+    return status;
+}
+
+CacheCounters SolutionCache::counters() const {
+    CacheCounters total;
+    for (const auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        total.hits += shard->counters.hits;
+        total.misses += shard->counters.misses;
+        total.evictions += shard->counters.evictions;
+    }
+    return total;
+}
+
+std::size_t SolutionCache::size() const {
+    std::size_t total = 0;
+    for (const auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        total += shard->entries.size();
+    }
+    return total;
+}
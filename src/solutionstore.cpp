@@ -0,0 +1,406 @@
+#include "solutionstore.h"
+#include "canonical.h"
+#include "solver.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr char kLogMagic[8] = {'S', 'U', 'D', 'K', 'L', 'O', 'G', '1'};
+constexpr char kIndexMagic[8] = {'S', 'U', 'D', 'K', 'I', 'D', 'X', '1'};
+constexpr std::uint32_t kIndexVersion = 1;
+constexpr std::size_t kLogHeaderSize = 16;
+
+// Log record layout, little-endian:
+//   0 puzzle[81]  81 solution[81]  162 status  163 grade  164 nodes
+//   172 backtracks  180 eliminations  188 maxDepth (32 bit)  192 searchNs
+//   200 CRC32 of bytes 0..199
+constexpr std::size_t kRecordSize = 204;
+constexpr std::size_t kRecordCrcOffset = 200;
+
+// Index slots hold (tag << 40) | (record + 1), 0 for an empty slot; the
+// tag is the top 24 bits of the canonical ID
+constexpr int kRecordBits = 40;
+constexpr std::uint64_t kRecordMask = (std::uint64_t(1) << kRecordBits) - 1;
+constexpr std::uint64_t kMinSlots = 1 << 12;
+
+using Record = std::array<unsigned char, kRecordSize>;
+
+struct CrcTable {
+    std::array<std::uint32_t, 256> entries{};
+
+    constexpr CrcTable() {
+        for (std::uint32_t i = 0; i < 256; ++i) {
+            std::uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit) crc = (crc >> 1) ^ (crc & 1 ? 0xEDB88320u : 0);
+            entries[i] = crc;
+        }
+    }
+};
+
+constexpr CrcTable kCrcTable;
+
+std::uint32_t crc32(const unsigned char* data, std::size_t length) {
+    std::uint32_t crc = 0xFFFFFFFFu;
+    for (std::size_t i = 0; i < length; ++i) crc = kCrcTable.entries[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
+}
+
+template <typename T>
+void putLE(unsigned char* out, T value) {
+    auto bits = static_cast<std::uint64_t>(value);
+    for (std::size_t i = 0; i < sizeof(T); ++i) out[i] = static_cast<unsigned char>(bits >> (8 * i));
+}
+
+template <typename T>
+T getLE(const unsigned char* in) {
+    std::uint64_t bits = 0;
+    for (std::size_t i = 0; i < sizeof(T); ++i) bits |= static_cast<std::uint64_t>(in[i]) << (8 * i);
+    return static_cast<T>(bits);
+}
+
+void encodeRecord(const Board& canonical, const StoredSolution& entry, Record& record) {
+    std::memcpy(&record[0], canonical.data(), 81);
+    std::memcpy(&record[81], entry.solution.data(), 81);
+    record[162] = static_cast<unsigned char>(entry.status);
+    record[163] = static_cast<unsigned char>(entry.grade);
+    putLE<std::uint64_t>(&record[164], entry.stats.nodes);
+    putLE<std::uint64_t>(&record[172], entry.stats.backtracks);
+    putLE<std::uint64_t>(&record[180], entry.stats.eliminations);
+    putLE<std::uint32_t>(&record[188], static_cast<std::uint32_t>(entry.stats.maxDepth));
+    putLE<std::int64_t>(&record[192], entry.stats.searchNs);
+    putLE<std::uint32_t>(&record[kRecordCrcOffset], crc32(record.data(), kRecordCrcOffset));
+}
+
+bool recordIntact(const Record& record) {
+    return getLE<std::uint32_t>(&record[kRecordCrcOffset]) == crc32(record.data(), kRecordCrcOffset);
+}
+
+void decodeRecord(const Record& record, Board& canonical, StoredSolution& entry) {
+    std::memcpy(canonical.data(), &record[0], 81);
+    std::memcpy(entry.solution.data(), &record[81], 81);
+    entry.status = static_cast<SolveStatus>(record[162]);
+    entry.grade = static_cast<PuzzleGrade>(record[163]);
+    entry.stats = SolveStats();
+    entry.stats.nodes = getLE<std::uint64_t>(&record[164]);
+    entry.stats.backtracks = getLE<std::uint64_t>(&record[172]);
+    entry.stats.eliminations = getLE<std::uint64_t>(&record[180]);
+    entry.stats.maxDepth = static_cast<int>(getLE<std::uint32_t>(&record[188]));
+    entry.stats.searchNs = getLE<std::int64_t>(&record[192]);
+}
+
+bool syncFile(std::FILE* file) {
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+bool truncateFile(std::FILE* file, std::uint64_t size) {
+    std::fflush(file);
+#ifdef _WIN32
+    return _chsize_s(_fileno(file), static_cast<long long>(size)) == 0;
+#else
+    return ftruncate(fileno(file), static_cast<off_t>(size)) == 0;
+#endif
+}
+
+std::uint64_t slotsFor(std::uint64_t entries) {
+    // Keep the load factor at or below 3/4
+    std::uint64_t slots = kMinSlots;
+    while (slots * 3 / 4 < entries + 1) slots *= 2;
+    return slots;
+}
+
+bool seekTo(std::FILE* file, std::uint64_t offset) {
+#ifdef _WIN32
+    return _fseeki64(file, static_cast<long long>(offset), SEEK_SET) == 0;
+#else
+    return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+
+std::uint64_t recordOffset(std::uint64_t record) {
+    return kLogHeaderSize + record * kRecordSize;
+}
+
+} // namespace
+
+struct SolutionStore::IndexHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t clean;            // 1 when the slots match the first coveredRecords records
+    std::uint64_t slotCount;        // Power of two
+    std::uint64_t entries;
+    std::uint64_t coveredRecords;
+    std::uint64_t reserved[3];
+};
+
+SolutionStore::~SolutionStore() {
+    close();
+}
+
+SolutionStore::IndexHeader* SolutionStore::header() const {
+    static_assert(sizeof(IndexHeader) == 64, "index header layout");
+    return reinterpret_cast<IndexHeader*>(index.writableData());
+}
+
+std::uint64_t* SolutionStore::slots() const {
+    return reinterpret_cast<std::uint64_t*>(index.writableData() + sizeof(IndexHeader));
+}
+
+bool SolutionStore::open(const std::string& path, const StoreOptions& storeOptions) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (log) return false;
+    options = storeOptions;
+    logPath = path + ".log";
+    indexPath = path + ".idx";
+
+    // Open or start the log
+    log = std::fopen(logPath.c_str(), "r+b");
+    if (log) {
+        char magic[kLogHeaderSize];
+        if (std::fread(magic, 1, kLogHeaderSize, log) != kLogHeaderSize ||
+            std::memcmp(magic, kLogMagic, sizeof(kLogMagic)) != 0 ||
+            getLE<std::uint32_t>(reinterpret_cast<unsigned char*>(magic) + 8) != kRecordSize) {
+            std::fclose(log);
+            log = nullptr;
+            return false;
+        }
+    } else {
+        log = std::fopen(logPath.c_str(), "w+b");
+        if (!log) return false;
+        unsigned char magic[kLogHeaderSize] = {};
+        std::memcpy(magic, kLogMagic, sizeof(kLogMagic));
+        putLE<std::uint32_t>(magic + 8, kRecordSize);
+        if (std::fwrite(magic, 1, kLogHeaderSize, log) != kLogHeaderSize || std::fflush(log) != 0) {
+            std::fclose(log);
+            log = nullptr;
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::uint64_t logSize = std::filesystem::file_size(logPath, error);
+    std::uint64_t logRecords = error ? 0 : (logSize - kLogHeaderSize) / kRecordSize;
+
+    // Reuse the index if it was flushed cleanly; only newer records need scanning
+    std::uint64_t indexSize = std::filesystem::file_size(indexPath, error);
+    bool reusable = false;
+    if (!error && indexSize >= sizeof(IndexHeader) && index.openWritable(indexPath, indexSize)) {
+        const IndexHeader* existing = header();
+        reusable = std::memcmp(existing->magic, kIndexMagic, sizeof(kIndexMagic)) == 0 &&
+                   existing->version == kIndexVersion && existing->clean == 1 &&
+                   existing->slotCount >= kMinSlots &&
+                   indexSize == sizeof(IndexHeader) + existing->slotCount * sizeof(std::uint64_t) &&
+                   existing->coveredRecords <= logRecords &&
+                   slotsFor(existing->entries + logRecords - existing->coveredRecords) <= existing->slotCount;
+    }
+
+    bool ok;
+    if (reusable) {
+        records = header()->coveredRecords;
+        ok = scanLog(records);
+    } else {
+        ok = rebuildIndex(slotsFor(std::max(logRecords, options.expectedEntries)));
+    }
+    if (!ok) {
+        index.close();
+        std::fclose(log);
+        log = nullptr;
+    }
+    return ok;
+}
+
+bool SolutionStore::createIndex(std::uint64_t slotCount) {
+    if (!index.openWritable(indexPath, sizeof(IndexHeader) + slotCount * sizeof(std::uint64_t))) return false;
+    std::memset(index.writableData(), 0, index.size());
+    IndexHeader* fresh = header();
+    std::memcpy(fresh->magic, kIndexMagic, sizeof(kIndexMagic));
+    fresh->version = kIndexVersion;
+    fresh->clean = 0;
+    fresh->slotCount = slotCount;
+    return true;
+}
+
+bool SolutionStore::rebuildIndex(std::uint64_t slotCount) {
+    if (!createIndex(slotCount)) return false;
+    records = 0;
+    return scanLog(0);
+}
+
+bool SolutionStore::scanLog(std::uint64_t firstRecord) {
+    if (!seekTo(log, recordOffset(firstRecord))) return false;
+
+    Record record;
+    Board canonical;
+    std::uint64_t position = firstRecord;
+    std::uint64_t lastIntact = firstRecord;  // Records up to here end with an intact one
+    while (true) {
+        std::size_t length = std::fread(record.data(), 1, kRecordSize, log);
+        if (length < kRecordSize) break;
+        position++;
+        if (!recordIntact(record)) continue;  // Skipped; a damaged tail is cut below
+
+        std::memcpy(canonical.data(), record.data(), 81);
+        markDirty();
+        if (!insertSlot(canonicalId(canonical), position - 1)) return false;
+        lastIntact = position;
+    }
+
+    // A torn append leaves a partial or damaged record at the end
+    std::error_code error;
+    std::uint64_t logSize = std::filesystem::file_size(logPath, error);
+    if (!error && logSize != recordOffset(lastIntact)) {
+        if (!truncateFile(log, recordOffset(lastIntact))) return false;
+    }
+    records = lastIntact;
+    return true;
+}
+
+void SolutionStore::markDirty() {
+    // Any crash from here on leaves the index to be rebuilt on open
+    IndexHeader* current = header();
+    if (current->clean) {
+        current->clean = 0;
+        index.flush(0, sizeof(IndexHeader));
+    }
+}
+
+bool SolutionStore::insertSlot(std::uint64_t id, std::uint64_t record) {
+    IndexHeader* current = header();
+    if (record > kRecordMask - 1 || slotsFor(current->entries) > current->slotCount) return false;
+
+    std::uint64_t mask = current->slotCount - 1;
+    std::uint64_t tag = id >> kRecordBits;
+    std::uint64_t* table = slots();
+    std::uint64_t slot = id & mask;
+    while (table[slot] != 0) slot = (slot + 1) & mask;
+    table[slot] = (tag << kRecordBits) | (record + 1);
+    current->entries++;
+    return true;
+}
+
+bool SolutionStore::findRecord(const Board& canonical, std::uint64_t& record) {
+    std::uint64_t id = canonicalId(canonical);
+    std::uint64_t mask = header()->slotCount - 1;
+    std::uint64_t tag = id >> kRecordBits;
+    const std::uint64_t* table = slots();
+
+    Board stored;
+    StoredSolution entry;
+    for (std::uint64_t slot = id & mask; table[slot] != 0; slot = (slot + 1) & mask) {
+        if (table[slot] >> kRecordBits != tag) continue;
+        std::uint64_t candidate = (table[slot] & kRecordMask) - 1;
+        if (readRecord(candidate, stored, entry) && stored == canonical) {
+            record = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SolutionStore::readRecord(std::uint64_t record, Board& canonical, StoredSolution& entry) {
+    Record bytes;
+    if (!seekTo(log, recordOffset(record)) || std::fread(bytes.data(), 1, kRecordSize, log) != kRecordSize)
+        return false;
+    decodeRecord(bytes, canonical, entry);
+    return true;
+}
+
+bool SolutionStore::lookup(const Board& canonical, StoredSolution& entry) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!log) return false;
+
+    std::uint64_t record;
+    Board stored;
+    return findRecord(canonical, record) && readRecord(record, stored, entry);
+}
+
+bool SolutionStore::append(const Board& canonical, const StoredSolution& entry) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!log) return false;
+
+    std::uint64_t existing;
+    if (findRecord(canonical, existing)) return true;
+    return appendLocked(canonical, entry);
+}
+
+bool SolutionStore::appendLocked(const Board& canonical, const StoredSolution& entry) {
+    // Grow first: a rebuild rescans the log, which must not yet hold this record
+    if (slotsFor(header()->entries + 1) > header()->slotCount) {
+        if (!rebuildIndex(header()->slotCount * 2)) return false;
+    }
+
+    Record record;
+    encodeRecord(canonical, entry, record);
+    if (!seekTo(log, recordOffset(records)) || std::fwrite(record.data(), 1, kRecordSize, log) != kRecordSize ||
+        std::fflush(log) != 0)
+        return false;
+    if (options.syncEachAppend && !syncFile(log)) return false;
+
+    markDirty();
+    if (!insertSlot(canonicalId(canonical), records)) return false;
+    records++;
+    return true;
+}
+
+bool SolutionStore::flush() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!log) return false;
+
+    // The log must be durable before the index claims to cover it
+    if (std::fflush(log) != 0 || !syncFile(log) || !index.flush()) return false;
+    IndexHeader* current = header();
+    current->coveredRecords = records;
+    current->clean = 1;
+    return index.flush(0, sizeof(IndexHeader));
+}
+
+void SolutionStore::close() {
+    if (!isOpen()) return;
+    flush();
+    std::lock_guard<std::mutex> lock(mutex);
+    index.close();
+    std::fclose(log);
+    log = nullptr;
+}
+
+std::uint64_t SolutionStore::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return log ? header()->entries : 0;
+}
+
+SolveStatus SolutionStore::solve(const Board& puzzle, Board& solution, SolveStats* stats) {
+    for (std::uint8_t cell : puzzle)
+        if (cell > 9) return SolveStatus::Unsolvable;
+
+    CanonicalBoard canonical = canonicalize(puzzle);
+    StoredSolution entry;
+    if (lookup(canonical.board, entry)) {
+        if (entry.status == SolveStatus::Solved) solution = canonical.transform.invert(entry.solution);
+        if (stats) *stats = entry.stats;
+        return entry.status;
+    }
+
+    SudokuSolver solver;
+    Board board = puzzle;
+    bool solved = solver.solve(board, SudokuSolver::threadWorkspace());
+    entry.status = solved ? SolveStatus::Solved : SolveStatus::Unsolvable;
+    entry.stats = solver.getStats();
+    entry.grade = gradeFromStats(entry.stats);
+    entry.solution = solved ? canonical.transform.apply(board) : canonical.board;
+    if (solved) solution = board;
+    if (stats) *stats = entry.stats;
+    append(canonical.board, entry);
+    return entry.status;
+}
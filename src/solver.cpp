@@ -0,0 +1,478 @@
+#include "solver.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace {
+
+// Frame of a search level that has not picked its cell yet
+constexpr std::uint8_t kNoCell = 0xFF;
+
+inline std::uint16_t digitBit(int num) {
+    return static_cast<std::uint16_t>(1u << (num - 1));
+}
+
+} // namespace
+
+template <bool Classic>
+std::uint16_t SudokuSolver::usedMask(const SolverWorkspace& ws, int cell) const {
+    if constexpr (Classic) {
+        return ws.unitUsed[cell / 9] | ws.unitUsed[9 + cell % 9] | ws.unitUsed[18 + cell / 27 * 3 + cell % 9 / 3];
+    } else {
+        std::uint16_t used = 0;
+        for (std::uint8_t unit : units->unitsOf(cell)) used |= ws.unitUsed[unit];
+        return used;
+    }
+}
+
+bool SudokuSolver::isSafe(const SolverWorkspace& ws, int cell, int num) const {
+    return !(usedMask<false>(ws, cell) & digitBit(num));
+}
+
+template <bool Classic>
+void SudokuSolver::place(SolverWorkspace& ws, int cell, int num, SolveTechnique technique) {
+    std::uint16_t bit = digitBit(num);
+
+    // Count the peers that lose this candidate before the masks change.
+    // The count stays local so the peer list is not reloaded after every
+    // increment.
+    std::uint64_t eliminated = 0;
+    auto countPeers = [&](auto peers) {
+        for (std::uint8_t peer : peers) {
+            if (ws.cells[peer] == 0 && !(usedMask<Classic>(ws, peer) & bit)) {
+                eliminated++;
+                if (trace)
+                    trace->record(TraceEventType::Eliminate, SolveTechnique::Propagation, peer / 9, peer % 9, num);
+            }
+        }
+    };
+    // Classic cells have exactly 20 peers, a loop the compiler can unroll
+    if constexpr (Classic) countPeers(units->peers(cell).template first<20>());
+    else countPeers(units->peers(cell));
+    stats.eliminations += eliminated;
+
+    ws.cells[cell] = static_cast<std::uint8_t>(num);
+    ws.hash ^= kZobrist(cell, num);
+    if constexpr (Classic) {
+        ws.unitUsed[cell / 9] |= bit;
+        ws.unitUsed[9 + cell % 9] |= bit;
+        ws.unitUsed[18 + cell / 27 * 3 + cell % 9 / 3] |= bit;
+    } else {
+        for (std::uint8_t unit : units->unitsOf(cell)) ws.unitUsed[unit] |= bit;
+    }
+    if (trace) trace->record(TraceEventType::Assign, technique, cell / 9, cell % 9, num);
+}
+
+template <bool Classic>
+void SudokuSolver::unplace(SolverWorkspace& ws, int cell, int num) {
+    std::uint16_t bit = digitBit(num);
+    ws.cells[cell] = 0;
+    ws.hash ^= kZobrist(cell, num);
+    if constexpr (Classic) {
+        ws.unitUsed[cell / 9] &= ~bit;
+        ws.unitUsed[9 + cell % 9] &= ~bit;
+        ws.unitUsed[18 + cell / 27 * 3 + cell % 9 / 3] &= ~bit;
+    } else {
+        for (std::uint8_t unit : units->unitsOf(cell)) ws.unitUsed[unit] &= ~bit;
+    }
+    if (trace) trace->record(TraceEventType::Backtrack, SolveTechnique::Guess, cell / 9, cell % 9, num);
+}
+
+void SudokuSolver::beginSearch(SolverWorkspace& ws) {
+    ws.depth = 0;
+    ws.frames[0] = SearchFrame{kNoCell, 0};
+}
+
+// Depth-first search over the first empty cell, trying digits in order.
+// The stack lives in the workspace, so the search can return Paused after
+// nodeBudget placements and pick up exactly where it stopped.
+SudokuSolver::SearchState SudokuSolver::continueSearch(SolverWorkspace& ws, std::uint64_t nodeBudget) {
+    return units->isClassic() ? runSearch<true>(ws, nodeBudget) : runSearch<false>(ws, nodeBudget);
+}
+
+template <bool Classic>
+SudokuSolver::SearchState SudokuSolver::runSearch(SolverWorkspace& ws, std::uint64_t nodeBudget) {
+    PhaseTimer searchTimer;
+    std::uint64_t nodeLimit = stats.nodes + nodeBudget;
+    if (nodeLimit < stats.nodes) nodeLimit = UINT64_MAX;
+
+    SearchState state;
+    int depth = ws.depth;
+    while (true) {
+        SearchFrame& frame = ws.frames[depth];
+        if (frame.cell == kNoCell) {
+            // Entering a level: everything before the parent's cell is filled
+            if (depth > stats.maxDepth) stats.maxDepth = depth;
+            int cell = depth > 0 ? ws.frames[depth - 1].cell + 1 : 0;
+            while (cell < 81 && ws.cells[cell] != 0) cell++;
+            if (cell == 81) {
+                state = SearchState::Solved;
+                break;
+            }
+            frame.cell = static_cast<std::uint8_t>(cell);
+            frame.candidates = static_cast<std::uint16_t>(~usedMask<Classic>(ws, cell) & 0x1FF);
+        } else if (ws.cells[frame.cell] != 0) {
+            // Back from a subtree that failed
+            unplace<Classic>(ws, frame.cell, ws.cells[frame.cell]);
+            stats.backtracks++;
+        }
+
+        if (frame.candidates == 0) {
+            frame.cell = kNoCell;
+            if (depth == 0) {
+                state = SearchState::Exhausted;
+                break;
+            }
+            depth--;
+            continue;
+        }
+
+        if (stats.nodes >= nodeLimit) {
+            state = SearchState::Paused;
+            break;
+        }
+        int num = std::countr_zero(frame.candidates) + 1;
+        frame.candidates &= frame.candidates - 1;
+        stats.nodes++;
+        place<Classic>(ws, frame.cell, num, SolveTechnique::Guess);
+        ws.frames[++depth].cell = kNoCell;
+    }
+
+    ws.depth = depth;
+    stats.searchNs += searchTimer.elapsedNs();
+    return state;
+}
+
+SolveStatus SudokuSolver::countSolutions(const Board& board, SolverWorkspace& ws, std::uint64_t& count,
+                                         std::uint64_t maxCount, const SolveLimits& limits) {
+    count = 0;
+    if (!prepare(board, ws)) return SolveStatus::Unsolvable;
+    if (maxCount == 0) maxCount = UINT64_MAX;
+    return units->isClassic() ? runCount<true>(ws, maxCount, limits, nullptr, count)
+                              : runCount<false>(ws, maxCount, limits, nullptr, count);
+}
+
+SolveStatus SudokuSolver::enumerateSolutions(const Board& board, SolverWorkspace& ws,
+                                             const SolutionCallback& onSolution, std::uint64_t& count,
+                                             std::uint64_t maxCount, const SolveLimits& limits) {
+    count = 0;
+    if (!prepare(board, ws)) return SolveStatus::Unsolvable;
+    if (maxCount == 0) maxCount = UINT64_MAX;
+    return units->isClassic() ? runCount<true>(ws, maxCount, limits, &onSolution, count)
+                              : runCount<false>(ws, maxCount, limits, &onSolution, count);
+}
+
+// The search of runSearch() run to the end: a solution counts and is
+// backtracked out of like a dead end. Within one search no board is
+// reached twice, since paths part at different digits for the same cell;
+// the table pays off across searches of related boards.
+template <bool Classic>
+SolveStatus SudokuSolver::runCount(SolverWorkspace& ws, std::uint64_t maxCount, const SolveLimits& limits,
+                                   const SolutionCallback* onSolution, std::uint64_t& count) {
+    // The clock is read every few thousand nodes, well under a millisecond
+    constexpr std::uint64_t kClockInterval = 4096;
+
+    PhaseTimer searchTimer;
+    SolveLimits::Clock::time_point deadline = limits.deadlineFrom(SolveLimits::Clock::now());
+    std::uint64_t nodeLimit = limits.maxNodes > 0 ? limits.maxNodes : UINT64_MAX;
+    // Subtrees smaller than this are cheaper to search again than to keep
+    constexpr std::uint64_t kMinStoredNodes = 64;
+
+    std::array<std::uint64_t, 82> countAtEntry;
+    std::array<std::uint64_t, 82> nodesAtEntry;
+
+    beginSearch(ws);
+    SolveStatus status = SolveStatus::Solved;
+    int depth = 0;
+    while (true) {
+        SearchFrame& frame = ws.frames[depth];
+        if (frame.cell == kNoCell) {
+            if (depth > stats.maxDepth) stats.maxDepth = depth;
+            int cell = depth > 0 ? ws.frames[depth - 1].cell + 1 : 0;
+            while (cell < 81 && ws.cells[cell] != 0) cell++;
+            if (cell == 81) {
+                if (onSolution && !(*onSolution)(ws.cells)) {
+                    status = SolveStatus::Cancelled;
+                    break;
+                }
+                if (++count >= maxCount) break;
+                if (depth == 0) break;
+                depth--;
+                continue;
+            }
+            frame.cell = static_cast<std::uint8_t>(cell);
+            frame.candidates = static_cast<std::uint16_t>(~usedMask<Classic>(ws, cell) & 0x1FF);
+            countAtEntry[depth] = count;
+            nodesAtEntry[depth] = stats.nodes;
+            // A board proven dead before, here or by a solver sharing the
+            // table, is not searched again
+            if (transpositions && frame.candidates != 0 && transpositions->contains(ws.hash)) frame.candidates = 0;
+        } else if (ws.cells[frame.cell] != 0) {
+            unplace<Classic>(ws, frame.cell, ws.cells[frame.cell]);
+            stats.backtracks++;
+            // Every digit tried and nothing found: the board as it was on
+            // entering is dead
+            if (frame.candidates == 0 && transpositions && count == countAtEntry[depth] &&
+                stats.nodes - nodesAtEntry[depth] >= kMinStoredNodes)
+                transpositions->insert(ws.hash);
+        }
+
+        if (frame.candidates == 0) {
+            frame.cell = kNoCell;
+            if (depth == 0) break;
+            depth--;
+            continue;
+        }
+
+        if (stats.nodes >= nodeLimit ||
+            (stats.nodes % kClockInterval == 0 && SolveLimits::Clock::now() >= deadline)) {
+            status = SolveStatus::TimedOut;
+            break;
+        }
+        if (stats.nodes % kClockInterval == 0 && limits.stop.stop_requested()) {
+            status = SolveStatus::Cancelled;
+            break;
+        }
+        int num = std::countr_zero(frame.candidates) + 1;
+        frame.candidates &= frame.candidates - 1;
+        stats.nodes++;
+        place<Classic>(ws, frame.cell, num, SolveTechnique::Guess);
+        ws.frames[++depth].cell = kNoCell;
+    }
+
+    ws.depth = depth;
+    stats.searchNs += searchTimer.elapsedNs();
+    if (status == SolveStatus::Solved && count == 0) status = SolveStatus::Unsolvable;
+    return status;
+}
+
+bool SudokuSolver::startSearch(const Board& board, SolverWorkspace& ws) {
+    if (!prepare(board, ws)) return false;
+    beginSearch(ws);
+    return true;
+}
+
+// Checkpoint layout: magic, packed cells, depth, then per frame the cell
+// and candidate mask, then the counters; integers little-endian
+namespace {
+
+constexpr char kCheckpointMagic[8] = {'S', 'U', 'D', 'K', 'C', 'K', 'P', '1'};
+constexpr std::size_t kCheckpointFixedSize = 8 + kPackedBoardSize + 1 + 3 * 8 + 4;
+
+void putBytes(std::vector<std::uint8_t>& out, std::uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; ++i) out.push_back(static_cast<std::uint8_t>(value >> (8 * i)));
+}
+
+std::uint64_t getBytes(const std::uint8_t*& in, int bytes) {
+    std::uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i) value |= static_cast<std::uint64_t>(*in++) << (8 * i);
+    return value;
+}
+
+} // namespace
+
+std::vector<std::uint8_t> SudokuSolver::checkpoint(const SolverWorkspace& ws) const {
+    std::vector<std::uint8_t> data(kCheckpointMagic, kCheckpointMagic + sizeof(kCheckpointMagic));
+    data.reserve(kCheckpointFixedSize + 3 * (ws.depth + 1));
+    data.resize(data.size() + kPackedBoardSize);
+    packBoard(ws.cells, &data[sizeof(kCheckpointMagic)]);
+    putBytes(data, ws.depth, 1);
+    for (int level = 0; level <= ws.depth; ++level) {
+        putBytes(data, ws.frames[level].cell, 1);
+        putBytes(data, ws.frames[level].candidates, 2);
+    }
+    putBytes(data, stats.nodes, 8);
+    putBytes(data, stats.backtracks, 8);
+    putBytes(data, stats.eliminations, 8);
+    putBytes(data, static_cast<std::uint32_t>(stats.maxDepth), 4);
+    return data;
+}
+
+bool SudokuSolver::restore(std::span<const std::uint8_t> data, SolverWorkspace& ws) {
+    if (data.size() < kCheckpointFixedSize ||
+        std::memcmp(data.data(), kCheckpointMagic, sizeof(kCheckpointMagic)) != 0)
+        return false;
+    const std::uint8_t* in = data.data() + sizeof(kCheckpointMagic);
+    Board cells;
+    unpackBoard(in, cells);
+    in += kPackedBoardSize;
+    int depth = static_cast<int>(getBytes(in, 1));
+    if (depth > 81 || data.size() != kCheckpointFixedSize + 3 * static_cast<std::size_t>(depth + 1)) return false;
+
+    // Rebuild the masks from the cells, which also rejects clashing digits
+    SolverWorkspace loaded;
+    for (int cell = 0; cell < 81; ++cell) {
+        int num = cells[cell];
+        if (num == 0) continue;
+        if (num > 9 || !isSafe(loaded, cell, num)) return false;
+        std::uint16_t bit = digitBit(num);
+        loaded.cells[cell] = static_cast<std::uint8_t>(num);
+        loaded.hash ^= kZobrist(cell, num);
+        for (std::uint8_t unit : units->unitsOf(cell)) loaded.unitUsed[unit] |= bit;
+    }
+
+    // Levels below the top hold placed cells in increasing order; the top
+    // one has not picked a cell yet or has an empty one
+    int previous = -1;
+    for (int level = 0; level <= depth; ++level) {
+        SearchFrame& frame = loaded.frames[level];
+        frame.cell = static_cast<std::uint8_t>(getBytes(in, 1));
+        frame.candidates = static_cast<std::uint16_t>(getBytes(in, 2));
+        if (frame.candidates > 0x1FF) return false;
+        if (level == depth && frame.cell == kNoCell) break;
+        if (frame.cell >= 81 || frame.cell <= previous) return false;
+        if ((loaded.cells[frame.cell] == 0) != (level == depth)) return false;
+        previous = frame.cell;
+    }
+    loaded.depth = depth;
+
+    // Untried digits must fit their cell once the deeper levels are undone
+    SolverWorkspace unwound = loaded;
+    for (int level = depth; level >= 0; --level) {
+        const SearchFrame& frame = loaded.frames[level];
+        if (frame.cell == kNoCell) continue;
+        int num = unwound.cells[frame.cell];
+        if (num != 0) {
+            std::uint16_t bit = digitBit(num);
+            unwound.cells[frame.cell] = 0;
+            for (std::uint8_t unit : units->unitsOf(frame.cell)) unwound.unitUsed[unit] &= ~bit;
+        }
+        if (frame.candidates & usedMask<false>(unwound, frame.cell)) return false;
+    }
+    in = data.data() + data.size() - (3 * 8 + 4);
+
+    ws = loaded;
+    stats = SolveStats();
+    stats.nodes = getBytes(in, 8);
+    stats.backtracks = getBytes(in, 8);
+    stats.eliminations = getBytes(in, 8);
+    stats.maxDepth = static_cast<int>(getBytes(in, 4));
+    return true;
+}
+
+bool SudokuSolver::prepare(const Board& board, SolverWorkspace& ws) {
+    stats = SolveStats();
+
+    // Place the givens one by one, rejecting duplicates
+    PhaseTimer setupTimer;
+    ws.cells.fill(0);
+    ws.unitUsed.fill(0);
+    ws.hash = 0;
+    bool consistent = true;
+    for (int cell = 0; cell < 81 && consistent; ++cell) {
+        int num = board[cell];
+        if (num == 0) continue;
+        if (num > 9 || !isSafe(ws, cell, num)) {
+            consistent = false;
+        } else {
+            place<false>(ws, cell, num, SolveTechnique::Given);
+        }
+    }
+    stats.setupNs = setupTimer.elapsedNs();
+    return consistent;
+}
+
+bool SudokuSolver::search(Board& board, SolverWorkspace& ws) {
+    return search(board, ws, SolveLimits()) == SolveStatus::Solved;
+}
+
+SolveStatus SudokuSolver::search(Board& board, SolverWorkspace& ws, const SolveLimits& limits) {
+    // The clock is read every few thousand nodes, well under a millisecond
+    constexpr std::uint64_t kClockInterval = 4096;
+
+    SolveLimits::Clock::time_point deadline = limits.deadlineFrom(SolveLimits::Clock::now());
+    // Slices are only needed when there is a clock or a stop token to check
+    bool sliced = deadline != SolveLimits::Clock::time_point::max() || limits.stop.stop_possible();
+    std::uint64_t nodeLimit = limits.maxNodes > 0 ? stats.nodes + limits.maxNodes : UINT64_MAX;
+
+    beginSearch(ws);
+    while (true) {
+        std::uint64_t budget = nodeLimit - stats.nodes;
+        if (sliced && budget > kClockInterval) budget = kClockInterval;
+        switch (continueSearch(ws, budget)) {
+        case SearchState::Solved:
+            board = ws.cells;
+            return SolveStatus::Solved;
+        case SearchState::Exhausted:
+            return SolveStatus::Unsolvable;
+        case SearchState::Paused:
+            break;
+        }
+        if (limits.stop.stop_requested()) return SolveStatus::Cancelled;
+        if (stats.nodes >= nodeLimit || (sliced && SolveLimits::Clock::now() >= deadline))
+            return SolveStatus::TimedOut;
+    }
+}
+
+bool SudokuSolver::solve(Board& board, SolverWorkspace& ws) {
+    return prepare(board, ws) && search(board, ws);
+}
+
+SolveStatus SudokuSolver::solve(Board& board, SolverWorkspace& ws, const SolveLimits& limits) {
+    if (!prepare(board, ws)) return SolveStatus::Unsolvable;
+    return search(board, ws, limits);
+}
+
+bool SudokuSolver::solve() {
+    return solve(grid, workspace);
+}
+
+SolveStatus SudokuSolver::solve(const SolveLimits& limits) {
+    return solve(grid, workspace, limits);
+}
+
+SolverWorkspace& SudokuSolver::threadWorkspace() {
+    thread_local SolverWorkspace ws;
+    return ws;
+}
+
+SolveTask SudokuSolver::solveAsync(Board board, std::stop_token stop, AsyncSolveOptions options) {
+    // The workspace lives in the coroutine frame, so concurrent solves on
+    // different solvers never share one
+    SolverWorkspace ws;
+    SolveResult result;
+    if (!prepare(board, ws)) {
+        result.stats = stats;
+        co_return result;
+    }
+
+    // Rescheduling through the scheduler is the yield point
+    struct Yield {
+        const SolveScheduler& scheduler;
+        bool await_ready() const noexcept { return !scheduler; }
+        void await_suspend(std::coroutine_handle<> handle) const { scheduler(handle); }
+        void await_resume() const noexcept {}
+    };
+
+    std::uint64_t slice = options.nodesPerSlice > 0 ? options.nodesPerSlice : 1;
+    SolveLimits::Clock::time_point deadline = options.limits.deadlineFrom(SolveLimits::Clock::now());
+    std::uint64_t nodeLimit = options.limits.maxNodes > 0 ? options.limits.maxNodes : UINT64_MAX;
+    bool timedOut = false;
+    beginSearch(ws);
+    SearchState state = SearchState::Paused;
+    while (true) {
+        if (stop.stop_requested() || options.limits.stop.stop_requested()) break;
+        state = continueSearch(ws, std::min(slice, nodeLimit - stats.nodes));
+        if (state != SearchState::Paused) break;
+        if (stats.nodes >= nodeLimit || SolveLimits::Clock::now() >= deadline) {
+            timedOut = true;
+            break;
+        }
+        co_await Yield{options.scheduler};
+    }
+
+    switch (state) {
+    case SearchState::Solved:
+        result.status = SolveStatus::Solved;
+        result.solution = ws.cells;
+        break;
+    case SearchState::Exhausted:
+        result.status = SolveStatus::Unsolvable;
+        break;
+    case SearchState::Paused:
+        result.status = timedOut ? SolveStatus::TimedOut : SolveStatus::Cancelled;
+        break;
+    }
+    result.stats = stats;
+    co_return result;
+}
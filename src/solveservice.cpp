@@ -0,0 +1,436 @@
+#include "solveservice.h"
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <thread>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr std::size_t kFrameHeaderSize = 8;
+constexpr std::size_t kResultSize = 1 + kPackedBoardSize;
+
+void putU32(std::uint8_t* out, std::uint32_t value) {
+    for (int i = 0; i < 4; ++i) out[i] = static_cast<std::uint8_t>(value >> (8 * i));
+}
+
+std::uint32_t getU32(const std::uint8_t* in) {
+    return in[0] | (in[1] << 8) | (in[2] << 16) | (static_cast<std::uint32_t>(in[3]) << 24);
+}
+
+// Solves one request payload into a complete response frame
+std::vector<std::uint8_t> solveRequest(std::uint32_t count, std::uint32_t tag,
+                                       const std::vector<std::uint8_t>& request,
+                                       const BatchOptions& options) {
+    // Reused by every request this worker thread handles
+    thread_local std::vector<Board> puzzles;
+    thread_local std::vector<Board> solutions;
+    thread_local std::vector<SolveStatus> status;
+    puzzles.resize(count);
+    solutions.assign(count, Board{});
+    status.resize(count);
+
+    for (std::uint32_t i = 0; i < count; ++i) unpackBoard(&request[i * kPackedBoardSize], puzzles[i]);
+    solveBatch(puzzles, solutions, options, status);
+
+    std::vector<std::uint8_t> response(kFrameHeaderSize + count * kResultSize);
+    putU32(&response[0], count);
+    putU32(&response[4], tag);
+    std::uint8_t* out = &response[kFrameHeaderSize];
+    for (std::uint32_t i = 0; i < count; ++i, out += kResultSize) {
+        out[0] = static_cast<std::uint8_t>(status[i]);
+        if (status[i] == SolveStatus::Solved) packBoard(solutions[i], out + 1);
+    }
+    return response;
+}
+
+#ifndef _WIN32
+
+#ifdef MSG_NOSIGNAL
+constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+constexpr int kSendFlags = 0;
+#endif
+
+bool readFully(int fd, std::uint8_t* data, std::size_t length) {
+    while (length > 0) {
+        ssize_t got = ::recv(fd, data, length, 0);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return false;
+        data += got;
+        length -= static_cast<std::size_t>(got);
+    }
+    return true;
+}
+
+bool writeFully(int fd, const std::uint8_t* data, std::size_t length) {
+    while (length > 0) {
+        ssize_t sent = ::send(fd, data, length, kSendFlags);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) return false;
+        data += sent;
+        length -= static_cast<std::size_t>(sent);
+    }
+    return true;
+}
+
+void configureSocket(int fd, bool tcp) {
+    int one = 1;
+#ifdef SO_NOSIGPIPE
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+    // Small responses must not wait for Nagle's algorithm
+    if (tcp) setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+// "PORT" or "HOST:PORT" is TCP; returns false for a Unix socket path
+bool splitTcpAddress(const std::string& address, std::string& host, std::string& port) {
+    if (address.find('/') != std::string::npos) return false;
+    std::size_t colon = address.rfind(':');
+    port = colon == std::string::npos ? address : address.substr(colon + 1);
+    host = colon == std::string::npos || colon == 0 ? "127.0.0.1" : address.substr(0, colon);
+    if (port.empty()) return false;
+    for (char c : port)
+        if (c < '0' || c > '9') return false;
+    return true;
+}
+
+// Opens a socket bound (server) or connected (client) to the address
+int openSocket(const std::string& address, bool server, bool& tcp) {
+    std::string host, port;
+    tcp = splitTcpAddress(address, host, port);
+    if (!tcp) {
+        sockaddr_un local{};
+        local.sun_family = AF_UNIX;
+        if (address.empty() || address.size() >= sizeof(local.sun_path)) return -1;
+        std::memcpy(local.sun_path, address.data(), address.size());
+
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+        bool ok;
+        if (server) {
+            // Replace a socket left behind by an earlier server, never a regular file
+            struct stat info;
+            if (::stat(address.c_str(), &info) == 0 && S_ISSOCK(info.st_mode)) ::unlink(address.c_str());
+            ok = ::bind(fd, reinterpret_cast<sockaddr*>(&local), sizeof(local)) == 0;
+        } else {
+            ok = ::connect(fd, reinterpret_cast<sockaddr*>(&local), sizeof(local)) == 0;
+        }
+        if (!ok) {
+            ::close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* results = nullptr;
+    if (::getaddrinfo(host.c_str(), port.c_str(), &hints, &results) != 0) return -1;
+
+    int fd = -1;
+    for (addrinfo* entry = results; entry && fd < 0; entry = entry->ai_next) {
+        fd = ::socket(entry->ai_family, entry->ai_socktype, entry->ai_protocol);
+        if (fd < 0) continue;
+        bool ok;
+        if (server) {
+            int one = 1;
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+            ok = ::bind(fd, entry->ai_addr, entry->ai_addrlen) == 0;
+        } else {
+            ok = ::connect(fd, entry->ai_addr, entry->ai_addrlen) == 0;
+        }
+        if (!ok) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    ::freeaddrinfo(results);
+    return fd;
+}
+
+#endif
+
+} // namespace
+
+// One client connection: a reader thread parses requests and hands them to
+// the pool, a writer thread sends finished responses back. inFlight counts
+// requests read but not yet answered; once it reaches maxInFlight the
+// reader stops reading, so a client that floods the socket is slowed down
+// by the kernel's flow control instead of growing the server's queues.
+struct SolveServer::Connection {
+    int fd = -1;
+    bool tcp = false;
+    std::thread reader;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::vector<std::uint8_t>> outbox;
+    std::size_t inFlight = 0;
+    bool readerDone = false;
+    std::atomic<bool> broken{false};
+    std::atomic<bool> finished{false};
+};
+
+SolveServer::SolveServer(const ServiceOptions& options)
+    : options(options)
+    , pool(options.threads)
+{
+    if (this->options.maxInFlight == 0) this->options.maxInFlight = 1;
+}
+
+#ifdef _WIN32
+
+SolveServer::~SolveServer() = default;
+
+bool SolveServer::listen(const std::string&) {
+    return false;
+}
+
+void SolveServer::run() {
+}
+
+void SolveServer::serve(const std::shared_ptr<Connection>&) {
+}
+
+void SolveServer::writeResponses(const std::shared_ptr<Connection>&) {
+}
+
+void SolveServer::reapConnections(bool) {
+}
+
+SolveClient::~SolveClient() = default;
+
+bool SolveClient::connect(const std::string&) {
+    return false;
+}
+
+void SolveClient::close() {
+}
+
+bool SolveClient::sendBatch(std::uint32_t, std::span<const Board>) {
+    return false;
+}
+
+bool SolveClient::finishSending() {
+    return false;
+}
+
+void SolveClient::abort() {
+}
+
+bool SolveClient::receiveBatch(std::uint32_t&, std::vector<SolveStatus>&, std::vector<Board>&) {
+    return false;
+}
+
+#else
+
+SolveServer::~SolveServer() {
+    stop();
+    {
+        std::lock_guard<std::mutex> lock(connectionsMutex);
+        for (const auto& connection : connections) ::shutdown(connection->fd, SHUT_RDWR);
+    }
+    reapConnections(true);
+    if (listenFd >= 0) ::close(listenFd);
+    if (!socketPath.empty()) ::unlink(socketPath.c_str());
+}
+
+bool SolveServer::listen(const std::string& address) {
+    if (listenFd >= 0) return false;
+    bool tcp;
+    int fd = openSocket(address, true, tcp);
+    if (fd < 0) return false;
+    if (::listen(fd, SOMAXCONN) != 0) {
+        ::close(fd);
+        return false;
+    }
+    listenFd = fd;
+    if (!tcp) socketPath = address;
+    return true;
+}
+
+void SolveServer::run() {
+    if (listenFd < 0) return;
+
+    // Poll with a timeout so stop() is noticed without touching the socket
+    while (!stopping) {
+        pollfd ready{listenFd, POLLIN, 0};
+        int events = ::poll(&ready, 1, 200);
+        reapConnections(false);
+        if (events <= 0) continue;
+
+        int fd = ::accept(listenFd, nullptr, nullptr);
+        if (fd < 0) continue;
+        auto connection = std::make_shared<Connection>();
+        connection->fd = fd;
+        connection->tcp = socketPath.empty();
+        configureSocket(fd, connection->tcp);
+        connection->reader = std::thread([this, connection] { serve(connection); });
+
+        std::lock_guard<std::mutex> lock(connectionsMutex);
+        connections.push_back(connection);
+    }
+
+    // Stop reading; requests already read are still answered
+    {
+        std::lock_guard<std::mutex> lock(connectionsMutex);
+        for (const auto& connection : connections) ::shutdown(connection->fd, SHUT_RD);
+    }
+    reapConnections(true);
+}
+
+void SolveServer::serve(const std::shared_ptr<Connection>& connection) {
+    std::thread writer([this, connection] { writeResponses(connection); });
+
+    std::uint8_t header[kFrameHeaderSize];
+    while (readFully(connection->fd, header, kFrameHeaderSize)) {
+        std::uint32_t count = getU32(header);
+        std::uint32_t tag = getU32(header + 4);
+        if (count > kMaxServiceBatch) break;
+        std::vector<std::uint8_t> request(count * kPackedBoardSize);
+        if (!readFully(connection->fd, request.data(), request.size())) break;
+
+        {
+            std::unique_lock<std::mutex> lock(connection->mutex);
+            connection->changed.wait(lock, [&] {
+                return connection->inFlight < options.maxInFlight || connection->broken;
+            });
+            if (connection->broken) break;
+            connection->inFlight++;
+        }
+
+        pool.submit([this, connection, count, tag, request = std::move(request)] {
+            // Nobody is left to read the answer once a write has failed
+            std::vector<std::uint8_t> response;
+            if (!connection->broken) response = solveRequest(count, tag, request, options.solver);
+            {
+                std::lock_guard<std::mutex> lock(connection->mutex);
+                connection->outbox.push_back(std::move(response));
+            }
+            connection->changed.notify_all();
+        });
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(connection->mutex);
+        connection->readerDone = true;
+    }
+    connection->changed.notify_all();
+    writer.join();
+    ::close(connection->fd);
+    connection->finished = true;
+}
+
+void SolveServer::writeResponses(const std::shared_ptr<Connection>& connection) {
+    while (true) {
+        std::vector<std::uint8_t> response;
+        bool broken;
+        {
+            std::unique_lock<std::mutex> lock(connection->mutex);
+            connection->changed.wait(lock, [&] {
+                return !connection->outbox.empty() || (connection->readerDone && connection->inFlight == 0);
+            });
+            if (connection->outbox.empty()) return;
+            response = std::move(connection->outbox.front());
+            connection->outbox.pop_front();
+            broken = connection->broken;
+        }
+
+        // After a failed write the remaining responses are dropped
+        bool ok = broken || writeFully(connection->fd, response.data(), response.size());
+        {
+            std::lock_guard<std::mutex> lock(connection->mutex);
+            connection->inFlight--;
+            if (!ok) {
+                connection->broken = true;
+                ::shutdown(connection->fd, SHUT_RDWR);
+            }
+        }
+        connection->changed.notify_all();
+    }
+}
+
+void SolveServer::reapConnections(bool all) {
+    std::lock_guard<std::mutex> lock(connectionsMutex);
+    for (auto it = connections.begin(); it != connections.end();) {
+        if (all || (*it)->finished) {
+            (*it)->reader.join();
+            it = connections.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+SolveClient::~SolveClient() {
+    close();
+}
+
+bool SolveClient::connect(const std::string& address) {
+    close();
+    bool tcp;
+    fd = openSocket(address, false, tcp);
+    if (fd < 0) return false;
+    configureSocket(fd, tcp);
+    return true;
+}
+
+void SolveClient::close() {
+    if (fd < 0) return;
+    ::close(fd);
+    fd = -1;
+}
+
+bool SolveClient::sendBatch(std::uint32_t tag, std::span<const Board> puzzles) {
+    if (fd < 0 || puzzles.size() > kMaxServiceBatch) return false;
+    std::uint32_t count = static_cast<std::uint32_t>(puzzles.size());
+    sendBuffer.resize(kFrameHeaderSize + count * kPackedBoardSize);
+    putU32(&sendBuffer[0], count);
+    putU32(&sendBuffer[4], tag);
+    for (std::uint32_t i = 0; i < count; ++i)
+        packBoard(puzzles[i], &sendBuffer[kFrameHeaderSize + i * kPackedBoardSize]);
+    return writeFully(fd, sendBuffer.data(), sendBuffer.size());
+}
+
+bool SolveClient::finishSending() {
+    return fd >= 0 && ::shutdown(fd, SHUT_WR) == 0;
+}
+
+void SolveClient::abort() {
+    if (fd >= 0) ::shutdown(fd, SHUT_RDWR);
+}
+
+bool SolveClient::receiveBatch(std::uint32_t& tag, std::vector<SolveStatus>& status,
+                               std::vector<Board>& solutions) {
+    std::uint8_t header[kFrameHeaderSize];
+    if (fd < 0 || !readFully(fd, header, kFrameHeaderSize)) return false;
+    std::uint32_t count = getU32(header);
+    tag = getU32(header + 4);
+    if (count > kMaxServiceBatch) return false;
+
+    receiveBuffer.resize(count * kResultSize);
+    if (!readFully(fd, receiveBuffer.data(), receiveBuffer.size())) return false;
+    status.resize(count);
+    solutions.resize(count);
+    for (std::uint32_t i = 0; i < count; ++i) {
+        const std::uint8_t* result = &receiveBuffer[i * kResultSize];
+        status[i] = result[0] <= static_cast<std::uint8_t>(SolveStatus::TimedOut) ? static_cast<SolveStatus>(result[0])
+                                                                                  : SolveStatus::Unsolvable;
+        unpackBoard(result + 1, solutions[i]);
+    }
+    return true;
+}
+
+#endif
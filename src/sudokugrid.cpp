@@ -1,10 +1,16 @@
 #include "sudokugrid.h"
+#include "contradiction.h"
+#include "puzzlecorpus.h"
+#include "puzzleio.h"
 #include <QRegularExpressionValidator>
 #include <QPropertyAnimation>
 #include <QGraphicsOpacityEffect>
 #include <QTime>
 #include <QVBoxLayout>
 #include <QFrame>
+#include <QFileInfo>
+#include <QSignalBlocker>
+#include <optional>
 #include <set>
 
 SudokuGrid::SudokuGrid(QWidget *parent)
@@ -165,6 +171,46 @@ bool SudokuGrid::loadPuzzleFromFile(const QString& filename) {
     return true;
 }
 
+bool SudokuGrid::isCollectionFile(const QString& filename) {
+    QString suffix = QFileInfo(filename).suffix().toLower();
+    return suffix == "sdm" || suffix == "sdk" || suffix == "csv" || suffix == "txt";
+}
+
+bool SudokuGrid::exportToCollectionFile(const QString& filename) const {
+    std::string path = filename.toStdString();
+    PuzzleWriter writer(path, formatFromPath(path));
+    
+    PuzzleRecord record;
+    record.puzzle = boardFromGrid(getGrid());
+    return writer.write(record) && writer.close();
+}
+
+bool SudokuGrid::importFromCollectionFile(const QString& filename) {
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    
+    // The first puzzle sits near the start, so only read the head of large collections
+    QByteArray head = file.read(64 * 1024);
+    PuzzleReader reader(formatFromPath(filename.toStdString()));
+    std::optional<PuzzleRecord> first;
+    auto onRecord = [&first](const PuzzleRecord& record) {
+        if (!first) first = record;
+    };
+    reader.feed(std::string_view(head.constData(), static_cast<std::size_t>(head.size())), onRecord);
+    if (file.atEnd()) {
+        reader.finish(onRecord);
+    }
+    if (!first) return false;
+    
+    clear();
+    notes.clear();
+    setGrid(gridFromBoard(first->puzzle));
+    emit puzzleLoaded(filename);
+    return true;
+}
+
 QStringList SudokuGrid::getSavedPuzzleFiles() const {
     QDir dir(savesDirectory);
     return dir.entryList(QStringList() << "*.sudoku", QDir::Files, QDir::Time);
@@ -314,8 +360,9 @@ void SudokuGrid::validateInput(QLineEdit* cell) {
             auto currentGrid = getGrid();
             cell->setText(QString::number(value));
             
-            // Check if the move creates any conflicts
-            if (!isValid()) {
+            // Check if the move creates any conflicts, or leaves a board
+            // that singles alone show to have no solution
+            if (!isValid() || findContradiction(boardFromGrid(getGrid()), units)) {
                 emit mistakeAdded();  // Signal that a mistake was made
                 animateCell(cell, "#ff6b6b");  // Visual feedback for mistake
             } else {
@@ -358,23 +405,10 @@ std::optional<int> SudokuGrid::getCellValue(int row, int col) const {
     return value.toInt();
 }
 
-bool SudokuGrid::checkRowValid(int row) const {
-    std::vector<bool> used(10, false);
-    for (int col = 0; col < 9; ++col) {
-        QString text = cells[row][col]->text();
-        if (!text.isEmpty()) {
-            int num = text.toInt();
-            if (used[num]) return false;
-            used[num] = true;
-        }
-    }
-    return true;
-}
-
-bool SudokuGrid::checkColumnValid(int col) const {
+bool SudokuGrid::checkUnitValid(int unit) const {
     std::vector<bool> used(10, false);
-    for (int row = 0; row < 9; ++row) {
-        QString text = cells[row][col]->text();
+    for (int cell : units.cells(unit)) {
+        QString text = cells[cell / 9][cell % 9]->text();
         if (!text.isEmpty()) {
             int num = text.toInt();
             if (used[num]) return false;
@@ -384,40 +418,24 @@ bool SudokuGrid::checkColumnValid(int col) const {
     return true;
 }
 
-bool SudokuGrid::checkBoxValid(int startRow, int startCol) const {
-    std::vector<bool> used(10, false);
-    for (int i = 0; i < 3; ++i) {
-        for (int j = 0; j < 3; ++j) {
-            QString text = cells[startRow + i][startCol + j]->text();
-            if (!text.isEmpty()) {
-                int num = text.toInt();
-                if (used[num]) return false;
-                used[num] = true;
-            }
-        }
+bool SudokuGrid::isValid() const {
+    // Rows, columns, boxes and whatever units the rules add
+    for (int unit = 0; unit < units.size(); ++unit) {
+        if (!checkUnitValid(unit)) return false;
     }
     return true;
 }
 
-bool SudokuGrid::isValid() const {
-    // Check all rows
-    for (int i = 0; i < 9; ++i) {
-        if (!checkRowValid(i)) return false;
-    }
-    
-    // Check all columns
-    for (int i = 0; i < 9; ++i) {
-        if (!checkColumnValid(i)) return false;
-    }
-    
-    // Check all 3x3 boxes
-    for (int i = 0; i < 9; i += 3) {
-        for (int j = 0; j < 9; j += 3) {
-            if (!checkBoxValid(i, j)) return false;
-        }
+void SudokuGrid::setUnits(const UnitTable& table) {
+    units = table;
+    solver.setUnits(units);
+    hintFinder.setUnits(units);
+    if (isValid()) {
+        clearHighlighting();
+    } else {
+        highlightConflicts();
     }
-    
-    return true;
+    emit validityChanged(isValid());
 }
 
 void SudokuGrid::highlightConflicts() {
@@ -427,13 +445,13 @@ void SudokuGrid::highlightConflicts() {
     // Track all cells that need highlighting
     std::set<QLineEdit*> conflictCells;
     
-    // Check rows
-    for (int row = 0; row < 9; ++row) {
+    for (int unit = 0; unit < units.size(); ++unit) {
         std::map<int, std::vector<QLineEdit*>> numbers;
-        for (int col = 0; col < 9; ++col) {
-            QString text = cells[row][col]->text();
+        for (int cell : units.cells(unit)) {
+            QLineEdit* edit = cells[cell / 9][cell % 9];
+            QString text = edit->text();
             if (!text.isEmpty()) {
-                numbers[text.toInt()].push_back(cells[row][col]);
+                numbers[text.toInt()].push_back(edit);
             }
         }
         for (const auto& pair : numbers) {
@@ -445,46 +463,6 @@ void SudokuGrid::highlightConflicts() {
         }
     }
     
-    // Check columns
-    for (int col = 0; col < 9; ++col) {
-        std::map<int, std::vector<QLineEdit*>> numbers;
-        for (int row = 0; row < 9; ++row) {
-            QString text = cells[row][col]->text();
-            if (!text.isEmpty()) {
-                numbers[text.toInt()].push_back(cells[row][col]);
-            }
-        }
-        for (const auto& pair : numbers) {
-            if (pair.second.size() > 1) {
-                for (QLineEdit* cell : pair.second) {
-                    conflictCells.insert(cell);
-                }
-            }
-        }
-    }
-    
-    // Check 3x3 boxes
-    for (int boxRow = 0; boxRow < 9; boxRow += 3) {
-        for (int boxCol = 0; boxCol < 9; boxCol += 3) {
-            std::map<int, std::vector<QLineEdit*>> numbers;
-            for (int i = 0; i < 3; ++i) {
-                for (int j = 0; j < 3; ++j) {
-                    QString text = cells[boxRow + i][boxCol + j]->text();
-                    if (!text.isEmpty()) {
-                        numbers[text.toInt()].push_back(cells[boxRow + i][boxCol + j]);
-                    }
-                }
-            }
-            for (const auto& pair : numbers) {
-                if (pair.second.size() > 1) {
-                    for (QLineEdit* cell : pair.second) {
-                        conflictCells.insert(cell);
-                    }
-                }
-            }
-        }
-    }
-    
     // Highlight all conflict cells
     for (QLineEdit* cell : conflictCells) {
         QString currentStyle = cell->styleSheet();
@@ -578,6 +556,7 @@ void SudokuGrid::setGrid(const std::vector<std::vector<int>>& grid) {
 
 void SudokuGrid::clear() {
     bool wasValid = isValid();
+    hintFinder.reset();
     bool hasGridChanged = false;
     
     for (int i = 0; i < 9; ++i) {
@@ -706,31 +685,55 @@ void SudokuGrid::animateCell(QLineEdit* cell, const QString& color) {
     });
 }
 
-void SudokuGrid::showPossibleValues(int row, int col) {
-    if (!hintsEnabled || !cells[row][col]->text().isEmpty()) return;
+void SudokuGrid::highlightCell(QLineEdit* cell, bool isError) {
+    if (!cell) return;
     
-    std::set<int> used;
+    cell->setStyleSheet(cell->styleSheet() + QString(R"(
+        QLineEdit {
+            background-color: %1;
+            color: white;
+        }
+    )").arg(isError ? "#ff6b6b" : "#0984e3"));
+}
+
+void SudokuGrid::showTraceEvent(const TraceEvent& event) {
+    if (event.type == TraceEventType::Eliminate) return;
     
-    // Check row
-    for (int j = 0; j < 9; ++j) {
-        auto value = getCellValue(row, j);
-        if (value) used.insert(*value);
-    }
+    int row = event.row();
+    int col = event.col();
+    QLineEdit* cell = cells[row][col];
     
-    // Check column
+    // Playback only touches the display; validation and scoring stay quiet
+    QSignalBlocker blocker(cell);
+    styleCell(cell, row, col);
+    if (event.type == TraceEventType::Assign) {
+        cell->setText(QString::number(event.digit));
+        highlightCell(cell, false);
+    } else {
+        cell->clear();
+        highlightCell(cell, true);
+    }
+}
+
+void SudokuGrid::restoreAfterPlayback(const std::vector<std::vector<int>>& values) {
     for (int i = 0; i < 9; ++i) {
-        auto value = getCellValue(i, col);
-        if (value) used.insert(*value);
+        for (int j = 0; j < 9; ++j) {
+            QSignalBlocker blocker(cells[i][j]);
+            cells[i][j]->setText(values[i][j] > 0 ? QString::number(values[i][j]) : "");
+        }
     }
+    clearHighlighting();
+}
+
+void SudokuGrid::showPossibleValues(int row, int col) {
+    if (!hintsEnabled || !cells[row][col]->text().isEmpty()) return;
     
-    // Check 3x3 box
-    int boxRow = (row / 3) * 3;
-    int boxCol = (col / 3) * 3;
-    for (int i = 0; i < 3; ++i) {
-        for (int j = 0; j < 3; ++j) {
-            auto value = getCellValue(boxRow + i, boxCol + j);
-            if (value) used.insert(*value);
-        }
+    std::set<int> used;
+    
+    // Digits already in a unit of the cell
+    for (int peer : units.peers(row * 9 + col)) {
+        auto value = getCellValue(peer / 9, peer % 9);
+        if (value) used.insert(*value);
     }
     
     // Show possible values with subtle highlighting
@@ -843,6 +846,33 @@ bool SudokuGrid::isNotesMode() const {
 void SudokuGrid::showHint() {
     // Get current grid state
     std::vector<std::vector<int>> currentGrid = getGrid();
+    Hint hint = hintFinder.next(boardFromGrid(currentGrid));
+    if (hint) {
+        for (std::uint8_t reason : hint.reasons) {
+            animateCell(cells[reason / 9][reason % 9], "#fdcb6e");
+        }
+        for (const HintElimination& elimination : hint.eliminations) {
+            QLineEdit* cell = cells[elimination.cell / 9][elimination.cell % 9];
+            auto it = notes.find(cell);
+            if (it != notes.end()) {
+                auto& cellNotes = it->second;
+                cellNotes.erase(std::remove_if(cellNotes.begin(), cellNotes.end(),
+                                               [&](int num) { return elimination.digits >> (num - 1) & 1; }),
+                                cellNotes.end());
+                updateCellNotes(cell);
+            }
+            animateCell(cell, "#ff7675");
+        }
+        if (hint.cell >= 0) {
+            QLineEdit* cell = cells[hint.cell / 9][hint.cell % 9];
+            cell->setText(QString::number(hint.digit));
+            animateCell(cell, "#0984e3");
+        }
+        emit hintShown(hint);
+        return;
+    }
+    
+    // Beyond the techniques the finder knows: reveal a cell of the solution
     solver.setGrid(currentGrid);
     
     if (!solver.solve()) {
@@ -872,6 +902,7 @@ void SudokuGrid::showHint() {
     cell->setText(QString::number(solution[row][col]));
     
     animateCell(cell, "#0984e3");
+    emit hintShown(hint);
 }
 
 void SudokuGrid::newGame(const QString& difficulty) {
@@ -879,62 +910,17 @@ void SudokuGrid::newGame(const QString& difficulty) {
     clear();
     notes.clear();
     
-    // Define puzzles for each difficulty
-    const std::map<QString, std::vector<QString>> puzzles = {
-        {"Easy", {
-            "530070000600195000098000060800060003400803001700020006060000280000419005000080079",
-            "170000006000061000004000700060004003080070050500800070007000400000150000200000098",
-            "200080300060070084030500209000105408000000000402706000301007040720040060004010003",
-            "000000657702400100350006000200000740000052000064000008000100503007009204928000000",
-            "020000000000600003074080000000003002080040010600500000000010780500009000000000040",
-            "100007090030020008009600500005300900010080002600004000300000010040000007007000300",
-            "000000012000000003002300400001800005060070800000009000008500000900040500470000090",
-            "000200000000060700700000009800000040010000050040000003200000004003010000000008000",
-            "000000657702400100350006000200000740000052000064000008000100503007009204928000000"
-        }},
-        {"Medium", {
-            "009000400200009000087002090030070502000000000704050060070200140000800007006000800",
-            "020000000000600003074080000000003002080040010600500000000010780500009000000000040",
-            "000000907000420180000705026100904000050000040000507009920108000034059000507000000",
-            "020000000000700003074080000000003002080040010600500000000010780500009000000000040",
-            "300000000970010000600583000200000900040020000000600008006040000090000307000001402",
-            "000090200004000000100308000052007006000000000400100987000605001000000600008070000",
-            "000000000900000084062300050000600200070102030003007000020009140690000007000000000",
-            "000000000079050180800000007007306800450708096003402700700000009016030420000000000",
-            "000000000001900500960001070000700004000030000300005000080200049002008700000000000"
-        }},
-        {"Hard", {
-            "400000805030000000000700000020000060000080400000010000000603070500200000104000000",
-            "520006000000000701300000000000400800600000050000000000041800000000030020008700000",
-            "600000803040700000000000000000504070300200000106000000020000050000080600000010000",
-            "000000000079050180800000007007306800450708096003402700700000009016030420000000000",
-            "000000000001900500960001070000700004000030000300005000080200049002008700000000000",
-            "000000052080000000000700340000900000000080000070000600004600800000000000000000000",
-            "000075400000000008080190000300001060000000034000068170204000603900000401530000000",
-            "300000000000000000000000000000000000000000000000000000000000000000000000000000000",
-            "000000000000000000000000000000000000000000000000000000000000000000000000000000000"
-        }},
-        {"Expert", {
-            "800000000003600000070090200050007000000045700000100030001000068008500010090000400",
-            "000000085000210009960080100500800016000000000890006007009070052300054000480000000",
-            "000200000000060700700000009800000040010000050040000003200000004003010000000008000",
-            "000070100000800005900200000000400800100000002005003000000005009700006000002010000",
-            "000000801700200000000600000000500070010000050060003000000009000000001006803000000",
-            "000000000900000084062300050000600200070102030003007000020009140690000007000000000",
-            "000000000079050180800000007007306800450708096003402700700000009016030420000000000",
-            "000000000001900500960001070000700004000030000300005000080200049002008700000000000",
-            "000000052080000000000700340000900000000080000070000600004600800000000000000000000"
-        }}
-    };
+    // Puzzles for each difficulty
+    const auto& puzzles = gamePuzzles();
     
     // Select a random puzzle for the chosen difficulty
-    auto it = puzzles.find(difficulty);
+    auto it = puzzles.find(difficulty.toStdString());
     if (it != puzzles.end()) {
         int index = static_cast<int>(QRandomGenerator::global()->bounded(static_cast<quint32>(it->second.size())));
-        importFromString(it->second[index]);
+        importFromString(QString::fromStdString(it->second[index]));
     } else {
         // Fallback to an easy puzzle if difficulty not found
-        importFromString(puzzles.at("Easy")[0]);
+        importFromString(QString::fromStdString(puzzles.at("Easy")[0]));
     }
     
     // Save initial state
@@ -0,0 +1,34 @@
+#include "threadpool.h"
+
+ThreadPool::ThreadPool(std::size_t threadCount) {
+    if (threadCount == 0) threadCount = std::thread::hardware_concurrency();
+    if (threadCount == 0) threadCount = 1;
+
+    workers.reserve(threadCount);
+    for (std::size_t i = 0; i < threadCount; ++i)
+        workers.emplace_back([this] { workerLoop(); });
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeup.notify_all();
+    for (std::thread& worker : workers) worker.join();
+}
+
+void ThreadPool::workerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeup.wait(lock, [this] { return stopping || !tasks.empty(); });
+            // Queued work is finished before shutting down
+            if (tasks.empty()) return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
@@ -0,0 +1,32 @@
+#include "transposition.h"
+#include <bit>
+
+TranspositionTable::TranspositionTable(std::size_t entries) {
+    std::size_t count = std::bit_ceil((entries + kBucketSize - 1) / kBucketSize);
+    buckets = std::make_unique<Bucket[]>(count);
+    mask = count - 1;
+    clear();
+}
+
+void TranspositionTable::insert(std::uint64_t hash) {
+    std::uint64_t key = hash | 1;
+    Bucket& bucket = buckets[(key >> 1) & mask];
+    for (auto& slot : bucket.slots) {
+        std::uint64_t stored = slot.load(std::memory_order_relaxed);
+        if (stored == key) return;
+        if (stored == 0) {
+            // Another thread may take the slot first; then this entry is
+            // simply not kept
+            slot.compare_exchange_strong(stored, key, std::memory_order_relaxed);
+            return;
+        }
+    }
+    // Full: the top bits pick a victim, spreading overwrites over the bucket
+    bucket.slots[key >> 62].store(key, std::memory_order_relaxed);
+}
+
+void TranspositionTable::clear() {
+    for (std::size_t i = 0; i <= mask; ++i) {
+        for (auto& slot : buckets[i].slots) slot.store(0, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,117 @@
+#include "unittable.h"
+
+UnitTable::UnitTable() {
+    for (int i = 0; i < 9; ++i) {
+        for (int j = 0; j < 9; ++j) {
+            units[i][j] = static_cast<std::uint8_t>(i * 9 + j);
+            units[9 + i][j] = static_cast<std::uint8_t>(j * 9 + i);
+            units[18 + i][j] = static_cast<std::uint8_t>((i / 3 * 3 + j / 3) * 9 + i % 3 * 3 + j % 3);
+        }
+        kinds[i] = UnitKind::Row;
+        kinds[9 + i] = UnitKind::Column;
+        kinds[18 + i] = UnitKind::Box;
+    }
+    unitCount = 27;
+    rebuild();
+}
+
+const UnitTable& UnitTable::classic() {
+    static const UnitTable table;
+    return table;
+}
+
+bool UnitTable::addDiagonals() {
+    Unit main, anti;
+    for (int i = 0; i < 9; ++i) {
+        main[i] = static_cast<std::uint8_t>(i * 9 + i);
+        anti[i] = static_cast<std::uint8_t>(i * 9 + 8 - i);
+    }
+    UnitTable next = *this;
+    if (!next.addUnit(main, UnitKind::Diagonal) || !next.addUnit(anti, UnitKind::Diagonal)) return false;
+    *this = next;
+    return true;
+}
+
+bool UnitTable::addWindows() {
+    UnitTable next = *this;
+    for (int top : {1, 5}) {
+        for (int left : {1, 5}) {
+            Unit window;
+            for (int j = 0; j < 9; ++j)
+                window[j] = static_cast<std::uint8_t>((top + j / 3) * 9 + left + j % 3);
+            if (!next.addUnit(window, UnitKind::Window)) return false;
+        }
+    }
+    *this = next;
+    return true;
+}
+
+bool UnitTable::setRegions(const std::array<std::uint8_t, 81>& regions) {
+    std::array<int, 9> filled{};
+    UnitTable next = *this;
+    for (int cell = 0; cell < 81; ++cell) {
+        int region = regions[cell];
+        if (region > 8 || filled[region] == 9) return false;
+        next.units[18 + region][filled[region]++] = static_cast<std::uint8_t>(cell);
+    }
+    // 81 cells and no region over 9 leave exactly 9 in each. Regions that
+    // are the boxes keep the table classic.
+    next.irregular = false;
+    for (int region = 0; region < 9; ++region)
+        if (next.units[18 + region] != classic().units[18 + region]) next.irregular = true;
+    if (!next.rebuild()) return false;
+    *this = next;
+    return true;
+}
+
+bool UnitTable::addUnit(const Unit& cells, UnitKind kind) {
+    if (unitCount == kMaxUnits) return false;
+    std::uint64_t seen[2] = {0, 0};
+    for (std::uint8_t cell : cells) {
+        if (cell >= 81 || (seen[cell / 64] >> (cell % 64) & 1)) return false;
+        seen[cell / 64] |= std::uint64_t{1} << (cell % 64);
+    }
+
+    UnitTable next = *this;
+    next.units[unitCount] = cells;
+    next.kinds[unitCount] = kind;
+    next.unitCount++;
+    if (!next.rebuild()) return false;
+    *this = next;
+    return true;
+}
+
+// Derives the per-cell units, masks and peers from the unit list
+bool UnitTable::rebuild() {
+    cellUnits.fill(CellUnits());
+    cellMasks.fill(0);
+    peerCount.fill(0);
+    for (int unit = 0; unit < unitCount; ++unit) {
+        for (std::uint8_t cell : units[unit]) {
+            CellUnits& entry = cellUnits[cell];
+            if (entry.count == kMaxUnitsPerCell) return false;
+            entry.units[entry.count++] = static_cast<std::uint8_t>(unit);
+            cellMasks[cell] |= std::uint64_t{1} << unit;
+        }
+    }
+
+    // Peers in cell order, which keeps the classic table's lists sorted
+    for (int cell = 0; cell < 81; ++cell) {
+        for (int other = 0; other < 81; ++other) {
+            if (other == cell || !(cellMasks[cell] & cellMasks[other])) continue;
+            if (peerCount[cell] == kMaxPeers) return false;
+            cellPeers[cell][peerCount[cell]++] = static_cast<std::uint8_t>(other);
+        }
+    }
+    return true;
+}
+
+bool parseRegions(std::string_view text, std::array<std::uint8_t, 81>& regions) {
+    if (text.size() != 81) return false;
+    for (int cell = 0; cell < 81; ++cell) {
+        char c = text[cell];
+        if (c < '1' || c > '9') return false;
+        regions[cell] = static_cast<std::uint8_t>(c - '1');
+    }
+    return true;
+}
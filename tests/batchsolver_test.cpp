@@ -0,0 +1,43 @@
+// solveBatch() solves like the solver, and its fast path leaves the thread
+// workspace's hash matching its cells, as prepare() would
+#include "batchsolver.h"
+#include "puzzlecorpus.h"
+#include "solver.h"
+#include "testing.h"
+#include "transposition.h"
+#include <string>
+#include <vector>
+
+namespace {
+
+std::uint64_t hashOf(const Board& cells) {
+    std::uint64_t hash = 0;
+    for (int cell = 0; cell < 81; ++cell) {
+        if (cells[cell] != 0) hash ^= kZobrist(cell, cells[cell]);
+    }
+    return hash;
+}
+
+} // namespace
+
+int main() {
+    std::vector<std::string> texts(hardestPuzzles().begin(), hardestPuzzles().end() - 1);
+    texts.push_back(gamePuzzles().at("Easy").front());
+
+    for (const std::string& text : texts) {
+        Board puzzle{};
+        CHECK(parseBoard(text, puzzle));
+        Board expected = puzzle;
+        SudokuSolver solver;
+        CHECK(solver.solve(expected, SudokuSolver::threadWorkspace()));
+
+        // One board at a time, so the workspace is left at its solution
+        Board solution{};
+        CHECK(solveBatch(std::span<const Board>(&puzzle, 1), std::span<Board>(&solution, 1)) == 1);
+        CHECK(solution == expected);
+        const SolverWorkspace& ws = SudokuSolver::threadWorkspace();
+        CHECK(ws.cells == expected);
+        CHECK(ws.hash == hashOf(ws.cells));
+    }
+    return testResult();
+}
@@ -0,0 +1,122 @@
+// canonicalize() prunes its search; this checks it against trying every
+// row/column symmetry, and that equivalent boards share a canonical form
+#include "canonical.h"
+#include "puzzlecorpus.h"
+#include "testing.h"
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Order = std::array<std::uint8_t, 9>;
+
+// Every order of the nine rows (or columns) that keeps bands together
+std::vector<Order> bandOrders() {
+    std::array<int, 3> band{0, 1, 2};
+    std::vector<std::array<int, 3>> perms;
+    do perms.push_back(band);
+    while (std::next_permutation(band.begin(), band.end()));
+
+    std::vector<Order> orders;
+    for (const auto& bands : perms)
+        for (const auto& first : perms)
+            for (const auto& second : perms)
+                for (const auto& third : perms) {
+                    const std::array<int, 3>* within[3] = {&first, &second, &third};
+                    Order order;
+                    for (int i = 0; i < 9; ++i)
+                        order[i] = static_cast<std::uint8_t>(bands[i / 3] * 3 + (*within[i / 3])[i % 3]);
+                    orders.push_back(order);
+                }
+    return orders;
+}
+
+// Smallest board over all 2 * 6^8 transforms, relabelled by first
+// appearance; each candidate is dropped at its first cell above the best
+Board exhaustiveCanonical(const Board& board) {
+    static const std::vector<Order> orders = bandOrders();
+    Board best;
+    best.fill(10);
+    for (int transposed = 0; transposed < 2; ++transposed) {
+        Board source = board;
+        if (transposed)
+            for (int row = 0; row < 9; ++row)
+                for (int col = 0; col < 9; ++col) source[row * 9 + col] = board[col * 9 + row];
+
+        for (const Order& rows : orders) {
+            for (const Order& cols : orders) {
+                std::array<std::uint8_t, 10> relabel{};
+                std::uint8_t next = 1;
+                Board candidate;
+                bool smaller = false;
+                bool dropped = false;
+                for (int cell = 0; cell < 81 && !dropped; ++cell) {
+                    std::uint8_t digit = source[rows[cell / 9] * 9 + cols[cell % 9]];
+                    if (digit != 0 && relabel[digit] == 0) relabel[digit] = next++;
+                    candidate[cell] = relabel[digit];
+                    if (!smaller && candidate[cell] > best[cell]) dropped = true;
+                    if (candidate[cell] < best[cell]) smaller = true;
+                }
+                if (!dropped && smaller) best = candidate;
+            }
+        }
+    }
+    return best;
+}
+
+// A random symmetry, digit relabelling included
+BoardTransform randomTransform(std::mt19937& rng) {
+    static const std::vector<Order> orders = bandOrders();
+    std::uniform_int_distribution<std::size_t> pick(0, orders.size() - 1);
+    BoardTransform transform;
+    transform.transposed = rng() % 2 != 0;
+    transform.rows = orders[pick(rng)];
+    transform.cols = orders[pick(rng)];
+    std::array<std::uint8_t, 9> digits;
+    std::iota(digits.begin(), digits.end(), 1);
+    std::shuffle(digits.begin(), digits.end(), rng);
+    for (int digit = 1; digit <= 9; ++digit) transform.relabel[digit] = digits[digit - 1];
+    return transform;
+}
+
+Board boardOf(const std::string& text) {
+    Board board{};
+    parseBoard(text, board);
+    return board;
+}
+
+} // namespace
+
+int main() {
+    std::vector<Board> boards;
+    for (const auto& [difficulty, puzzles] : gamePuzzles()) boards.push_back(boardOf(puzzles.front()));
+    for (std::size_t i = 0; i < hardestPuzzles().size() && i < 3; ++i) boards.push_back(boardOf(hardestPuzzles()[i]));
+    for (const std::string& text : generatedPuzzles(3, 7)) boards.push_back(boardOf(text));
+    // Sparse and symmetric boards leave the pruning the most ties to settle
+    Board sparse{};
+    sparse[40] = 5;
+    sparse[0] = 1;
+    sparse[80] = 1;
+    boards.push_back(sparse);
+    boards.push_back(Board{});
+
+    std::mt19937 rng(2024);
+    for (const Board& board : boards) {
+        CanonicalBoard canonical = canonicalize(board);
+        CHECK(canonical.board == exhaustiveCanonical(board));
+        CHECK(canonical.transform.apply(board) == canonical.board);
+        CHECK(canonical.transform.invert(canonical.board) == board);
+
+        for (int copy = 0; copy < 8; ++copy) {
+            Board shuffled = randomTransform(rng).apply(board);
+            CanonicalBoard other = canonicalize(shuffled);
+            CHECK(other.board == canonical.board);
+            CHECK(canonicalId(other.board) == canonicalId(canonical.board));
+            CHECK(other.transform.apply(shuffled) == other.board);
+        }
+    }
+    return testResult();
+}
@@ -0,0 +1,103 @@
+// A paused search saved by checkpoint() resumes through restore() to the
+// same solution, and restore() turns down damaged checkpoints
+#include "puzzlecorpus.h"
+#include "solver.h"
+#include "testing.h"
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t kMagicSize = 8;
+constexpr std::size_t kDepthOffset = kMagicSize + kPackedBoardSize;
+constexpr std::size_t kFramesOffset = kDepthOffset + 1;
+
+// Whether restore() turns data down and leaves the workspace as it was
+bool rejected(const std::vector<std::uint8_t>& data) {
+    SudokuSolver solver;
+    SolverWorkspace ws;
+    ws.depth = 7;
+    return !solver.restore(data, ws) && ws.depth == 7;
+}
+
+} // namespace
+
+int main() {
+    // The last of the hardest puzzles is built to keep plain backtracking
+    // busy for seconds, so it is left out
+    std::vector<std::string> puzzles(hardestPuzzles().begin(), hardestPuzzles().end() - 1);
+    for (const auto& [difficulty, texts] : gamePuzzles()) puzzles.push_back(texts.front());
+
+    int resumedCount = 0;
+    for (const std::string& text : puzzles) {
+        Board puzzle{};
+        CHECK(parseBoard(text, puzzle));
+
+        Board expected = puzzle;
+        SudokuSolver reference;
+        SolverWorkspace referenceWs;
+        if (!reference.solve(expected, referenceWs)) continue;  // Some built-in boards have no solution
+
+        SudokuSolver paused;
+        SolverWorkspace pausedWs;
+        CHECK(paused.startSearch(puzzle, pausedWs));
+        if (paused.continueSearch(pausedWs, 20) != SudokuSolver::SearchState::Paused) continue;
+        CHECK(pausedWs.depth > 0);
+        std::vector<std::uint8_t> data = paused.checkpoint(pausedWs);
+
+        // A valid checkpoint resumes, in a fresh solver, to the solution
+        SudokuSolver resumed;
+        SolverWorkspace resumedWs;
+        CHECK(resumed.restore(data, resumedWs));
+        CHECK(resumed.getStats().nodes == paused.getStats().nodes);
+        CHECK(resumed.continueSearch(resumedWs, UINT64_MAX) == SudokuSolver::SearchState::Solved);
+        CHECK(resumedWs.cells == expected);
+        resumedCount++;
+
+        CHECK(rejected({}));
+        CHECK(rejected(std::vector<std::uint8_t>(data.begin(), data.end() - 1)));
+        std::vector<std::uint8_t> longer = data;
+        longer.push_back(0);
+        CHECK(rejected(longer));
+
+        std::vector<std::uint8_t> damaged = data;
+        damaged[0] ^= 0x20;
+        CHECK(rejected(damaged));
+
+        // The depth no longer matches the frames that follow, or is past
+        // the last cell
+        damaged = data;
+        damaged[kDepthOffset]++;
+        CHECK(rejected(damaged));
+        damaged[kDepthOffset] = 82;
+        CHECK(rejected(damaged));
+
+        // A frame on a cell past the grid, or allowing every digit where
+        // the givens rule some out
+        damaged = data;
+        damaged[kFramesOffset] = 81;
+        CHECK(rejected(damaged));
+        damaged = data;
+        damaged[kFramesOffset + 1] = 0xFF;
+        damaged[kFramesOffset + 2] = 0xFF;
+        CHECK(rejected(damaged));
+
+        // Two equal digits in a row
+        Board cells;
+        unpackBoard(&data[kMagicSize], cells);
+        int first = -1;
+        for (int cell = 0; cell < 81; ++cell) {
+            if (cells[cell] == 0) continue;
+            if (first >= 0 && cell / 9 == first / 9) {
+                cells[cell] = cells[first];
+                break;
+            }
+            if (first < 0 || cell / 9 != first / 9) first = cell;
+        }
+        damaged = data;
+        packBoard(cells, &damaged[kMagicSize]);
+        CHECK(rejected(damaged));
+    }
+    CHECK(resumedCount > 0);
+    return testResult();
+}
@@ -0,0 +1,117 @@
+// Solutions streamed to a file as --enumerate does read back, as --decode
+// does, to exactly the solutions of each puzzle, whatever the threads
+#include "enumeration.h"
+#include "puzzlecorpus.h"
+#include "solver.h"
+#include "testing.h"
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr std::uint64_t kMaxSolutions = 1000;
+
+// Every solution of board, in search order
+std::vector<Board> referenceSolutions(const Board& board) {
+    std::vector<Board> solutions;
+    SudokuSolver solver;
+    std::uint64_t count;
+    solver.enumerateSolutions(board, SudokuSolver::threadWorkspace(), [&](const Board& solution) {
+        solutions.push_back(solution);
+        return true;
+    }, count);
+    return solutions;
+}
+
+// A corpus puzzle with clues cleared in cell order until the next would
+// take it past kMaxSolutions solutions
+Board openedUp(const std::string& text) {
+    Board board{};
+    parseBoard(text, board);
+    SudokuSolver solver;
+    for (int cell = 0; cell < 81; ++cell) {
+        if (board[cell] == 0) continue;
+        Board fewer = board;
+        fewer[cell] = 0;
+        std::uint64_t count;
+        solver.countSolutions(fewer, SudokuSolver::threadWorkspace(), count, kMaxSolutions + 1);
+        if (count > kMaxSolutions) break;
+        board = fewer;
+    }
+    return board;
+}
+
+} // namespace
+
+int main() {
+    std::vector<Board> puzzles;
+    for (std::size_t i = 0; i < 3; ++i) puzzles.push_back(openedUp(gamePuzzles().at("Easy")[i]));
+    Board unique{};
+    parseBoard(gamePuzzles().at("Easy").front(), unique);
+    puzzles.push_back(unique);
+    // The first empty cell given a digit that clashes with no clue but is
+    // not the solution's, which leaves none
+    Board solution = unique;
+    SudokuSolver solver;
+    CHECK(solver.solve(solution, SudokuSolver::threadWorkspace()));
+    Board unsolvable = unique;
+    int cell = static_cast<int>(std::find(unique.begin(), unique.end(), 0) - unique.begin());
+    for (int num = 1; num <= 9 && unsolvable[cell] == 0; ++num) {
+        unsolvable[cell] = static_cast<std::uint8_t>(num);
+        if (num == solution[cell] || !solver.prepare(unsolvable, SudokuSolver::threadWorkspace())) unsolvable[cell] = 0;
+    }
+    puzzles.push_back(unsolvable);
+
+    std::vector<std::vector<Board>> expected;
+    for (const Board& puzzle : puzzles) expected.push_back(referenceSolutions(puzzle));
+    CHECK(std::any_of(expected.begin(), expected.end(), [](const auto& solutions) { return solutions.size() > 100; }));
+    CHECK(expected[expected.size() - 2].size() == 1);
+    CHECK(expected.back().empty());
+
+    fs::path path = fs::temp_directory_path() / "sudoku_enumeration_test.sol";
+    for (std::size_t threads : {1, 3}) {
+        {
+            SolutionWriter writer(path.string());
+            CHECK(writer.isOpen());
+            EnumerateOptions options;
+            options.threads = threads;
+            options.blockSize = 64;  // Many blocks, so records rarely share with the one before
+            for (std::size_t i = 0; i < puzzles.size(); ++i) {
+                std::uint64_t count;
+                enumerateSolutions(puzzles[i], options,
+                                   [&](std::span<const std::uint8_t> block) { return writer.write(block); }, count);
+                CHECK(count == expected[i].size());
+                CHECK(writer.endPuzzle());
+            }
+            CHECK(writer.close());
+        }
+
+        std::vector<std::vector<Board>> decoded(puzzles.size());
+        bool inRange = true;
+        CHECK(readSolutionFile(path.string(), [&](std::size_t puzzle, const Board& solution) {
+            if (puzzle < decoded.size()) decoded[puzzle].push_back(solution);
+            else inRange = false;
+        }));
+        CHECK(inRange);
+
+        // One thread keeps the search order; several interleave their blocks
+        for (std::size_t i = 0; i < puzzles.size(); ++i) {
+            if (threads > 1) {
+                std::sort(decoded[i].begin(), decoded[i].end());
+                std::sort(expected[i].begin(), expected[i].end());
+            }
+            CHECK(decoded[i] == expected[i]);
+        }
+    }
+
+    // A file cut short inside a record is turned down; the last three bytes
+    // end the unique puzzle's only record and close the last two puzzles
+    fs::resize_file(path, fs::file_size(path) - 3);
+    CHECK(!readSolutionFile(path.string(), [](std::size_t, const Board&) {}));
+    fs::remove(path);
+    return testResult();
+}
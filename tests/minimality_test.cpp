@@ -0,0 +1,52 @@
+// reduceToMinimal() removes the same clues on any number of threads, and
+// what it leaves is minimal
+#include "minimality.h"
+#include "puzzlecorpus.h"
+#include "testing.h"
+#include "threadpool.h"
+#include <string>
+#include <vector>
+
+int main() {
+    // The easy boards mostly carry clues to spare; the others are sparse
+    // already, and reducing them takes far longer
+    std::vector<std::string> texts = gamePuzzles().at("Easy");
+    texts.push_back(gamePuzzles().at("Expert").front());
+
+    ThreadPool two(2);
+    ThreadPool four(4);
+    int reduced = 0;
+    for (const std::string& text : texts) {
+        Board puzzle{};
+        CHECK(parseBoard(text, puzzle));
+
+        MinimalityOptions options;
+        Board expected{};
+        std::uint64_t expectedSolutions = 0;
+        SolveStatus expectedStatus = reduceToMinimal(puzzle, options, expected, nullptr, &expectedSolutions);
+        for (ThreadPool* pool : {&two, &four}) {
+            MinimalityOptions pooled = options;
+            pooled.pool = pool;
+            Board minimal{};
+            std::uint64_t solutions = 0;
+            CHECK(reduceToMinimal(puzzle, pooled, minimal, nullptr, &solutions) == expectedStatus);
+            CHECK(solutions == expectedSolutions);
+            if (expectedStatus == SolveStatus::Solved) CHECK(minimal == expected);
+        }
+
+        // Some built-in boards have no solution or several
+        if (expectedStatus == SolveStatus::Unsolvable) {
+            CHECK(expectedSolutions != 1);
+            continue;
+        }
+        CHECK(expectedStatus == SolveStatus::Solved);
+        reduced++;
+
+        MinimalityReport report;
+        CHECK(checkMinimality(expected, options, report) == SolveStatus::Solved);
+        CHECK(report.minimal());
+        for (int cell = 0; cell < 81; ++cell) CHECK(expected[cell] == 0 || expected[cell] == puzzle[cell]);
+    }
+    CHECK(reduced > 1);
+    return testResult();
+}
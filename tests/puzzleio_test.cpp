@@ -0,0 +1,60 @@
+// Records written to each collection format read back with their solved
+// grids, as SudokuBatch --output writes them
+#include "puzzlecorpus.h"
+#include "puzzleio.h"
+#include "solver.h"
+#include "testing.h"
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+int main() {
+    // Solved records, then one left as given
+    std::vector<PuzzleRecord> records;
+    for (std::size_t i = 0; i < 3; ++i) {
+        PuzzleRecord record;
+        CHECK(parseBoard(hardestPuzzles()[i], record.puzzle));
+        record.solution = record.puzzle;
+        SudokuSolver solver;
+        CHECK(solver.solve(record.solution, SudokuSolver::threadWorkspace()));
+        record.hasSolution = true;
+        records.push_back(record);
+    }
+    PuzzleRecord unsolved;
+    CHECK(parseBoard(adversarialPuzzles().back(), unsolved.puzzle));
+    records.push_back(unsolved);
+
+    for (const char* extension : {".sdm", ".sdk", ".csv"}) {
+        std::string path = (fs::temp_directory_path() / (std::string("sudoku_puzzleio_test") + extension)).string();
+        PuzzleFormat format = formatFromPath(path);
+        {
+            PuzzleWriter writer(path, format);
+            CHECK(writer.isOpen());
+            for (const PuzzleRecord& record : records) CHECK(writer.write(record));
+            CHECK(writer.close());
+        }
+
+        std::vector<PuzzleRecord> read;
+        std::uint64_t rejected = 0;
+        CHECK(readPuzzleFile(path, format, [&](const PuzzleRecord& record) { read.push_back(record); }, &rejected));
+        CHECK(rejected == 0);
+        CHECK(read.size() == records.size());
+        for (std::size_t i = 0; i < read.size() && i < records.size(); ++i) {
+            const PuzzleRecord& written = records[i];
+            if (format == PuzzleFormat::Csv) {
+                // Both columns survive
+                CHECK(read[i].puzzle == written.puzzle);
+                CHECK(read[i].hasSolution == written.hasSolution);
+                if (written.hasSolution) CHECK(read[i].solution == written.solution);
+            } else {
+                // One grid per record: the solved one when there is one
+                CHECK(read[i].puzzle == (written.hasSolution ? written.solution : written.puzzle));
+                CHECK(!read[i].hasSolution);
+            }
+        }
+        fs::remove(path);
+    }
+    return testResult();
+}
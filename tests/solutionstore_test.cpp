@@ -0,0 +1,115 @@
+// A store reopened after a torn or damaged append drops that record alone:
+// the earlier entries are still found and appends carry on after them
+#include "canonical.h"
+#include "puzzlecorpus.h"
+#include "solutionstore.h"
+#include "testing.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+StoredSolution entryFor(const Board& canonical, std::uint64_t tag) {
+    StoredSolution entry;
+    entry.status = SolveStatus::Solved;
+    entry.solution = canonical;
+    entry.stats.nodes = tag;  // Tells the entries apart on lookup
+    return entry;
+}
+
+bool holds(SolutionStore& store, const Board& canonical, std::uint64_t tag) {
+    StoredSolution entry;
+    return store.lookup(canonical, entry) && entry.stats.nodes == tag && entry.solution == canonical;
+}
+
+// Leaves the store as a crash just after appending the last board to the
+// log would: the index, flushed before that append, does not cover it, or
+// is gone when keepIndex is false. Returns the size of a log record.
+std::uintmax_t fill(const std::string& path, const std::vector<Board>& boards, bool keepIndex) {
+    std::string logPath = path + ".log";
+    std::string indexPath = path + ".idx";
+    SolutionStore store;
+    CHECK(store.open(path));
+    for (std::size_t i = 0; i + 1 < boards.size(); ++i) CHECK(store.append(boards[i], entryFor(boards[i], i)));
+    store.close();
+    std::uintmax_t logSize = fs::file_size(logPath);
+    fs::copy_file(indexPath, indexPath + ".saved", fs::copy_options::overwrite_existing);
+
+    CHECK(store.open(path));
+    CHECK(store.append(boards.back(), entryFor(boards.back(), boards.size() - 1)));
+    store.close();
+    fs::remove(indexPath);
+    if (keepIndex) fs::rename(indexPath + ".saved", indexPath);
+    return fs::file_size(logPath) - logSize;
+}
+
+// Reopens the store after its last append was damaged: only that entry is
+// gone, and appending it again sticks
+void checkRecovered(const std::string& path, const std::vector<Board>& boards) {
+    std::uint64_t last = boards.size() - 1;
+    SolutionStore store;
+    CHECK(store.open(path));
+    CHECK(store.size() == last);
+    for (std::uint64_t i = 0; i < last; ++i) CHECK(holds(store, boards[i], i));
+    StoredSolution entry;
+    CHECK(!store.lookup(boards.back(), entry));
+
+    CHECK(store.append(boards.back(), entryFor(boards.back(), last)));
+    store.close();
+    CHECK(store.open(path));
+    CHECK(store.size() == last + 1);
+    for (std::uint64_t i = 0; i <= last; ++i) CHECK(holds(store, boards[i], i));
+    store.close();
+}
+
+} // namespace
+
+int main() {
+    // Distinct canonical boards, so no append is skipped as a duplicate
+    std::vector<Board> boards;
+    std::vector<std::string> texts = hardestPuzzles();
+    for (const auto& [difficulty, puzzles] : gamePuzzles()) texts.insert(texts.end(), puzzles.begin(), puzzles.end());
+    for (const std::string& text : texts) {
+        Board puzzle{};
+        if (!parseBoard(text, puzzle)) continue;
+        Board canonical = canonicalize(puzzle).board;
+        if (std::find(boards.begin(), boards.end(), canonical) == boards.end()) boards.push_back(canonical);
+    }
+    CHECK(boards.size() > 4);
+
+    fs::path dir = fs::temp_directory_path() / "sudoku_solutionstore_test";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    std::string path = (dir / "store").string();
+    std::string logPath = path + ".log";
+
+    for (bool keepIndex : {true, false}) {
+        // The append was cut off partway through the record
+        std::uintmax_t recordSize = fill(path, boards, keepIndex);
+        fs::resize_file(logPath, fs::file_size(logPath) - recordSize / 2);
+        checkRecovered(path, boards);
+        fs::remove_all(dir);
+        fs::create_directories(dir);
+
+        // The whole record landed, but not as written
+        recordSize = fill(path, boards, keepIndex);
+        {
+            std::fstream log(logPath, std::ios::in | std::ios::out | std::ios::binary);
+            log.seekg(-static_cast<std::streamoff>(recordSize / 2), std::ios::end);
+            char byte = static_cast<char>(log.get() ^ 0x5A);
+            log.seekp(-static_cast<std::streamoff>(recordSize / 2), std::ios::end);
+            log.put(byte);
+        }
+        checkRecovered(path, boards);
+        fs::remove_all(dir);
+        fs::create_directories(dir);
+    }
+
+    fs::remove_all(dir);
+    return testResult();
+}
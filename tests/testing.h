@@ -0,0 +1,19 @@
+#pragma once
+#include <iostream>
+
+// Checks for the test executables: a failed check is reported with its
+// location and makes testResult() non-zero, so main() returns it
+inline int testFailures = 0;
+
+#define CHECK(condition)                                                                   \
+    do {                                                                                   \
+        if (!(condition)) {                                                                \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition "\n"; \
+            testFailures++;                                                                \
+        }                                                                                  \
+    } while (false)
+
+inline int testResult() {
+    if (testFailures > 0) std::cerr << testFailures << " check(s) failed\n";
+    return testFailures > 0 ? 1 : 0;
+}